@@ -64,15 +64,23 @@ procedure BuildSupport is
    OutDir            : Integer := 0;
    Stack_Val         : Integer := 0;
    Timer_Resolution  : Integer := 0;
+   Jobs              : Integer := 0;
+   GUI_Period        : Integer := 0;
+   Stack_Config      : Integer := 0;
    Subs              : Node_id;
    Interface_view    : Integer := 0;
    Concurrency_view  : Integer := 0;
    Data_View         : Integer := 0;
    Generate_glue     : Boolean := false;
    Keep_case         : Boolean := false;
+   Cached_Model      : Boolean := false;
+   Ocarina_Ready     : Boolean := false;
    AADL_Version      : AADL_Version_Type := Ocarina.AADL_V2;
 
    procedure Parse_Command_Line;
+   procedure Set_Ocarina_Path;
+   procedure Initialize_Ocarina;
+   function Load_Model_Cache return Boolean;
    procedure Process_Deployment_View (My_Root : Node_Id);
    --  procedure Process_DataView (My_Root : Node_Id);
    procedure Process_Interface_View (My_System : Node_Id);
@@ -164,6 +172,13 @@ procedure BuildSupport is
                          Ada.Command_Line.Argument (stack_val)'Length);
          end if;
 
+         --  Set the file of the stack budget parameters
+         if Stack_Config > 0 then
+            C_Set_Stack_Config
+              (Ada.Command_Line.Argument (Stack_Config),
+               Ada.Command_Line.Argument (Stack_Config)'Length);
+         end if;
+
          --  Set the timer resolution value
          if Timer_Resolution > 0 then
             C_Set_Timer_Resolution
@@ -171,6 +186,18 @@ procedure BuildSupport is
                Ada.Command_Line.Argument (Timer_Resolution)'Length);
          end if;
 
+         --  Set the number of external tools that can run in parallel
+         if Jobs > 0 then
+            C_Set_Jobs (Ada.Command_Line.Argument (Jobs),
+                        Ada.Command_Line.Argument (Jobs)'Length);
+         end if;
+
+         --  Set the period of the GUI pollers
+         if GUI_Period > 0 then
+            C_Set_GUI_Period (Ada.Command_Line.Argument (GUI_Period),
+                              Ada.Command_Line.Argument (GUI_Period)'Length);
+         end if;
+
          --  Current_function is read from the list of system subcomponents
          Current_function := First_Node (Subcomponents (My_System));
 
@@ -196,6 +223,10 @@ procedure BuildSupport is
                begin
                   C_New_FV (FV_Name_L, FV_Name'Length, FV_Name);
 
+                  --  Location in the model, for the semantic checks
+                  C_Set_FV_Location (Image (Loc (Current_Function)),
+                                     Image (Loc (Current_Function))'Length);
+
                   case Source_Language is
                      when Language_Ada_95        => C_Set_Language_To_Ada;
                      when Language_C             => C_Set_Language_To_C;
@@ -627,6 +658,8 @@ procedure BuildSupport is
                            end loop;
                         end if; -- End processing parameters.
 
+                        C_Set_IF_Location (Image (Loc (If_I)),
+                                           Image (Loc (If_I))'Length);
                         C_End_IF;
                      end if;
 
@@ -1267,6 +1300,10 @@ procedure BuildSupport is
       Previous_DataView : Boolean := False;
       Previous_Stack    : Boolean := False;
       Previous_TimerRes : Boolean := False;
+      Previous_Jobs     : Boolean := False;
+      Previous_GUI_Per  : Boolean := False;
+      Previous_Stack_Cfg : Boolean := False;
+      Previous_Cache    : Boolean := False;
    begin
       for J in 1 .. Ada.Command_Line.Argument_Count loop
          --  Parse the file corresponding to the Jth argument of the
@@ -1296,6 +1333,22 @@ procedure BuildSupport is
             Timer_Resolution := J;
             Previous_TimerRes := false;
 
+         elsif Previous_Jobs then
+            Jobs := J;
+            Previous_Jobs := false;
+
+         elsif Previous_GUI_Per then
+            GUI_Period := J;
+            Previous_GUI_Per := false;
+
+         elsif Previous_Stack_Cfg then
+            Stack_Config := J;
+            Previous_Stack_Cfg := false;
+
+         elsif Previous_Cache then
+            --  Already handled by Load_Model_Cache
+            Previous_Cache := false;
+
          elsif Ada.Command_Line.Argument (J) = "--polyorb-hi-c"
            or else Ada.Command_Line.Argument (J) = "-p"
            or else Ada.Command_Line.Argument (J) = "-polyorb-hi-c"
@@ -1360,12 +1413,60 @@ procedure BuildSupport is
          then
             Previous_Stack := True;
 
+         elsif Ada.Command_Line.Argument (J) = "--stack-config" then
+            Previous_Stack_Cfg := True;
+
          elsif Ada.Command_Line.Argument (J) = "--timer"
            or else Ada.Command_Line.Argument (J) = "-timer"
            or else Ada.Command_Line.Argument (J) = "-x"
          then
             Previous_TimerRes := True;
 
+         elsif Ada.Command_Line.Argument (J) = "--timer-wheel" then
+            C_Set_Timer_Wheel;
+
+         elsif Ada.Command_Line.Argument (J) = "--jobs" then
+            Previous_Jobs := True;
+
+         elsif Ada.Command_Line.Argument (J) = "--cache" then
+            Previous_Cache := True;
+
+         elsif Ada.Command_Line.Argument (J) = "--profile" then
+            C_Set_Profile;
+
+         elsif Ada.Command_Line.Argument (J) = "--binary-msc" then
+            C_Set_Binary_MSC;
+
+         elsif Ada.Command_Line.Argument (J) = "--direct-calls" then
+            C_Set_Direct_Calls;
+
+         elsif Ada.Command_Line.Argument (J) = "--thread-local-buffers" then
+            C_Set_Thread_Local_Buffers;
+
+         elsif Ada.Command_Line.Argument (J) = "--gui-events" then
+            C_Set_GUI_Events;
+
+         elsif Ada.Command_Line.Argument (J) = "--gui-shm" then
+            C_Set_GUI_Shm;
+
+         elsif Ada.Command_Line.Argument (J) = "--fail-unschedulable" then
+            C_Set_Fail_Unschedulable;
+
+         elsif Ada.Command_Line.Argument (J) = "--task-attributes" then
+            C_Set_Task_Attributes;
+
+         elsif Ada.Command_Line.Argument (J) = "--direct-encode" then
+            C_Set_Direct_Encode;
+
+         elsif Ada.Command_Line.Argument (J) = "--check-only" then
+            C_Set_Check_Only;
+
+         elsif Ada.Command_Line.Argument (J) = "--incremental" then
+            C_Set_Incremental;
+
+         elsif Ada.Command_Line.Argument (J) = "--gui-period" then
+            Previous_GUI_Per := True;
+
          elsif Ada.Command_Line.Argument (J) = "--deploymentview"
            or else Ada.Command_Line.Argument (J) = "-c"
          then
@@ -1413,36 +1514,59 @@ procedure BuildSupport is
       end loop;
    end Parse_Command_Line;
 
-   ----------------
-   -- Initialize --
-   ----------------
+   ----------------------
+   -- Load_Model_Cache --
+   ----------------------
 
-   procedure Initialize is
-      FN : Name_Id;
-      B  : Location;
+   --  With --cache, the C AST saved by a previous run with the same command
+   --  line and the same input files is loaded instead of parsing the models
+
+   function Load_Model_Cache return Boolean is
+   begin
+      for J in 1 .. Ada.Command_Line.Argument_Count - 1 loop
+         if Ada.Command_Line.Argument (J) = "--cache" then
+            C_Set_Cache_File (Ada.Command_Line.Argument (J + 1),
+                              Ada.Command_Line.Argument (J + 1)'Length);
+            for K in 1 .. Ada.Command_Line.Argument_Count loop
+               C_Add_Cache_Input (Ada.Command_Line.Argument (K),
+                                  Ada.Command_Line.Argument (K)'Length);
+            end loop;
+            return C_Load_AST_Cache = 1;
+         end if;
+      end loop;
+      return False;
+   end Load_Model_Cache;
+
+   ----------------------
+   -- Set_Ocarina_Path --
+   ----------------------
+
+   procedure Set_Ocarina_Path is
+      S : constant GNAT.OS_Lib.String_Access
+        := GNAT.OS_Lib.Locate_Exec_On_Path ("ocarina");
    begin
       --  Initialization step: we look for ocarina on path to define
       --  OCARINA_PATH env. variable. This will indicate Ocarina librrary
       --  where to find AADL default property sets, and Ocarina specific
       --  packages and property sets.
 
-      declare
-         S : constant GNAT.OS_Lib.String_Access
-           := GNAT.OS_Lib.Locate_Exec_On_Path ("ocarina");
-      begin
-         Exit_On_Error (S = null,
-            "[ERROR] ocarina is not in your PATH");
-         GNAT.OS_Lib.Setenv ("OCARINA_PATH", S.all (S'First .. S'Last - 12));
-      end;
+      Exit_On_Error (S = null,
+         "[ERROR] ocarina is not in your PATH");
+      GNAT.OS_Lib.Setenv ("OCARINA_PATH", S.all (S'First .. S'Last - 12));
+   end Set_Ocarina_Path;
 
-      --  Display the command line syntax
+   ------------------------
+   -- Initialize_Ocarina --
+   ------------------------
 
-      if Ada.Command_Line.Argument_Count = 0 then
-         Usage;
-         OS_Exit (1);
+   --  Done only once in server mode (the children inherit the result)
+
+   procedure Initialize_Ocarina is
+   begin
+      if Ocarina_Ready then
+         return;
       end if;
 
-      C_Init;
       Ocarina.Initialize;
       Ocarina.AADL_Version := AADL_Version;
 
@@ -1450,6 +1574,34 @@ procedure BuildSupport is
 --      Ocarina.FE_AADL.Parser.First_Parsing := True;
       Ocarina.FE_AADL.Parser.Add_Pre_Prop_Sets := True;
       AADL_Language := Get_String_Name ("aadl");
+      Ocarina_Ready := True;
+   end Initialize_Ocarina;
+
+   ----------------
+   -- Initialize --
+   ----------------
+
+   procedure Initialize is
+      FN : Name_Id;
+      B  : Location;
+   begin
+      Set_Ocarina_Path;
+
+      --  Display the command line syntax
+
+      if Ada.Command_Line.Argument_Count = 0 then
+         Usage;
+         OS_Exit (1);
+      end if;
+
+      C_Init;
+
+      Cached_Model := Load_Model_Cache;
+      if Cached_Model then
+         return;
+      end if;
+
+      Initialize_Ocarina;
 
       Parse_Command_Line;
 
@@ -1523,10 +1675,32 @@ procedure BuildSupport is
    pragma Unreferenced (AST);
 
 begin
+   --  Server mode: initialize Ocarina once, then run each request of
+   --  buildsupport-client in a child process (see c/server.c). C_Server
+   --  only returns in the children, with the command line of the client.
+
+   if Ada.Command_Line.Argument_Count = 2
+     and then Ada.Command_Line.Argument (1) = "--server"
+   then
+      Set_Ocarina_Path;
+      Initialize_Ocarina;
+      Exit_On_Error
+        (C_Server (Ada.Command_Line.Argument (2),
+                   Ada.Command_Line.Argument (2)'Length) /= 0,
+         "[ERROR] Could not start the server");
+   end if;
+
    Banner;
 
    Initialize;
 
+   --  The model was loaded from the cache: go directly to the backends
+
+   if Cached_Model then
+      C_End;
+      return;
+   end if;
+
    --  First, we analyze the interface view. For that, we load the
    --  AADL model, analyze it. Under AADLv2 version, the root system
    --  of the interface view is called interfaceview.others.
@@ -70,9 +70,46 @@ package body Buildsupport_Utils is
       Put ("-g, --debug" & HT & HT & HT & HT);
       Put_Line ("Generate runtime debug output");
       Put ("-s, --stack <stack-value>" & HT & HT);
-      Put_Line ("Set the size of the stack per thread in kbytes (default 50)");
+      Put_Line ("Set the size of the stack per thread in kbytes"
+                & " (default: computed)");
+      Put ("--stack-config <file>" & HT & HT & HT);
+      Put_Line ("Overheads and overrides of the computed stack sizes");
       Put ("-x, --timer <timer-resolution in ms>" & HT);
       Put_Line ("Set the timer resolution (default 100 ms)");
+      Put ("--timer-wheel" & HT & HT & HT & HT);
+      Put_Line ("Manage the timers with a timing wheel (O(1) set/reset)");
+      Put ("--jobs <N>" & HT & HT & HT & HT);
+      Put_Line ("Run up to N external tools (asn1.exe...) in parallel");
+      Put ("--cache <file>" & HT & HT & HT & HT);
+      Put_Line ("Reuse the parsed models if the inputs did not change");
+      Put ("--profile" & HT & HT & HT & HT);
+      Put_Line ("Report the time and memory used by each phase");
+      Put ("--binary-msc" & HT & HT & HT & HT);
+      Put_Line ("Trace the RI calls in binary files (see taste-msc-decode)");
+      Put ("--direct-calls" & HT & HT & HT & HT);
+      Put_Line ("Call the C/C++ functions of the same partition directly");
+      Put ("--thread-local-buffers" & HT & HT & HT);
+      Put_Line ("One set of glue buffers per thread (unprotected PIs)");
+      Put ("--gui-events" & HT & HT & HT & HT);
+      Put_Line ("Send each GUI message as an event to the GUI function");
+      Put ("--gui-period <ms>" & HT & HT & HT);
+      Put_Line ("Period of the GUI pollers and receivers (default 40)");
+      Put ("--gui-shm" & HT & HT & HT & HT);
+      Put_Line ("Exchange the GUI messages through shared memory");
+      Put ("--fail-unschedulable" & HT & HT & HT);
+      Put_Line ("Stop if a partition fails the response-time analysis");
+      Put ("--task-attributes" & HT & HT & HT);
+      Put_Line ("Keep the callers of Ada passive functions in task"
+                & " attributes");
+      Put ("--direct-encode" & HT & HT & HT);
+      Put_Line ("Encode the async RIs of threads in the PolyORB-HI-C"
+                & " request");
+      Put ("--check-only" & HT & HT & HT & HT);
+      Put_Line ("Stop after the semantic checks of the model");
+      Put ("--incremental" & HT & HT & HT & HT);
+      Put_Line ("Only regenerate the glue code of modified functions");
+      Put ("--server <socket>" & HT & HT & HT);
+      Put_Line ("Serve the requests of buildsupport-client (alone)");
       Put ("-v, --version" & HT & HT & HT & HT);
       Put_Line ("Display buildsupport version number");
       Put ("-p, --polyorb-hi-c" & HT & HT & HT);
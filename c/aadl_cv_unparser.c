@@ -75,14 +75,9 @@ void AADL_CV_Unparser ()
 
                 FOREACH (interface, Interface, fv->interfaces, {
                     if (RI == interface->direction) {
-                        FV *distant_fv = NULL;
+                        FV *distant_fv = FindFV (interface->distant_fv);
                         char *distant_fv_name = NULL;
 
-                        FOREACH (function, FV, ast->functions, {
-                            if (!strcmp (function->name, interface->distant_fv))
-                                    distant_fv = function;
-                        });
-
                         if (NULL != distant_fv) {
                             distant_fv_name = make_string ("%s%s",
                                     thread_runtime == distant_fv->runtime_nature ? "THREAD_" : "PASSIVE_",
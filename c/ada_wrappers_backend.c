@@ -32,6 +32,30 @@ static FILE *ads = NULL, *adb = NULL, *async_ads = NULL, *async_adb = NULL;
 
 static int contains_sync_interface = 0;
 
+/* The calling stack is needed with POHIAda because the runtime does not
+ * provide any API to determine the current thread of execution.
+ * Mantis ticket 509 is pending on resolution
+ * In the meantime, the calling stack must be generated if the following
+ * two conditions are met:
+ * (1) there is at least one syncrhronous PI in the current FV
+ * (2) in total, there is more than one possible calling thread
+ */
+static bool Needs_Ada_CallingStack(FV *fv)
+{
+    unsigned count_ct      = 0;
+    unsigned count_sync_pi = 0;
+    FOREACH (ct, FV, fv->calling_threads, {
+        (void) ct;
+        count_ct ++;
+    });
+    FOREACH (pi, Interface, fv->interfaces, {
+        if (synch == pi->synchronism) {
+        count_sync_pi ++;
+        }
+    });
+    return 1 < count_ct && 0 < count_sync_pi;
+}
+
 /* Check if an async interface has input or output parameters */
 void CheckForParams(Interface * i, int *result)
 {
@@ -145,7 +169,11 @@ void ada_wrappers_preamble(FV * fv)
 
     fprintf(ads, "\npackage %s_Wrappers is\n\n", fv->name);
     // To debug backdoor-related misuse of the passive functions stack:
-     fprintf(adb, "with PolyORB_HI.Output;\n\n");
+     fprintf(adb, "with PolyORB_HI.Output;\n");
+     if (get_context()->task_attributes && Needs_Ada_CallingStack(fv)) {
+         fprintf(adb, "with Ada.Task_Attributes;\n");
+     }
+     fprintf(adb, "\n");
 
     fprintf(adb, "package body %s_wrappers is\n\n", fv->name);
 
@@ -851,6 +879,77 @@ void Generate_Ada_CallingStack(FV * fv)
     fprintf(adb, "   end callinglist;\n\n");
 }
 
+/*
+ * Alternative to the calling stack (option --task-attributes): each task
+ * stores the id of its calling thread in a task attribute. Push, pop and
+ * get_top_value are O(1) and take no lock. The nesting depth is kept to
+ * detect unbalanced calls; the errors are printed with the -g flag.
+ * Ada.Task_Attributes is not part of the Ravenscar profile: the runtime
+ * must allow it.
+ */
+void Generate_Ada_CallingAttribute(FV * fv)
+{
+    bool debug = get_context()->debug;
+
+    if (NULL == ads || NULL == adb)
+        return;
+
+    fprintf(ads, "   package callinglist is\n");
+    fprintf(ads, "      procedure push (value: integer);\n");
+    fprintf(ads, "      procedure pop;\n");
+    fprintf(ads, "      function get_top_value return integer;\n");
+    fprintf(ads, "   end callinglist;\n\n");
+
+    fprintf(adb, "   package body callinglist is\n");
+    fprintf(adb, "      type t_caller is record\n"
+                 "         value : integer := 0;\n"
+                 "         depth : natural := 0;\n"
+                 "      end record;\n\n"
+                 "      package caller is new Ada.Task_Attributes\n"
+                 "        (Attribute => t_caller,\n"
+                 "         Initial_Value => (value => 0, depth => 0));\n\n");
+
+    fprintf(adb, "      procedure push(value: integer) is\n"
+                 "         current : constant t_caller := caller.Value;\n"
+                 "      begin\n");
+    if (debug) {
+        fprintf(adb, "         if current.depth > 0 and then current.value /= value then\n"
+                     "            PolyORB_HI.Output.Put_Line(\"### STACK ERROR (OVERFLOW), in %s\");\n"
+                     "         end if;\n",
+                     fv->name);
+    }
+    fprintf(adb, "         caller.Set_Value ((value => value, depth => current.depth + 1));\n"
+                 "      end push;\n\n");
+
+    fprintf(adb, "      procedure pop is\n"
+                 "         current : constant t_caller := caller.Value;\n"
+                 "      begin\n"
+                 "         if current.depth = 0 then\n");
+    if (debug) {
+        fprintf(adb, "            PolyORB_HI.Output.Put_Line(\"### STACK ERROR (POP EMPTY STACK) in %s\");\n",
+                     fv->name);
+    }
+    fprintf(adb, "            return;\n"
+                 "         end if;\n"
+                 "         caller.Set_Value ((value => current.value, depth => current.depth - 1));\n"
+                 "      end pop;\n\n");
+
+    fprintf(adb, "      function get_top_value return integer is\n"
+                 "         current : constant t_caller := caller.Value;\n"
+                 "      begin\n"
+                 "         if current.depth = 0 then\n");
+    if (debug) {
+        fprintf(adb, "            PolyORB_HI.Output.Put_Line(\"### STACK ERROR (GET_TOP EMPTY STACK) in %s. Check that your startup/init function does not call any RIs.\");\n",
+                     fv->name);
+    }
+    fprintf(adb, "            return 0;\n"
+                 "         end if;\n"
+                 "         return current.value;\n"
+                 "      end get_top_value;\n\n");
+
+    fprintf(adb, "   end callinglist;\n\n");
+}
+
 /* Function to process one interface of the FV */
 void GLUE_Ada_Wrappers_Interface(Interface * i)
 {
@@ -879,27 +978,13 @@ void GLUE_Ada_Wrappers_Backend(FV * fv)
 
     Init_Ada_Wrappers_Backend(fv);
 
-    /* The calling stack is needed with POHIAda because the runtime does not
-     * provide any API to determine the current thread of execution.
-     * Mantis ticket 509 is pending on resolution
-     * In the meantime, the calling stack must be generated if the following
-     * two conditions are met:
-     * (1) there is at least one syncrhronous PI in the current FV
-     * (2) in total, there is more than one possible calling thread
-     */
-    unsigned count_ct      = 0;
-    unsigned count_sync_pi = 0;
-    FOREACH (ct, FV, fv->calling_threads, {
-        (void) ct;
-        count_ct ++;
-    });
-    FOREACH (pi, Interface, fv->interfaces, {
-        if (synch == pi->synchronism) {
-        count_sync_pi ++;
+    if (Needs_Ada_CallingStack(fv)) {
+        if (get_context()->task_attributes) {
+            Generate_Ada_CallingAttribute(fv);
+        }
+        else {
+            Generate_Ada_CallingStack(fv);
         }
-    });
-    if (1 < count_ct && 0 < count_sync_pi) {
-        Generate_Ada_CallingStack(fv);
     }
 
     /*ForEach(fv->interfaces, GLUE_Ada_Wrappers_Interface);*/
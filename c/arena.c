@@ -0,0 +1,165 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Arena (bump-pointer) allocator used for the nodes and lists of the AST.
+ * The AST is built once and kept until the end of the program: instead of
+ * thousands of small mallocs, the nodes are carved out of large chunks,
+ * which are all freed at once by Free_Arena.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "arena.h"
+
+#define CHUNK_SIZE  (64 * 1024)
+#define MAX_PHASES  8
+#define ALIGNMENT   _Alignof(max_align_t)
+
+typedef struct t_chunk {
+    struct t_chunk  *next;
+    size_t          size;       /* usable bytes after the header */
+    size_t          used;
+} Chunk;
+
+/* Header size, rounded up so that the data of a chunk is aligned */
+#define CHUNK_HEADER \
+    ((sizeof(Chunk) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+typedef struct t_deferred {
+    void                (*free_fn)(void *);
+    void                *data;
+    struct t_deferred   *next;
+} Deferred;
+
+typedef struct {
+    const char  *name;
+    size_t      bytes;
+    size_t      allocations;
+} Phase;
+
+struct t_arena {
+    Chunk       *chunks;        /* current chunk first */
+    Deferred    *deferred;
+    size_t      chunk_count;
+    Phase       phases[MAX_PHASES];
+    int         phase;
+};
+
+Arena *Create_Arena(void)
+{
+    Arena *arena = calloc(1, sizeof(*arena));
+    assert(NULL != arena);
+
+    arena->phases[0].name = "parsing";
+    return arena;
+}
+
+void Free_Arena(Arena *arena)
+{
+    Chunk *next = NULL;
+
+    if (NULL == arena)
+        return;
+
+    for (Deferred *d = arena->deferred; NULL != d; d = d->next) {
+        d->free_fn(d->data);
+    }
+
+    while (NULL != arena->chunks) {
+        next = arena->chunks->next;
+        free(arena->chunks);
+        arena->chunks = next;
+    }
+    free(arena);
+}
+
+static Chunk *new_chunk(Arena *arena, size_t min_size)
+{
+    size_t size = min_size > CHUNK_SIZE ? min_size : CHUNK_SIZE;
+    Chunk *chunk = malloc(CHUNK_HEADER + size);
+
+    assert(NULL != chunk);
+
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->chunk_count++;
+
+    return chunk;
+}
+
+void *Arena_Alloc(Arena *arena, size_t size)
+{
+    Chunk *chunk = NULL;
+    void  *result = NULL;
+
+    assert(NULL != arena);
+
+    /* Keep every allocation aligned */
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    chunk = arena->chunks;
+    if (NULL == chunk || chunk->used + size > chunk->size) {
+        chunk = new_chunk(arena, size);
+    }
+
+    result = (char *) chunk + CHUNK_HEADER + chunk->used;
+    chunk->used += size;
+
+    arena->phases[arena->phase].bytes += size;
+    arena->phases[arena->phase].allocations++;
+
+    /* Same behaviour as the code that used malloc + field initialization */
+    memset(result, 0, size);
+    return result;
+}
+
+void Arena_Defer_Free(Arena *arena, void (*free_fn)(void *), void *data)
+{
+    Deferred *d = Arena_Alloc(arena, sizeof(Deferred));
+
+    d->free_fn = free_fn;
+    d->data = data;
+    d->next = arena->deferred;
+    arena->deferred = d;
+}
+
+void Arena_Phase(Arena *arena, const char *name)
+{
+    if (NULL == arena || arena->phase + 1 >= MAX_PHASES)
+        return;
+
+    arena->phase++;
+    arena->phases[arena->phase].name = name;
+}
+
+void Arena_Report(Arena *arena)
+{
+    size_t bytes = 0, allocations = 0;
+    int    i;
+
+    if (NULL == arena)
+        return;
+
+    for (i = 0; i <= arena->phase; i++) {
+        bytes += arena->phases[i].bytes;
+        allocations += arena->phases[i].allocations;
+    }
+
+    printf("[INFO] AST memory: %zu bytes in %zu allocations (%zu chunks)\n",
+           bytes, allocations, arena->chunk_count);
+
+    for (i = 0; i <= arena->phase; i++) {
+        printf("         %-16s %10zu bytes %8zu allocations\n",
+               arena->phases[i].name,
+               arena->phases[i].bytes,
+               arena->phases[i].allocations);
+    }
+}
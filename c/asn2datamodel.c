@@ -19,6 +19,7 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "tool_jobs.h"
 
 void Print_ASN1_Filename(ASN1_Filename * f)
 {
@@ -91,18 +92,19 @@ void Call_asn2dataModel(FV * fv)
         exit(-1);
     }
 
-    command = make_string("asn2dataModel -o %s -to%s %s/%s",
-                          dataviewpath,
+    /*
+     * The command does not depend on the function: it is run only once
+     * per language and its output is copied in each dataview directory
+     */
+    command = make_string("asn2dataModel -o \"$%s\" -to%s %s/%s",
+                          TOOL_JOB_OUTPUT,
                           LANGUAGE(fv), dataview_path, dataview_uniq);
 
     free(dataview_uniq);
     free(dataview_path);
 
-    if (system(command)) {
-        ERROR
-            ("[ERROR] Check this command line and make sure all files are valid:\n%s\n", command);
-        exit(-1);
-    }
+    Schedule_Tool_Job("asn2dataModel", command, dataviewpath, NULL, true);
+
     free(command);
     free(dataviewpath);
 }
@@ -0,0 +1,790 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Cache of the parsed model (option --cache <file>)
+ *
+ * The orchestrator calls buildsupport several times with the same models.
+ * Parsing and analysing them with Ocarina is the longest part of a run, so
+ * the C AST built from them (functions, interfaces, deployment) can be
+ * saved in a binary file when C_End is called. The next run with the same
+ * command line loads it (with mmap) and goes directly to C_End.
+ *
+ * The cache is used only if its key matches: the key is a hash of the
+ * command line, of the content of all input files, of the current
+ * directory, of the identity (size, date) of the buildsupport binary, and
+ * of OCARINA_PATH and the identity of the Ocarina resource files under it
+ * (the predefined property sets and packages that the parser loads).
+ * Nodes are rebuilt through the usual AST functions (Add_Interface_To_FV,
+ * End_FV...), so that the indexes and the connection graph are the same
+ * as after the parsing.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+#include "ast_cache.h"
+
+/* Change the version when the content of the AST (or of the file) changes */
+static const char cache_magic[8] = "BSCACHE";
+#define CACHE_VERSION 14
+
+static char            *cache_file = NULL;
+static uint64_t        cache_key   = 14695981039346656037ULL;
+static bool            key_started = false;
+static bool            loaded      = false;
+static struct timespec start_time;
+
+/* FNV-1a, as in the symbol tables */
+static void hash_bytes(const void *data, size_t len)
+{
+    const unsigned char *bytes = data;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        cache_key ^= bytes[i];
+        cache_key *= 1099511628211ULL;
+    }
+}
+
+static void hash_u64(uint64_t value)
+{
+    hash_bytes(&value, sizeof value);
+}
+
+/* Time since the first cache call (i.e. before the models are parsed) */
+static uint64_t elapsed_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) (now.tv_sec - start_time.tv_sec) * 1000000ULL
+           + (uint64_t) ((now.tv_nsec - start_time.tv_nsec) / 1000);
+}
+
+/* Hash the names and identity (size, date) of the files of a directory
+ * and of its subdirectories, in alphabetical order */
+static void hash_resources(const char *path)
+{
+    struct dirent **entries = NULL;
+    int           count = scandir(path, &entries, NULL, alphasort);
+
+    for (int k = 0; k < count; k++) {
+        const char  *name = entries[k]->d_name;
+        char        *full = NULL;
+        struct stat st;
+
+        if ('.' != name[0]) {
+            full = make_string("%s/%s", path, name);
+            if (0 == stat(full, &st)) {
+                if (S_ISDIR(st.st_mode)) {
+                    hash_resources(full);
+                }
+                else if (S_ISREG(st.st_mode)) {
+                    hash_bytes(name, strlen(name));
+                    hash_u64((uint64_t) st.st_size);
+                    hash_u64((uint64_t) st.st_mtime);
+                }
+            }
+            free(full);
+        }
+        free(entries[k]);
+    }
+    free(entries);
+}
+
+static void start_key(void)
+{
+    const char  *ocarina_path = getenv("OCARINA_PATH");
+    struct stat st;
+    char        cwd[4096];
+
+    if (key_started) return;
+    key_started = true;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    hash_u64(CACHE_VERSION);
+
+    /* A new version of buildsupport may build a different AST */
+    if (0 == stat("/proc/self/exe", &st)) {
+        hash_u64((uint64_t) st.st_size);
+        hash_u64((uint64_t) st.st_mtime);
+    }
+
+    /* Paths in the command line are relative to the current directory */
+    if (NULL != getcwd(cwd, sizeof cwd)) {
+        hash_bytes(cwd, strlen(cwd));
+    }
+
+    /* Ocarina loads its property sets and packages from OCARINA_PATH (set
+     * from the location of ocarina before the cache is used): a different
+     * installation, or an updated resource file, may change the model */
+    if (NULL != ocarina_path) {
+        char *resources = make_string("%s/share/ocarina", ocarina_path);
+
+        hash_bytes(ocarina_path, strlen(ocarina_path) + 1);
+        hash_resources(resources);
+        free(resources);
+    }
+    else {
+        hash_u64(0);
+    }
+}
+
+void Set_Cache_File(char *name, size_t len)
+{
+    start_key();
+    free(cache_file);
+    cache_file = make_string("%.*s", (int) len, name);
+}
+
+void Add_Cache_Input(char *arg, size_t len)
+{
+    char        *path = make_string("%.*s", (int) len, arg);
+    struct stat st;
+
+    start_key();
+    hash_u64(len);
+    hash_bytes(path, len);
+
+    /* Input file (but not the cache itself): hash its content */
+    if ((NULL == cache_file || strcmp(path, cache_file))
+        && 0 == stat(path, &st) && S_ISREG(st.st_mode)) {
+        FILE          *in = fopen(path, "rb");
+        unsigned char buffer[8192];
+        size_t        n = 0;
+
+        if (NULL != in) {
+            while (0 < (n = fread(buffer, 1, sizeof buffer, in))) {
+                hash_bytes(buffer, n);
+            }
+            fclose(in);
+        }
+    }
+    free(path);
+}
+
+/*
+ * Writer: all values are written as 64-bit integers in the native byte
+ * order (the cache is local to the machine); strings as their length + 1
+ * (0 for NULL) followed by the characters.
+ */
+static void put_u64(FILE *f, uint64_t value)
+{
+    fwrite(&value, sizeof value, 1, f);
+}
+
+static void put_str(FILE *f, const char *s)
+{
+    if (NULL == s) {
+        put_u64(f, 0);
+    }
+    else {
+        size_t len = strlen(s);
+        put_u64(f, (uint64_t) len + 1);
+        fwrite(s, 1, len, f);
+    }
+}
+
+#define PUT_COUNT(f, type, list) \
+{\
+uint64_t n_items = 0;\
+FOREACH(counted, type, list, { (void) counted; n_items++; });\
+put_u64(f, n_items);\
+}
+
+static void save_parameters(FILE *f, Parameter_list *params)
+{
+    PUT_COUNT(f, Parameter, params);
+    FOREACH(p, Parameter, params, {
+        put_str(f, p->name);
+        put_str(f, p->type);
+        put_str(f, p->asn1_module);
+        put_u64(f, (uint64_t) p->basic_type);
+        put_str(f, p->asn1_filename);
+        put_u64(f, (uint64_t) p->encoding);
+        put_u64(f, (uint64_t) p->param_direction);
+    });
+}
+
+static void save_interface(FILE *f, Interface *i)
+{
+    put_str(f, i->name);
+    put_str(f, i->port_name);
+    put_u64(f, (uint64_t) i->direction);
+    put_u64(f, (uint64_t) i->synchronism);
+    put_u64(f, (uint64_t) i->rcm);
+    put_u64(f, (uint64_t) i->period);
+    put_u64(f, i->wcet_low);
+    put_str(f, i->wcet_low_unit);
+    put_u64(f, i->wcet_high);
+    put_str(f, i->wcet_high_unit);
+    put_str(f, i->distant_fv);
+    put_str(f, i->distant_name);
+    put_u64(f, i->queue_size);
+    put_u64(f, i->ignore_params);
+    put_str(f, i->distant_qgen->fv_name);
+    put_u64(f, (uint64_t) i->distant_qgen->language);
+    put_str(f, i->distant_qgen->qgen_init);
+    put_str(f, i->location);
+    save_parameters(f, i->in);
+    save_parameters(f, i->out);
+}
+
+static void save_function(FILE *f, FV *fv)
+{
+    put_str(f, fv->name);
+    put_str(f, fv->nameWithCase);
+    put_str(f, fv->zipfile);
+    put_str(f, fv->original_name);
+    put_str(f, fv->instance_of);
+    put_u64(f, (uint64_t) fv->language);
+    put_u64(f, fv->artificial);
+    put_u64(f, fv->timer);
+    put_u64(f, fv->is_component_type);
+    put_str(f, fv->location);
+
+    PUT_COUNT(f, Context_Parameter, fv->context_parameters);
+    FOREACH(cp, Context_Parameter, fv->context_parameters, {
+        put_str(f, cp->name);
+        put_str(f, cp->fullNameWithCase);
+        put_str(f, cp->value);
+        put_str(f, cp->type.name);
+        put_str(f, cp->type.module);
+        put_str(f, cp->type.asn1_filename);
+        put_u64(f, (uint64_t) cp->type.basic_type);
+    });
+
+    PUT_COUNT(f, Interface, fv->interfaces);
+    FOREACH(i, Interface, fv->interfaces, {
+        save_interface(f, i);
+    });
+}
+
+static void save_context(FILE *f, Context *ctx)
+{
+    put_str(f, ctx->output);
+    put_str(f, ctx->ifview);
+    put_str(f, ctx->dataview);
+    put_str(f, ctx->stacksize);
+    put_str(f, ctx->stack_config);
+    put_u64(f, (uint64_t) ctx->glue);
+    put_u64(f, ctx->smp2);
+    put_u64(f, (uint64_t) ctx->gw);
+    put_u64(f, (uint64_t) ctx->keep_case);
+    put_u64(f, (uint64_t) ctx->onlycv);
+    put_u64(f, (uint64_t) ctx->aadlv2);
+    put_u64(f, (uint64_t) ctx->debug);
+    put_u64(f, (uint64_t) ctx->test);
+    put_u64(f, ctx->future);
+    put_u64(f, (uint64_t) ctx->polyorb_hi_c);
+    put_u64(f, ctx->needs_basictypes);
+    put_u64(f, (uint64_t) ctx->timer_resolution);
+    put_u64(f, ctx->timer_wheel);
+    put_u64(f, (uint64_t) ctx->jobs);
+    put_u64(f, ctx->profile);
+    put_u64(f, ctx->binary_msc);
+    put_u64(f, ctx->direct_calls);
+    put_u64(f, ctx->thread_local_buffers);
+    put_u64(f, ctx->gui_events);
+    put_u64(f, (uint64_t) ctx->gui_period);
+    put_u64(f, ctx->gui_shm);
+    put_u64(f, ctx->fail_unschedulable);
+    put_u64(f, ctx->task_attributes);
+    put_u64(f, ctx->direct_encode);
+    put_u64(f, ctx->check_only);
+    put_u64(f, ctx->incremental);
+}
+
+static void save_system(FILE *f, System *s)
+{
+    Processor **cpus = NULL;
+    size_t    cpu_count = 0, j;
+
+    put_str(f, s->name);
+    save_context(f, s->context);
+
+    PUT_COUNT(f, FV, s->functions);
+    FOREACH(fv, FV, s->functions, {
+        save_function(f, fv);
+    });
+
+    /* Processors can be shared by several processes */
+    FOREACH(p, Process, s->processes, {
+        bool known = (NULL == p->cpu);
+        for (j = 0; j < cpu_count; j++) {
+            if (cpus[j] == p->cpu) known = true;
+        }
+        if (!known) {
+            cpus = realloc(cpus, (cpu_count + 1) * sizeof(Processor *));
+            assert(NULL != cpus);
+            cpus[cpu_count++] = p->cpu;
+        }
+    });
+    put_u64(f, cpu_count);
+    for (j = 0; j < cpu_count; j++) {
+        put_str(f, cpus[j]->name);
+        put_str(f, cpus[j]->classifier);
+        put_str(f, cpus[j]->platform_name);
+        put_str(f, cpus[j]->envvars);
+        put_str(f, cpus[j]->user_cflags);
+        put_str(f, cpus[j]->user_ldflags);
+    }
+
+    PUT_COUNT(f, Process, s->processes);
+    FOREACH(p, Process, s->processes, {
+        uint64_t cpu_ref = 0;   /* index + 1, 0 if no processor */
+        for (j = 0; j < cpu_count; j++) {
+            if (cpus[j] == p->cpu) cpu_ref = j + 1;
+        }
+        put_str(f, p->name);
+        put_str(f, p->identifier);
+        put_str(f, p->processor_board_name);
+        put_u64(f, cpu_ref);
+        put_u64(f, p->connections);
+        put_u64(f, p->coverage);
+
+        PUT_COUNT(f, Aplc_binding, p->bindings);
+        FOREACH(b, Aplc_binding, p->bindings, {
+            put_u64(f, b->fv->position);
+        });
+
+        PUT_COUNT(f, Device, p->drivers);
+        FOREACH(d, Device, p->drivers, {
+            put_str(f, d->name);
+            put_str(f, d->classifier);
+            put_str(f, d->associated_processor);
+            put_str(f, d->configuration);
+            put_str(f, d->asn1_filename);
+            put_str(f, d->asn1_typename);
+            put_str(f, d->asn1_modulename);
+            put_str(f, d->accessed_bus);
+            put_str(f, d->access_port);
+        });
+    });
+    free(cpus);
+
+    PUT_COUNT(f, Bus, s->buses);
+    FOREACH(b, Bus, s->buses, {
+        put_str(f, b->name);
+        put_str(f, b->classifier);
+    });
+
+    PUT_COUNT(f, Package, s->packages);
+    FOREACH(pkg, Package, s->packages, {
+        put_str(f, pkg);
+    });
+
+    PUT_COUNT(f, Connection, s->connections);
+    FOREACH(cnt, Connection, s->connections, {
+        put_str(f, cnt->src_system);
+        put_str(f, cnt->src_port);
+        put_str(f, cnt->bus);
+        put_str(f, cnt->dst_system);
+        put_str(f, cnt->dst_port);
+    });
+}
+
+void Save_AST_Cache(void)
+{
+    FILE     *f = NULL;
+    char     *tmp = NULL;
+    uint64_t parse_us = 0;
+
+    if (NULL == cache_file || loaded) return;
+
+    parse_us = elapsed_us();
+
+    /* Write in a temporary file: concurrent runs never see partial data */
+    tmp = make_string("%s.%ld.tmp", cache_file, (long) getpid());
+    f = fopen(tmp, "wb");
+    if (NULL == f) {
+        ERROR("[WARNING] Could not create the cache file %s\n", cache_file);
+        free(tmp);
+        return;
+    }
+
+    fwrite(cache_magic, 1, sizeof cache_magic, f);
+    put_u64(f, CACHE_VERSION);
+    put_u64(f, cache_key);
+    put_u64(f, parse_us);
+    save_system(f, get_system_ast());
+
+    if (0 != fclose(f) || 0 != rename(tmp, cache_file)) {
+        ERROR("[WARNING] Could not write the cache file %s\n", cache_file);
+        remove(tmp);
+    }
+    free(tmp);
+}
+
+/* Reader: on a truncated file, ok is set to false and zeros are returned */
+typedef struct {
+    const unsigned char *pos;
+    const unsigned char *end;
+    bool                ok;
+} Reader;
+
+static uint64_t get_u64(Reader *r)
+{
+    uint64_t value = 0;
+
+    if (!r->ok || (size_t) (r->end - r->pos) < sizeof value) {
+        r->ok = false;
+        return 0;
+    }
+    memcpy(&value, r->pos, sizeof value);
+    r->pos += sizeof value;
+    return value;
+}
+
+static char *get_str(Reader *r)
+{
+    uint64_t len = get_u64(r);
+    char     *s = NULL;
+
+    if (0 == len) return NULL;
+    len --;
+    if (!r->ok || (uint64_t) (r->end - r->pos) < len) {
+        r->ok = false;
+        return NULL;
+    }
+    s = malloc((size_t) len + 1);
+    assert(NULL != s);
+    memcpy(s, r->pos, (size_t) len);
+    s[len] = '\0';
+    r->pos += len;
+    return s;
+}
+
+static Parameter_list *load_parameters(Reader *r, Interface *i)
+{
+    Parameter_list *params = NULL;
+    uint64_t       count = get_u64(r);
+
+    while (r->ok && count-- > 0) {
+        Parameter *p = NULL;
+        Create_Parameter(&p);
+        p->name            = get_str(r);
+        p->type            = get_str(r);
+        p->asn1_module     = get_str(r);
+        p->basic_type      = (ASN1_basic_type) get_u64(r);
+        p->asn1_filename   = get_str(r);
+        p->encoding        = (Encoding) get_u64(r);
+        p->param_direction = (Param_kind) get_u64(r);
+        p->interface       = i;
+        APPEND_TO_LIST(Parameter, params, p);
+    }
+    return params;
+}
+
+static void load_interface(Reader *r, FV *fv)
+{
+    Interface *i = NULL;
+
+    Create_Interface(&i);
+    i->name                    = get_str(r);
+    i->port_name               = get_str(r);
+    i->direction               = (IF_type) get_u64(r);
+    i->synchronism             = (IF_kind) get_u64(r);
+    i->rcm                     = (RCM) get_u64(r);
+    i->period                  = (long long) get_u64(r);
+    i->wcet_low                = get_u64(r);
+    i->wcet_low_unit           = get_str(r);
+    i->wcet_high               = get_u64(r);
+    i->wcet_high_unit          = get_str(r);
+    i->distant_fv              = get_str(r);
+    i->distant_name            = get_str(r);
+    i->queue_size              = get_u64(r);
+    i->ignore_params           = 0 != get_u64(r);
+    i->distant_qgen->fv_name   = get_str(r);
+    i->distant_qgen->language  = (Language) get_u64(r);
+    i->distant_qgen->qgen_init = get_str(r);
+    i->location                = get_str(r);
+    i->in                      = load_parameters(r, i);
+    i->out                     = load_parameters(r, i);
+    i->parent_fv               = fv;
+
+    Add_Interface_To_FV(fv, i);
+}
+
+static void load_function(Reader *r)
+{
+    FV       *fv = NULL;
+    uint64_t count = 0;
+
+    Create_FV(&fv);
+    fv->name              = get_str(r);
+    fv->nameWithCase      = get_str(r);
+    fv->zipfile           = get_str(r);
+    fv->original_name     = get_str(r);
+    fv->instance_of       = get_str(r);
+    fv->language          = (Language) get_u64(r);
+    fv->artificial        = 0 != get_u64(r);
+    fv->timer             = 0 != get_u64(r);
+    fv->is_component_type = 0 != get_u64(r);
+    fv->location          = get_str(r);
+
+    count = get_u64(r);
+    while (r->ok && count-- > 0) {
+        Context_Parameter *cp = NULL;
+        Create_Context_Parameter(&cp);
+        cp->name               = get_str(r);
+        cp->fullNameWithCase   = get_str(r);
+        cp->value              = get_str(r);
+        cp->type.name          = get_str(r);
+        cp->type.module        = get_str(r);
+        cp->type.asn1_filename = get_str(r);
+        cp->type.basic_type    = (ASN1_basic_type) get_u64(r);
+        APPEND_TO_LIST(Context_Parameter, fv->context_parameters, cp);
+    }
+
+    count = get_u64(r);
+    while (r->ok && count-- > 0) {
+        load_interface(r, fv);
+    }
+
+    /* Same as at the end of the parsing of a function (timers, indexes) */
+    Set_Current_FV(fv);
+    End_FV();
+}
+
+static void load_context(Reader *r, Context *ctx)
+{
+    free(ctx->output);
+    free(ctx->ifview);
+    free(ctx->dataview);
+    free(ctx->stacksize);
+    free(ctx->stack_config);
+
+    ctx->output           = get_str(r);
+    ctx->ifview           = get_str(r);
+    ctx->dataview         = get_str(r);
+    ctx->stacksize        = get_str(r);
+    ctx->stack_config     = get_str(r);
+    ctx->glue             = (int) get_u64(r);
+    ctx->smp2             = 0 != get_u64(r);
+    ctx->gw               = (int) get_u64(r);
+    ctx->keep_case        = (int) get_u64(r);
+    ctx->onlycv           = (int) get_u64(r);
+    ctx->aadlv2           = (int) get_u64(r);
+    ctx->debug            = (int) get_u64(r);
+    ctx->test             = (int) get_u64(r);
+    ctx->future           = 0 != get_u64(r);
+    ctx->polyorb_hi_c     = (int) get_u64(r);
+    ctx->needs_basictypes = 0 != get_u64(r);
+    ctx->timer_resolution = (int) get_u64(r);
+    ctx->timer_wheel      = 0 != get_u64(r);
+    ctx->jobs             = (int) get_u64(r);
+    ctx->profile          = 0 != get_u64(r);
+    ctx->binary_msc       = 0 != get_u64(r);
+    ctx->direct_calls     = 0 != get_u64(r);
+    ctx->thread_local_buffers = 0 != get_u64(r);
+    ctx->gui_events       = 0 != get_u64(r);
+    ctx->gui_period       = (int) get_u64(r);
+    ctx->gui_shm          = 0 != get_u64(r);
+    ctx->fail_unschedulable = 0 != get_u64(r);
+    ctx->task_attributes  = 0 != get_u64(r);
+    ctx->direct_encode    = 0 != get_u64(r);
+    ctx->check_only       = 0 != get_u64(r);
+    ctx->incremental      = 0 != get_u64(r);
+}
+
+static void load_system(Reader *r, System *s)
+{
+    FV        **functions = NULL;
+    Processor **cpus = NULL;
+    uint64_t  fv_count = 0, cpu_count = 0, count = 0, j;
+
+    free(s->name);
+    s->name = get_str(r);
+    load_context(r, s->context);
+
+    fv_count = get_u64(r);
+    for (j = 0; r->ok && j < fv_count; j++) {
+        load_function(r);
+    }
+
+    /* Bindings refer to functions by position */
+    functions = calloc((size_t) fv_count + 1, sizeof(FV *));
+    assert(NULL != functions);
+    j = 0;
+    FOREACH(fv, FV, s->functions, {
+        if (j < fv_count) functions[j++] = fv;
+    });
+
+    cpu_count = get_u64(r);
+    cpus = calloc((size_t) cpu_count + 1, sizeof(Processor *));
+    assert(NULL != cpus);
+    for (j = 0; r->ok && j < cpu_count; j++) {
+        Create_Processor(&cpus[j]);
+        cpus[j]->name          = get_str(r);
+        cpus[j]->classifier    = get_str(r);
+        cpus[j]->platform_name = get_str(r);
+        cpus[j]->envvars       = get_str(r);
+        cpus[j]->user_cflags   = get_str(r);
+        cpus[j]->user_ldflags  = get_str(r);
+    }
+
+    count = get_u64(r);
+    while (r->ok && count-- > 0) {
+        Process  *p = NULL;
+        uint64_t cpu_ref = 0, n = 0;
+
+        Create_Process(&p);
+        p->name                 = get_str(r);
+        p->identifier           = get_str(r);
+        p->processor_board_name = get_str(r);
+        cpu_ref                 = get_u64(r);
+        p->connections          = (unsigned int) get_u64(r);
+        p->coverage             = 0 != get_u64(r);
+        if (0 < cpu_ref && cpu_ref <= cpu_count) {
+            p->cpu = cpus[cpu_ref - 1];
+        }
+
+        n = get_u64(r);
+        while (r->ok && n-- > 0) {
+            uint64_t     position = get_u64(r);
+            Aplc_binding *b = NULL;
+
+            if (position >= fv_count) {
+                r->ok = false;
+                break;
+            }
+            Create_Aplc_binding(&b);
+            b->fv = functions[position];
+            b->fv->process = p;
+            APPEND_TO_LIST(Aplc_binding, p->bindings, b);
+        }
+
+        n = get_u64(r);
+        while (r->ok && n-- > 0) {
+            Device *d = NULL;
+            Create_Device(&d);
+            d->name                 = get_str(r);
+            d->classifier           = get_str(r);
+            d->associated_processor = get_str(r);
+            d->configuration        = get_str(r);
+            d->asn1_filename        = get_str(r);
+            d->asn1_typename        = get_str(r);
+            d->asn1_modulename      = get_str(r);
+            d->accessed_bus         = get_str(r);
+            d->access_port          = get_str(r);
+            APPEND_TO_LIST(Device, p->drivers, d);
+        }
+        APPEND_TO_LIST(Process, s->processes, p);
+    }
+    free(functions);
+    free(cpus);
+
+    count = get_u64(r);
+    while (r->ok && count-- > 0) {
+        Bus *b = NULL;
+        Create_Bus(&b);
+        b->name       = get_str(r);
+        b->classifier = get_str(r);
+        APPEND_TO_LIST(Bus, s->buses, b);
+    }
+
+    count = get_u64(r);
+    while (r->ok && count-- > 0) {
+        Package *pkg = get_str(r);
+        if (NULL != pkg) ADD_TO_SET(Package, s->packages, pkg);
+    }
+
+    count = get_u64(r);
+    while (r->ok && count-- > 0) {
+        Connection *cnt = NULL;
+        Create_Connection(&cnt);
+        cnt->src_system = get_str(r);
+        cnt->src_port   = get_str(r);
+        cnt->bus        = get_str(r);
+        cnt->dst_system = get_str(r);
+        cnt->dst_port   = get_str(r);
+        APPEND_TO_LIST(Connection, s->connections, cnt);
+    }
+}
+
+int Load_AST_Cache(void)
+{
+    int         fd = -1;
+    struct stat st;
+    void        *map = NULL;
+    Reader      r;
+    uint64_t    parse_us = 0, load_us = 0;
+    size_t      header = sizeof cache_magic + 3 * sizeof(uint64_t);
+    System      *s = get_system_ast();
+
+    if (NULL == cache_file) return 0;
+
+    fd = open(cache_file, O_RDONLY);
+    if (-1 == fd) return 0;
+
+    if (0 != fstat(fd, &st) || (size_t) st.st_size < header) {
+        close(fd);
+        return 0;
+    }
+
+    map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) return 0;
+
+    r.pos = map;
+    r.end = r.pos + st.st_size;
+    r.ok  = true;
+
+    /* Check that the cache was built from the same inputs */
+    if (memcmp(r.pos, cache_magic, sizeof cache_magic)) {
+        munmap(map, (size_t) st.st_size);
+        return 0;
+    }
+    r.pos += sizeof cache_magic;
+    if (CACHE_VERSION != get_u64(&r) || cache_key != get_u64(&r)) {
+        munmap(map, (size_t) st.st_size);
+        return 0;
+    }
+    parse_us = get_u64(&r);
+
+    load_system(&r, s);
+    munmap(map, (size_t) st.st_size);
+
+    /* The AST was modified: it is too late to parse the models instead */
+    if (!r.ok || r.pos != r.end) {
+        ERROR("[ERROR] The cache file %s is corrupted. Remove it.\n",
+              cache_file);
+        exit(-1);
+    }
+    loaded = true;
+
+    /* Set_OutDir is not called: create the output directory */
+    if (NULL != s->context->output) {
+        mkdir(s->context->output, 0700);
+    }
+
+    load_us = elapsed_us();
+    INFO("[INFO] Model loaded from %s in %.1f ms instead of %.1f ms "
+         "(%.1f ms saved)\n",
+         cache_file,
+         (double) load_us / 1000.0,
+         (double) parse_us / 1000.0,
+         ((double) parse_us - (double) load_us) / 1000.0);
+
+    return 1;
+}
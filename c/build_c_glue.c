@@ -18,13 +18,270 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "text_builder.h"
 
-static FILE *vm_if     = NULL,
-            *invoke_ri = NULL,
-            *vm_if_h   = NULL;
+static Text_Builder *vm_if     = NULL,
+                    *invoke_ri = NULL,
+                    *vm_if_h   = NULL;
 
 static int count_calling_threads = 0;
 
+/* Runtime of the binary MSC tracer (option --binary-msc), written in the
+ * directory of each function as msc_trace.h */
+static const char *msc_trace_runtime[] = {
+    "/*\n"
+    " * Binary MSC tracer (buildsupport option --binary-msc)\n"
+    " *\n"
+    " * When TASTE_INNER_MSC is set, each RI call writes a 64-byte record in a\n"
+    " * ring buffer owned by the calling thread. The rings are memory-mapped\n"
+    " * files named msc_<pid>_<thread>.bin, in $TASTE_MSC_DIR (default: the\n"
+    " * current directory): they survive a crash, and are decoded offline with\n"
+    " * taste-msc-decode using the file msc_trace_ids.txt generated by\n"
+    " * buildsupport. Set TASTE_MSC_PAYLOAD to keep the first bytes of the\n"
+    " * encoded parameters in the records.\n"
+    " * Each ring is written by a single thread, without lock: the header gives\n"
+    " * the number of records written so far (the last ones are kept).\n"
+    " */\n"
+    "#ifndef MSC_TRACE_H\n"
+    "#define MSC_TRACE_H\n"
+    "\n"
+    "#ifdef __unix__\n"
+    "\n"
+    "#include <stdint.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <stdio.h>\n"
+    "#include <string.h>\n"
+    "#include <time.h>\n"
+    "#include <fcntl.h>\n"
+    "#include <unistd.h>\n"
+    "#include <sys/mman.h>\n"
+    "\n"
+    "#define MSC_TRACE_RECORDS 65536    /* per thread, power of two */\n"
+    "#define MSC_TRACE_PAYLOAD 40\n"
+    "\n"
+    "typedef struct {\n"
+    "    uint64_t timestamp;            /* ns since the creation of the ring */\n"
+    "    uint16_t sender;\n"
+    "    uint16_t receiver;\n"
+    "    uint16_t interface;\n"
+    "    uint16_t flags;                /* reserved */\n"
+    "    uint32_t length;               /* size of the encoded parameters */\n"
+    "    uint32_t payload_length;       /* bytes of the first one kept */\n"
+    "    uint8_t  payload[MSC_TRACE_PAYLOAD];\n"
+    "} msc_trace_record;\n"
+    "\n"
+    "typedef struct {\n"
+    "    char     magic[8];             /* \"TASTEMSC\" */\n"
+    "    uint32_t record_size;\n"
+    "    uint32_t capacity;\n"
+    "    uint64_t start_realtime;       /* ns since the epoch */\n"
+    "    uint64_t start_monotonic;      /* ns */\n"
+    "    uint64_t head;                 /* number of records written */\n"
+    "    uint8_t  reserved[24];\n"
+    "} msc_trace_ring;\n"
+    "\n"
+    "__attribute__((weak)) int msc_trace_enabled = -1;\n"
+    "__attribute__((weak)) int msc_trace_payload = 0;\n"
+    "__attribute__((weak)) int msc_trace_threads = 0;\n"
+    "__attribute__((weak)) __thread msc_trace_ring *msc_trace_thread_ring = NULL;\n"
+    "\n"
+    "static inline uint64_t msc_trace_clock(clockid_t clock)\n"
+    "{\n"
+    "    struct timespec ts;\n"
+    "\n"
+    "    clock_gettime(clock, &ts);\n"
+    "    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;\n"
+    "}\n"
+    "\n",
+
+    "/* Slow path: first traced call of a thread */\n"
+    "__attribute__((weak)) msc_trace_ring *msc_trace_open(void)\n"
+    "{\n"
+    "    size_t          size = sizeof(msc_trace_ring)\n"
+    "                           + MSC_TRACE_RECORDS * sizeof(msc_trace_record);\n"
+    "    const char      *dir = getenv(\"TASTE_MSC_DIR\");\n"
+    "    char            filename[4096];\n"
+    "    msc_trace_ring  *ring = NULL;\n"
+    "    int             fd;\n"
+    "\n"
+    "    if (-1 == msc_trace_enabled) {\n"
+    "        msc_trace_payload = (NULL != getenv(\"TASTE_MSC_PAYLOAD\"));\n"
+    "        msc_trace_enabled = (NULL != getenv(\"TASTE_INNER_MSC\"));\n"
+    "    }\n"
+    "    if (0 == msc_trace_enabled) return NULL;\n"
+    "\n"
+    "    snprintf(filename, sizeof filename, \"%s/msc_%ld_%d.bin\",\n"
+    "             NULL != dir ? dir : \".\", (long) getpid(),\n"
+    "             __atomic_fetch_add(&msc_trace_threads, 1, __ATOMIC_RELAXED));\n"
+    "\n"
+    "    fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);\n"
+    "    if (-1 == fd || 0 != ftruncate(fd, (off_t) size)\n"
+    "        || MAP_FAILED == (ring = mmap(NULL, size, PROT_READ | PROT_WRITE,\n"
+    "                                      MAP_SHARED, fd, 0))) {\n"
+    "        printf(\"[ERROR] Could not create MSC trace file %s\\n\", filename);\n"
+    "        msc_trace_enabled = 0;\n"
+    "        ring = NULL;\n"
+    "    }\n"
+    "    else {\n"
+    "        memcpy(ring->magic, \"TASTEMSC\", 8);\n"
+    "        ring->record_size     = sizeof(msc_trace_record);\n"
+    "        ring->capacity        = MSC_TRACE_RECORDS;\n"
+    "        ring->start_realtime  = msc_trace_clock(CLOCK_REALTIME);\n"
+    "        ring->start_monotonic = msc_trace_clock(CLOCK_MONOTONIC);\n"
+    "        ring->head            = 0;\n"
+    "    }\n"
+    "    if (-1 != fd) close(fd);\n"
+    "\n"
+    "    msc_trace_thread_ring = ring;\n"
+    "    return ring;\n"
+    "}\n"
+    "\n",
+
+    "static inline void msc_trace(uint16_t sender, uint16_t receiver,\n"
+    "                             uint16_t interface,\n"
+    "                             const void *payload, size_t payload_size,\n"
+    "                             size_t length)\n"
+    "{\n"
+    "    msc_trace_ring   *ring = msc_trace_thread_ring;\n"
+    "    msc_trace_record *record;\n"
+    "    uint64_t         head;\n"
+    "\n"
+    "    if (NULL == ring) {\n"
+    "        if (0 == msc_trace_enabled || NULL == (ring = msc_trace_open()))\n"
+    "            return;\n"
+    "    }\n"
+    "\n"
+    "    head = ring->head;\n"
+    "    record = (msc_trace_record *) (ring + 1) + (head & (MSC_TRACE_RECORDS - 1));\n"
+    "    record->timestamp      = msc_trace_clock(CLOCK_MONOTONIC)\n"
+    "                             - ring->start_monotonic;\n"
+    "    record->sender         = sender;\n"
+    "    record->receiver       = receiver;\n"
+    "    record->interface      = interface;\n"
+    "    record->flags          = 0;\n"
+    "    record->length         = (uint32_t) length;\n"
+    "    record->payload_length = 0;\n"
+    "    if (msc_trace_payload && NULL != payload) {\n"
+    "        record->payload_length = (uint32_t) (payload_size < MSC_TRACE_PAYLOAD ?\n"
+    "                                             payload_size : MSC_TRACE_PAYLOAD);\n"
+    "        memcpy(record->payload, payload, record->payload_length);\n"
+    "    }\n"
+    "    /* Publish the record */\n"
+    "    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);\n"
+    "}\n"
+    "\n"
+    "#else\n"
+    "\n"
+    "#define msc_trace(sender, receiver, interface, payload, payload_size, length)\n"
+    "\n"
+    "#endif\n"
+    "\n"
+    "#endif\n",
+
+    NULL
+};
+
+/* Option --thread-local-buffers: the encoding buffers of invoke_ri.c are
+ * declared with TASTE_THREAD_LOCAL, which can be redefined by the user */
+static const char *thread_local_macro =
+    "#ifndef TASTE_THREAD_LOCAL\n"
+    "#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L\n"
+    "#define TASTE_THREAD_LOCAL _Thread_local\n"
+    "#else\n"
+    "#define TASTE_THREAD_LOCAL __thread\n"
+    "#endif\n"
+    "#endif\n\n";
+
+/* The encoding buffers of invoke_ri.c are thread-local if the function is
+ * called by more than one thread. The variables of the PIs in vm_if.c stay
+ * static: a protected PI is serialized by its lock, and a cyclic or
+ * sporadic PI runs in one thread (TLS would copy them in every thread) */
+static bool thread_local_buffers(void)
+{
+    return get_context()->thread_local_buffers && count_calling_threads > 1;
+}
+
+/* Storage class of the encoding buffers of invoke_ri.c */
+static const char *static_buffer(void)
+{
+    return thread_local_buffers() ? "static TASTE_THREAD_LOCAL " : "static ";
+}
+
+/* Id of an interface in the binary MSC traces: its rank in its function */
+static size_t MSC_Interface_Id(Interface *i)
+{
+    size_t id = 0;
+
+    FOREACH(interface, Interface, i->parent_fv->interfaces, {
+        if (interface == i) break;
+        id++;
+    });
+    return id;
+}
+
+/* Record the call of a RI in the binary MSC trace. Each parameter has its
+ * own buffer: the payload is the first one, the length is the total */
+static void add_binary_msc_trace(Interface *i, bool encoded_params)
+{
+    FV   *receiver = FindFV(i->distant_fv);
+    char *sep = "";
+
+    if (NULL == receiver)
+        return;
+
+    Text_Printf(invoke_ri,
+                "\n    /* Binary MSC trace (TASTE_INNER_MSC) */\n"
+                "    msc_trace(%zu, %zu, %zu, ",
+                i->parent_fv->position,
+                receiver->position,
+                MSC_Interface_Id(i));
+
+    if (encoded_params && NULL != i->in) {
+        Text_Printf(invoke_ri, "IN_buf_%s, size_IN_buf_%s, ",
+                    i->in->value->name, i->in->value->name);
+        FOREACH(p, Parameter, i->in, {
+            Text_Printf(invoke_ri, "%ssize_IN_buf_%s", sep, p->name);
+            sep = " + ";
+        });
+    }
+    else {
+        Text_Printf(invoke_ri, "NULL, 0, 0");
+    }
+    Text_Printf(invoke_ri, ");\n");
+}
+
+/*
+ * Names of the functions and interfaces of the binary MSC traces, used by
+ * misc/taste-msc-decode to rebuild the MSC text format:
+ *   F <function id> <function name>
+ *   I <function id> <interface id> <interface name>
+ *   P <function id> <interface id> <parameter name> <type>
+ */
+void Generate_MSC_Trace_Ids(System *s)
+{
+    Text_Builder *ids = Create_Text_File(OUTPUT_PATH, "msc_trace_ids.txt");
+
+    assert(NULL != ids);
+
+    FOREACH(fv, FV, s->functions, {
+        Text_Printf(ids, "F %zu %s\n",
+                    fv->position,
+                    fv->artificial ? fv->original_name : fv->name);
+        FOREACH(i, Interface, fv->interfaces, {
+            if (RI == i->direction && NULL != i->distant_fv) {
+                size_t id = MSC_Interface_Id(i);
+                Text_Printf(ids, "I %zu %zu %s\n", fv->position, id, i->name);
+                FOREACH(p, Parameter, i->in, {
+                    Text_Printf(ids, "P %zu %zu %s %s\n",
+                                fv->position, id, p->name, p->type);
+                });
+            }
+        });
+    });
+
+    Close_Text_File(&ids);
+}
+
 /* Adds header to vm_if files */
 void c_preamble(FV * fv)
 {
@@ -34,53 +291,53 @@ void c_preamble(FV * fv)
     FOREACH(i, Interface, fv->interfaces, {
             CheckForAsn1Params(i, &hasparam);});
 
-    fprintf(vm_if, "%s", do_not_modify_warning);
+    Text_Printf(vm_if, "%s", do_not_modify_warning);
 
-    fprintf(vm_if_h, "%s", do_not_modify_warning);
+    Text_Printf(vm_if_h, "%s", do_not_modify_warning);
 
-    fprintf(vm_if_h, "#ifndef VM_IF_%s\n", fv->name);
-    fprintf(vm_if_h, "#define VM_IF_%s\n\n", fv->name);
+    Text_Printf(vm_if_h, "#ifndef VM_IF_%s\n", fv->name);
+    Text_Printf(vm_if_h, "#define VM_IF_%s\n\n", fv->name);
 
-    fprintf(vm_if, "#ifdef __unix__\n"
-                   "    #include <stdlib.h>\n"
-                   "    #include <stdio.h>\n"
-                   "#else\n"
-                   "    typedef unsigned size_t;\n"
-                   "#endif\n\n");
+    Text_Printf(vm_if, "#ifdef __unix__\n"
+                       "    #include <stdlib.h>\n"
+                       "    #include <stdio.h>\n"
+                       "#else\n"
+                       "    typedef unsigned size_t;\n"
+                       "#endif\n\n");
 
-    fprintf(vm_if_h, "#ifdef __cplusplus\n"
-            "extern \"C\" {\n" "#endif\n\n");
+    Text_Printf(vm_if_h, "#ifdef __cplusplus\n"
+                "extern \"C\" {\n" "#endif\n\n");
 
-    fprintf(vm_if, "#include \"%s_vm_if.h\"\n\n", fv->name);
+    Text_Printf(vm_if, "#include \"%s_vm_if.h\"\n\n", fv->name);
 
     if (c == fv->language || cpp == fv->language) {
-        fprintf(vm_if, "#include \"%s.h\"\n\n", fv->name);
+        Text_Printf(vm_if, "#include \"%s.h\"\n\n", fv->name);
     }
     else if (gui == fv->language) {
-        fprintf(vm_if, "#include \"%s_gui_header.h\"\n\n", fv->name);
+        Text_Printf(vm_if, "#include \"%s_gui_header.h\"\n\n", fv->name);
     }
     else if (rtds == fv->language) {
-        fprintf(vm_if, "#include \"glue_%s.h\"\n\n", fv->name);
+        Text_Printf(vm_if, "#include \"glue_%s.h\"\n\n", fv->name);
     }
     else if (micropython == fv->language) {
-        fprintf(vm_if, "#include \"%s_mpy_bindings.h\"\n\n", fv->name);
+        Text_Printf(vm_if, "#include \"%s_mpy_bindings.h\"\n\n", fv->name);
     }
     else if (ros_bridge == fv->language) {
-        fprintf(vm_if, "#include \"%s_ros_bridge_header.h\"\n\n", fv->name);
+        Text_Printf(vm_if, "#include \"%s_ros_bridge_header.h\"\n\n", fv->name);
     }
 
     if (hasparam) {
-        fprintf(vm_if,   "#include \"C_ASN1_Types.h\"\n\n");
-        fprintf(vm_if_h, "#include \"C_ASN1_Types.h\"\n\n");
+        Text_Printf(vm_if,   "#include \"C_ASN1_Types.h\"\n\n");
+        Text_Printf(vm_if_h, "#include \"C_ASN1_Types.h\"\n\n");
 
     }
 
-    fprintf(vm_if, "void init_%s()\n{\n", fv->name);
+    Text_Printf(vm_if, "void init_%s()\n{\n", fv->name);
 
-    fprintf(vm_if_h,
-            "/*\n * Function initialization:\n"
-            " * Calls all dependent user (or GUI) startup code - including sychronous RI\n"
-            "*/\n" "void init_%s();\n\n", fv->name);
+    Text_Printf(vm_if_h,
+                "/*\n * Function initialization:\n"
+                " * Calls all dependent user (or GUI) startup code - including sychronous RI\n"
+                "*/\n" "void init_%s();\n\n", fv->name);
 
     /* 
      * Define the main C initialization function
@@ -99,21 +356,21 @@ void c_preamble(FV * fv)
      * EDIT (MP 19/11/12) Removed the barrier that prevented from calling
      * the init function of the remote FVs if the language was Ada.
      */
-    fprintf(vm_if, "    static int init = 0;\n\n"
-                   "    if (!init) {\n"
-                   "        init = 1;\n");
+    Text_Printf(vm_if, "    static int init = 0;\n\n"
+                       "    if (!init) {\n"
+                       "        init = 1;\n");
 
     /* Call the user-defined startup function (or GUI startup)
      * Except for Ada functions - that have startup in elaboration */
     if (ada != fv->language && qgenada != fv->language && qgenc != fv->language) {
-        fprintf(vm_if, "        %s_startup();\n", fv->name);
+        Text_Printf(vm_if, "        %s_startup();\n", fv->name);
     }
 
     /* Add a call to QGen init function, if it exists in generated code*/
     FOREACH(i, Interface, fv->interfaces, {
         if ((RI == i->direction) && (i->distant_qgen != NULL)) {
             if (NULL != i->distant_qgen->qgen_init)
-                fprintf(vm_if, "        %s;\n", i->distant_qgen->qgen_init);
+                Text_Printf(vm_if, "        %s;\n", i->distant_qgen->qgen_init);
         }
     });
 
@@ -135,7 +392,7 @@ void c_preamble(FV * fv)
 
         FOREACH(i, Interface, fv->interfaces, {
                 if (RI == i->direction && synch == i->synchronism) {
-                    fprintf(vm_if,
+                    Text_Printf(vm_if,
                         "        extern void init_%s();\n"
                         "        init_%s();\n",
                         i->distant_fv, 
@@ -144,17 +401,17 @@ void c_preamble(FV * fv)
         );
     }
 
-    fprintf(vm_if, "    }\n");
+    Text_Printf(vm_if, "    }\n");
 
     if (ada == fv->language || qgenada == fv->language) {
         if (USE_PO_HI_C(fv)) {
-            fprintf(vm_if, "    /* Calling Ada initialization code */\n"
-                           "    adainit();\n");
-            fprintf(vm_if_h, "extern void adainit();\n");
+            Text_Printf(vm_if, "    /* Calling Ada initialization code */\n"
+                               "    adainit();\n");
+            Text_Printf(vm_if_h, "extern void adainit();\n");
         }
     }
 
-    fprintf(vm_if, "}\n\n");
+    Text_Printf(vm_if, "}\n\n");
 }
 
 /* Creates vm_if.c  */
@@ -172,9 +429,9 @@ int Init_C_Glue_Backend(FV * fv)
 
     filename = make_string("%s_vm_if.h", fv->name);
 
-    create_file(path, filename, &vm_if_h);
+    vm_if_h = Create_Text_File(path, filename);
     filename[strlen(filename) - 1] = 'c';
-    create_file(path, filename, &vm_if);
+    vm_if = Create_Text_File(path, filename);
 
 
     free(path);
@@ -188,67 +445,65 @@ int Init_C_Glue_Backend(FV * fv)
 
 void close_c_gluefiles()
 {
-    close_file(&vm_if);
+    Close_Text_File(&vm_if);
     if (NULL != vm_if_h) {
-        fprintf(vm_if_h,
-                "#ifdef __cplusplus\n" 
-                "}\n"
-                "#endif\n\n"
-                "#endif\n");
+        Text_Printf(vm_if_h,
+                    "#ifdef __cplusplus\n" 
+                    "}\n"
+                    "#endif\n\n"
+                    "#endif\n");
 
     }
-    close_file(&vm_if_h);
-    close_file(&invoke_ri);
+    Close_Text_File(&vm_if_h);
+    Close_Text_File(&invoke_ri);
 }
 
 /* Add a Provided interface. Can contain in and out parameters */
 void add_PI_to_c_vm_if(Interface * i)
 {
-    char *fcn_proto = NULL;
+    Text_Builder *fcn_proto = NULL;
     bool comma = false;
 
     if (NULL == vm_if)
         return;
 
-    /* a. function name */
-    fcn_proto = make_string("void %s_%s (", i->parent_fv->name, i->name);
+    /* a. function name (the prototype is used in vm_if.c and vm_if.h) */
+    fcn_proto = New_Text_Builder();
+    Text_Printf(fcn_proto, "void %s_%s (", i->parent_fv->name, i->name);
 
     /* b. for each IN param, add "void *pmy_inparam, size_t size_my_inparam" */
     FOREACH(p, Parameter, i->in, {
-            fcn_proto = make_string("%s%svoid *pmy_%s, size_t size_my_%s",
-                                    fcn_proto,
-                                    (p != i->in->value) ? ", " : "",
-                                    p->name, p->name);}
-    );
+        Text_Separator(fcn_proto, &comma, ", ");
+        Text_Printf(fcn_proto, "void *pmy_%s, size_t size_my_%s",
+                    p->name, p->name);
+    });
 
     /* c. for each OUT param, add "void *pmy_outparam, size_t *size_my_outparam" */
     FOREACH(p, Parameter, i->out, {
-        fcn_proto = make_string("%s%svoid *pmy_%s, size_t *psize_my_%s",
-                                fcn_proto,
-                                (p != i->out->value || (p == i->out->value
-                                    && NULL != i->in)) ? ", " : "",
-                                p->name,
-                                p->name);}
-    );
+        Text_Separator(fcn_proto, &comma, ", ");
+        Text_Printf(fcn_proto, "void *pmy_%s, size_t *psize_my_%s",
+                    p->name, p->name);
+    });
 
-    fprintf(vm_if, "%s)\n{\n", fcn_proto);
-    fprintf(vm_if_h, "%s);\n", fcn_proto);
-    free(fcn_proto);
+    Text_Printf(vm_if, "%s)\n{\n", Text_Content(fcn_proto));
+    Text_Printf(vm_if_h, "%s);\n", Text_Content(fcn_proto));
+    Free_Text_Builder(&fcn_proto);
 
     /* d. For each IN param, declare a variable to put the DECODED data.
      *    Variable is static for all interface but unprotected ones.
      */
+    Text_Indent(vm_if, 4);
 
     if (NULL != i->in) {
-        fprintf(vm_if,
-                "    /* Decoded input variable(s): developer can use them */\n");
+        Text_Printf(vm_if,
+                    "/* Decoded input variable(s): developer can use them */\n");
     }
 
     FOREACH(p, Parameter, i->in, {
-        fprintf(vm_if, "    %sasn1Scc%s IN_%s;\n",
-                       unprotected != i->rcm? "static ": "",
-                       p->type,
-                       p->name);
+        Text_Printf(vm_if, "%sasn1Scc%s IN_%s;\n",
+                           unprotected != i->rcm? "static ": "",
+                           p->type,
+                           p->name);
         }
     );
 
@@ -256,126 +511,118 @@ void add_PI_to_c_vm_if(Interface * i)
      *    prior to encoding. Variable is static except for unprotected
      *    interfaces (that would lead to race conditions) */
     if (NULL != i->out) {
-        fprintf(vm_if,
-                "\n    /* Output variable(s): developer has to fill them */\n");
+        Text_Printf(vm_if,
+                    "\n/* Output variable(s): developer has to fill them */\n");
     }
 
     FOREACH(p, Parameter, i->out, {
-        fprintf(vm_if, "    %sasn1Scc%s OUT_%s;\n",
-                       unprotected != i->rcm? "static ": "",
-                       p->type,
-                       p->name);
+        Text_Printf(vm_if, "%sasn1Scc%s OUT_%s;\n",
+                           unprotected != i->rcm? "static ": "",
+                           p->type,
+                           p->name);
         }
     );
+    Text_Indent(vm_if, -4);
 
     /* f. In case of linux platform, memset to 0 all parameters
      *    !! This is only needed to avoid valgrind warnings !!
      *    Unnecessary for flight platform because it consumes CPU for nothing
     */
     if (NULL != i->in || NULL != i->out) {
-        fprintf(vm_if, "\n#ifdef __unix__\n");
+        Text_Printf(vm_if, "\n#ifdef __unix__\n");
         FOREACH(p, Parameter, i->in, {
-                fprintf(vm_if, "    asn1Scc%s_Initialize(&IN_%s);\n",
-                        p->type, p->name);
+                Text_Printf(vm_if, "    asn1Scc%s_Initialize(&IN_%s);\n",
+                            p->type, p->name);
                 }
         );
         FOREACH(p, Parameter, i->out, {
-                fprintf(vm_if,
-                        "    asn1Scc%s_Initialize(&OUT_%s);\n",
-                        p->type, p->name);
+                Text_Printf(vm_if,
+                            "    asn1Scc%s_Initialize(&OUT_%s);\n",
+                            p->type, p->name);
                 }
         );
 
-        fprintf(vm_if, "#endif\n");
+        Text_Printf(vm_if, "#endif\n");
     }
 
     /* g. Decode each IN param */
     if (NULL != i->in) {
-        fprintf(vm_if, "\n    /* Decode each input parameter */\n");
+        Text_Printf(vm_if, "\n    /* Decode each input parameter */\n");
     }
 
     FOREACH(p, Parameter, i->in, {
-            fprintf(vm_if,
-                    "    if (0 != Decode_%s_%s (&IN_%s, pmy_%s, size_my_%s)) {\n"
-                    "        #ifdef __unix__\n"
-                    "            printf(\"\\nError Decoding %s\\n\");\n"
-                    "        #endif\n"
-                    "        return;\n"
-                    "    }\n\n",
-                    BINARY_ENCODING(p),
-                    p->type, p->name, p->name, p->name, p->type);}
+            Text_Printf(vm_if,
+                        "    if (0 != Decode_%s_%s (&IN_%s, pmy_%s, size_my_%s)) {\n"
+                        "        #ifdef __unix__\n"
+                        "            printf(\"\\nError Decoding %s\\n\");\n"
+                        "        #endif\n"
+                        "        return;\n"
+                        "    }\n\n",
+                        BINARY_ENCODING(p),
+                        p->type, p->name, p->name, p->name, p->type);}
     );
 
     if (qgenc == i->parent_fv->language) {
         /* h. Add a call to the user-defined function passing the decoded input as parameter */
-        fprintf(vm_if, "    /* Call to QGenc comp function */\n");
-        fprintf(vm_if, "    %s_comp (", i->name);
+        Text_Printf(vm_if, "    /* Call to QGenc comp function */\n");
+        Text_Printf(vm_if, "    %s_comp (", i->name);
 
         /* Add the external QGenc comp function declaration in the header file */
-        fprintf(vm_if_h, "extern void %s_comp (", i->name);
+        Text_Printf(vm_if_h, "extern void %s_comp (", i->name);
     } else {
         /* h. Add a call to the user-defined function passing the decoded input as parameter */
-        fprintf(vm_if, "    /* Call to User-defined function */\n");
-        fprintf(vm_if, "    %s_PI_%s (", i->parent_fv->name, i->name);
+        Text_Printf(vm_if, "    /* Call to User-defined function */\n");
+        Text_Printf(vm_if, "    %s_PI_%s (", i->parent_fv->name, i->name);
 
         /* Add the external PI function declaration in the header file */
-        fprintf(vm_if_h, "extern void %s_PI_%s (", i->parent_fv->name, i->name);
+        Text_Printf(vm_if_h, "extern void %s_PI_%s (", i->parent_fv->name, i->name);
     }
 
     comma = false;
     FOREACH (p, Parameter, i->in, {
-        fprintf(vm_if_h, "%sconst asn1Scc%s *",
-                         comma ? ", " : "",
-                         p->type);
-        comma = true;
+        Text_Separator(vm_if_h, &comma, ", ");
+        Text_Printf(vm_if_h, "const asn1Scc%s *", p->type);
     });
     FOREACH (p, Parameter, i->out, {
-        fprintf(vm_if_h, "%sasn1Scc%s *",
-                         comma ? ", " : "",
-                         p->type);
-        comma = true;
+        Text_Separator(vm_if_h, &comma, ", ");
+        Text_Printf(vm_if_h, "asn1Scc%s *", p->type);
     });
-    fprintf(vm_if_h, ");\n");
+    Text_Printf(vm_if_h, ");\n");
 
     comma = false;
     FOREACH(p, Parameter, i->in, {
-        fprintf(vm_if, "%s&IN_%s",
-                (true == comma) ? ", " : "", p->name); comma = true;
-        }
-    );
-
-    comma = false;
+        Text_Separator(vm_if, &comma, ", ");
+        Text_Printf(vm_if, "&IN_%s", p->name);
+    });
     FOREACH(p, Parameter, i->out, {
-        if (NULL != i->in) comma = true;
-        fprintf(vm_if, "%s&OUT_%s",
-                (true == comma) ? ", " : "", p->name); comma = true;
-        }
-    );
+        Text_Separator(vm_if, &comma, ", ");
+        Text_Printf(vm_if, "&OUT_%s", p->name);
+    });
 
-    fprintf(vm_if, ");\n\n");
+    Text_Printf(vm_if, ");\n\n");
 
     /* i. Encode each OUT param */
     if (NULL != i->out) {
-        fprintf(vm_if, "    /* Encode each output parameter */\n\n");
+        Text_Printf(vm_if, "    /* Encode each output parameter */\n\n");
     }
 
     FOREACH(p, Parameter, i->out, {
-        fprintf(vm_if,
-                "    *psize_my_%s = Encode_%s_%s (pmy_%s, %sasn1Scc%s%s, &OUT_%s);\n",
-                p->name,
-                BINARY_ENCODING(p),
-                p->type,
-                p->name,
-                (native == p->encoding) ? "sizeof (" : "",
-                p->type,
-                (native == p->encoding) ? ")" :
-                (uper == p->encoding) ?
-                "_REQUIRED_BYTES_FOR_ENCODING" :
-                "_REQUIRED_BYTES_FOR_ACN_ENCODING", p->name);
+        Text_Printf(vm_if,
+                    "    *psize_my_%s = Encode_%s_%s (pmy_%s, %sasn1Scc%s%s, &OUT_%s);\n",
+                    p->name,
+                    BINARY_ENCODING(p),
+                    p->type,
+                    p->name,
+                    (native == p->encoding) ? "sizeof (" : "",
+                    p->type,
+                    (native == p->encoding) ? ")" :
+                    (uper == p->encoding) ?
+                    "_REQUIRED_BYTES_FOR_ENCODING" :
+                    "_REQUIRED_BYTES_FOR_ACN_ENCODING", p->name);
         }
     );
 
-    fprintf(vm_if, "}\n");
+    Text_Printf(vm_if, "}\n");
 }
 
 /* Generation of interface functions to allow developer to call RI */
@@ -397,33 +644,52 @@ void add_RI_to_c_invoke_ri(Interface * i)
         build_string(&path, i->parent_fv->name,
                      strlen(i->parent_fv->name));
 
-        if (-1 == create_file(path, "invoke_ri.c", &invoke_ri)) {
+        invoke_ri = Create_Text_File(path, "invoke_ri.c");
+        if (NULL == invoke_ri) {
             free(path);
             return;
         }
         else {
-            fprintf(invoke_ri,
-                    "/* This file was generated automatically: DO NOT MODIFY IT ! */\n\n"
-                    "#include <stdlib.h>\n"
-                    "#ifdef __unix__\n"
-                    "#include <stdio.h>\n");
+            Text_Printf(invoke_ri,
+                        "/* This file was generated automatically: DO NOT MODIFY IT ! */\n\n"
+                        "#include <stdlib.h>\n"
+                        "#ifdef __unix__\n"
+                        "#include <stdio.h>\n");
             if (hasparam) {
-                fprintf(invoke_ri,
-                        "#include \"PrintTypesAsASN1.h\"\n"
-                        "#include \"timeInMS.h\"\n");
+                Text_Printf(invoke_ri,
+                            "#include \"PrintTypesAsASN1.h\"\n"
+                            "#include \"timeInMS.h\"\n");
             }
-            fprintf(invoke_ri, "#endif\n\n");
+            Text_Printf(invoke_ri, "#endif\n\n");
             if (hasparam)
-                fprintf(invoke_ri, "#include \"C_ASN1_Types.h\"\n");
+                Text_Printf(invoke_ri, "#include \"C_ASN1_Types.h\"\n");
             if (get_context()->polyorb_hi_c) {
-                fprintf(invoke_ri,
-                        "#include \"%s_polyorb_interface.h\"\n\n",
-                        i->parent_fv->name);
+                Text_Printf(invoke_ri,
+                            "#include \"%s_polyorb_interface.h\"\n\n",
+                            i->parent_fv->name);
             }
             if (qgenc == i->distant_qgen->language)
-                fprintf(invoke_ri,
-                        "#include \"%s.h\"\n\n",
-                        string_to_lower(i->distant_name));
+                Text_Printf(invoke_ri,
+                            "#include \"%s.h\"\n\n",
+                            string_to_lower(i->distant_name));
+            if (get_context()->binary_msc) {
+                Text_Builder *msc_trace_h =
+                    Create_Text_File(path, "msc_trace.h");
+
+                if (NULL == msc_trace_h) {
+                    free(path);
+                    return;
+                }
+                Text_Printf(msc_trace_h, "%s", do_not_modify_warning);
+                for (int k = 0; NULL != msc_trace_runtime[k]; k++) {
+                    Text_Printf(msc_trace_h, "%s", msc_trace_runtime[k]);
+                }
+                Close_Text_File(&msc_trace_h);
+                Text_Printf(invoke_ri, "#include \"msc_trace.h\"\n\n");
+            }
+            if (thread_local_buffers()) {
+                Text_Printf(invoke_ri, "%s", thread_local_macro);
+            }
         }
         free(path);
     }
@@ -431,155 +697,181 @@ void add_RI_to_c_invoke_ri(Interface * i)
 
     /* a. function name */
 
-    fprintf(invoke_ri,
-            "void %s_RI_%s(",
-            i->parent_fv->name,
-            i->name);
+    Text_Printf(invoke_ri,
+                "void %s_RI_%s(",
+                i->parent_fv->name,
+                i->name);
 
     /* Add the IN and OUT parameters: */
     FOREACH(p, Parameter, i->in, {
-            List_C_Types_And_Params_With_Pointers(p, &invoke_ri);}
+            List_C_Types_And_Params_With_Pointers(p, invoke_ri);}
     );
     FOREACH(p, Parameter, i->out, {
-            List_C_Types_And_Params_With_Pointers(p, &invoke_ri);}
+            List_C_Types_And_Params_With_Pointers(p, invoke_ri);}
     );
 
-    fprintf(invoke_ri, ")\n{\n");
+    Text_Printf(invoke_ri, ")\n{\n");
 
     /* MSC Tracer-related code */
     FV *receiver_FV = NULL;
     char *receiver_id = NULL, *sender_id = NULL;
 
-    fprintf(invoke_ri, "#ifdef __unix__\n");
+    /* Text MSC trace (the binary trace is recorded after the encoding) */
+    if (!get_context()->binary_msc) {
+        Text_Printf(invoke_ri, "#ifdef __unix__\n");
 
-    fprintf(invoke_ri, "    static int innerMsc = -1;\n");
+        Text_Printf(invoke_ri, "    static int innerMsc = -1;\n");
 
-    /* Sender or receiver can be in a FV that was created during VT
-     * (their name may be computed: fv_FV_pi) - in that case this is not
-     * what we want to see in the MSC - we have to retreive the original
-     * name, as it was entered by the user in the interface view */
-    if (NULL != i->distant_fv) {
-        receiver_FV = FindFV(i->distant_fv);
+        /* Sender or receiver can be in a FV that was created during VT
+         * (their name may be computed: fv_FV_pi) - in that case this is not
+         * what we want to see in the MSC - we have to retreive the original
+         * name, as it was entered by the user in the interface view */
+        if (NULL != i->distant_fv) {
+            receiver_FV = FindFV(i->distant_fv);
 
-        if (true == receiver_FV->artificial) {
-            receiver_id = receiver_FV->original_name;
-        }
-        else {
-            receiver_id = receiver_FV->name;
-        }
-        if (true == i->parent_fv->artificial) {
-            sender_id = i->parent_fv->original_name;
-        }
-        else {
-            sender_id = i->parent_fv->name;
+            if (true == receiver_FV->artificial) {
+                receiver_id = receiver_FV->original_name;
+            }
+            else {
+                receiver_id = receiver_FV->name;
+            }
+            if (true == i->parent_fv->artificial) {
+                sender_id = i->parent_fv->original_name;
+            }
+            else {
+                sender_id = i->parent_fv->name;
+            }
+            Text_Printf(invoke_ri,
+                        "    if (-1 == innerMsc)\n"
+                        "        innerMsc = (NULL != getenv(\"TASTE_INNER_MSC\"))?1:0;\n"
+                        "    if (1 == innerMsc) {\n"
+                        "        long long msc_time = getTimeInMilliseconds();\n\n");
+            FOREACH(p, Parameter, i->in, {
+                Text_Printf(invoke_ri,
+                            "        {\n"
+                            "            PrintASN1%s (\"INNERDATA: %s::%s::%s\", IN_%s);\n"
+                            "        }\n",
+                            p->type,
+                            i->name,
+                            p->type,
+                            p->name,
+                            p->name);
+            });
+            Text_Printf(invoke_ri,
+                        "        printf (\"\\nINNER: %s,%s,%s,%%lld\\n\", msc_time);\n"
+                        "        fflush(stdout);\n"
+                        "    }\n",
+                        sender_id, receiver_id, i->name);
+
+            Text_Printf(invoke_ri, "#endif\n\n");
+            /* End MSC Tracer-related code */
         }
-        fprintf(invoke_ri,
-                "    if (-1 == innerMsc)\n"
-                "        innerMsc = (NULL != getenv(\"TASTE_INNER_MSC\"))?1:0;\n"
-                "    if (1 == innerMsc) {\n"
-                "        long long msc_time = getTimeInMilliseconds();\n\n");
-        FOREACH(p, Parameter, i->in, {
-            fprintf(invoke_ri,
-                    "        {\n"
-                    "            PrintASN1%s (\"INNERDATA: %s::%s::%s\", IN_%s);\n"
-                    "        }\n",
-                    p->type,
-                    i->name,
-                    p->type,
-                    p->name,
-                    p->name);
-        });
-        fprintf(invoke_ri,
-                "        printf (\"\\nINNER: %s,%s,%s,%%lld\\n\", msc_time);\n"
-                "        fflush(stdout);\n"
-                "    }\n",
-                sender_id, receiver_id, i->name);
-
-        fprintf(invoke_ri, "#endif\n\n");
-        /* End MSC Tracer-related code */
     }
 
     if (qgenada == i->distant_qgen->language) {
 
+        if (get_context()->binary_msc && NULL != i->distant_fv) {
+            add_binary_msc_trace(i, false);
+        }
+
         /* Add a call to the vm callback function */
-        fprintf(invoke_ri, "\n    /* Call to VM callback function */\n");
+        Text_Printf(invoke_ri, "\n    /* Call to VM callback function */\n");
 
-        fprintf(invoke_ri, "    vm_%s%s_%s(",
-                asynch == i->synchronism ? "async_" : "", i->parent_fv->name,
-                i->name);
+        Text_Printf(invoke_ri, "    vm_%s%s_%s(",
+                    asynch == i->synchronism ? "async_" : "", i->parent_fv->name,
+                    i->name);
 
         /* Create the list of parameters */
         FOREACH(p, Parameter, i->in, {
-                List_QGen_Param_Names(p, &invoke_ri, i->distant_qgen->language);}
+                List_QGen_Param_Names(p, invoke_ri, i->distant_qgen->language);}
         );
 
         FOREACH(p, Parameter, i->out, {
-                List_QGen_Param_Names(p, &invoke_ri, i->distant_qgen->language);}
+                List_QGen_Param_Names(p, invoke_ri, i->distant_qgen->language);}
         );
 
-        fprintf(invoke_ri, ");\n\n");
+        Text_Printf(invoke_ri, ");\n\n");
 
     } else if (qgenc == i->distant_qgen->language){
 
+        if (get_context()->binary_msc && NULL != i->distant_fv) {
+            add_binary_msc_trace(i, false);
+        }
+
         /* Add a call to the QGenc comp function */
-        fprintf(invoke_ri, "\n    /* Call QGenc function */\n");
+        Text_Printf(invoke_ri, "\n    /* Call QGenc function */\n");
 
-        fprintf(invoke_ri, "    %s_comp(", i->distant_name);
+        Text_Printf(invoke_ri, "    %s_comp(", i->distant_name);
 
         /* Create the list of parameters */
         FOREACH(p, Parameter, i->in, {
-                List_QGen_Param_Names(p, &invoke_ri, i->distant_qgen->language);}
+                List_QGen_Param_Names(p, invoke_ri, i->distant_qgen->language);}
         );
 
         FOREACH(p, Parameter, i->out, {
-                List_QGen_Param_Names(p, &invoke_ri, i->distant_qgen->language);}
+                List_QGen_Param_Names(p, invoke_ri, i->distant_qgen->language);}
         );
 
-        fprintf(invoke_ri, ");\n\n");
+        Text_Printf(invoke_ri, ");\n\n");
 
-    } else {
+    } else if (NULL != Direct_Call_Target(i)) {
 
-        /* d. For each IN and OUT params, declare a static buffer to put encoded data */
-        if (NULL != i->in) {
-            fprintf(invoke_ri,
-                    "    /* Buffer(s) to put the encoded input parameter(s) */\n");
+        /* Option --direct-calls: the callee is a C/C++ function of the
+         * same partition, pass the parameters as they are */
+        bool comma = false;
+
+        if (get_context()->binary_msc) {
+            add_binary_msc_trace(i, false);
         }
+
+        Text_Printf(invoke_ri, "\n    /* Direct call (same partition) */\n");
+
+        Text_Printf(invoke_ri, "    extern void sync_direct_%s_%s(",
+                    i->distant_fv, i->connected_pi->name);
         FOREACH(p, Parameter, i->in, {
-            fprintf(invoke_ri,
-                    "    static char IN_buf_%s[%sasn1Scc%s%s] = {0};\n    size_t size_IN_buf_%s=0;\n",
-                    p->name,
-                    (native == p->encoding) ? "sizeof(" : "",
-                    p->type,
-                    (native == p->encoding) ? ")" :
-                    (uper == p->encoding) ? "_REQUIRED_BYTES_FOR_ENCODING" :
-                    "_REQUIRED_BYTES_FOR_ACN_ENCODING",
-                    p->name);
+            Text_Separator(invoke_ri, &comma, ", ");
+            Text_Printf(invoke_ri, "const asn1Scc%s *", p->type);
+        });
+        FOREACH(p, Parameter, i->out, {
+            Text_Separator(invoke_ri, &comma, ", ");
+            Text_Printf(invoke_ri, "asn1Scc%s *", p->type);
         });
+        Text_Printf(invoke_ri, "%s);\n\n", comma? "": "void");
 
-        if (NULL != i->out) {
-            fprintf(invoke_ri,
-                    "\n    /* Buffer(s) for the output parameter(s) */\n");
-        }
+        Text_Printf(invoke_ri, "    sync_direct_%s_%s(",
+                    i->distant_fv, i->connected_pi->name);
+        comma = false;
+        FOREACH(p, Parameter, i->in, {
+            Text_Separator(invoke_ri, &comma, ", ");
+            Text_Printf(invoke_ri, "IN_%s", p->name);
+        });
         FOREACH(p, Parameter, i->out, {
-            fprintf(invoke_ri,
-                    "    static char OUT_buf_%s[%sasn1Scc%s%s];\n    size_t size_OUT_buf_%s=0;\n",
+            Text_Separator(invoke_ri, &comma, ", ");
+            Text_Printf(invoke_ri, "OUT_%s", p->name);
+        });
+        Text_Printf(invoke_ri, ");\n\n");
+
+    } else if (Direct_Encode(i)) {
+
+        /* Option --direct-encode: encode the parameter directly in the
+         * request of the thread (see c_wrappers_backend.c) */
+        Parameter *p = i->in->value;
+
+        Text_Printf(invoke_ri,
+                    "    /* Encode the input parameter in the PolyORB-HI-C request */\n"
+                    "    extern void *vm_async_%s_%s_buffer(size_t *);\n"
+                    "    extern void vm_async_%s_%s_send(size_t);\n\n"
+                    "    size_t capacity_IN_buf_%s = 0;\n"
+                    "    char *IN_buf_%s = vm_async_%s_%s_buffer(&capacity_IN_buf_%s);\n"
+                    "    size_t size_IN_buf_%s = 0;\n\n",
+                    i->parent_fv->name, i->name,
+                    i->parent_fv->name, i->name,
                     p->name,
-                    (native == p->encoding) ? "sizeof(" : "",
-                    p->type,
-                    (native == p->encoding) ? ")" :
-                    (uper == p->encoding) ? "_REQUIRED_BYTES_FOR_ENCODING" :
-                    "_REQUIRED_BYTES_FOR_ACN_ENCODING",
+                    p->name, i->parent_fv->name, i->name, p->name,
                     p->name);
-        });
-
-        /* e. Encode each IN param */
-        if (NULL != i->in) {
-            fprintf(invoke_ri, "\n    /* Encode each input parameter */\n");
-        }
 
-        FOREACH(p, Parameter, i->in, {
-            fprintf(invoke_ri,
-                    "    size_IN_buf_%s = Encode_%s_%s(IN_buf_%s, %sasn1Scc%s%s, IN_%s);\n"
+        Text_Printf(invoke_ri,
+                    "    size_IN_buf_%s = Encode_%s_%s(IN_buf_%s, capacity_IN_buf_%s, IN_%s);\n"
                     "    if (-1 == size_IN_buf_%s) {\n"
                     "#ifdef __unix__\n"
                     "        printf (\"** Encoding error in %s_RI_%s!!\\n\");\n"
@@ -590,79 +882,152 @@ void add_RI_to_c_invoke_ri(Interface * i)
                     "    }\n",
                     p->name,
                     BINARY_ENCODING(p),
-                    p->type, p->name,
-                    (native == p->encoding) ? "sizeof(" : "",
-                    p->type,
-                    (native == p->encoding) ? ")" :
-                    (uper == p->encoding) ? "_REQUIRED_BYTES_FOR_ENCODING" :
-                    "_REQUIRED_BYTES_FOR_ACN_ENCODING",
-                    p->name,
+                    p->type, p->name, p->name, p->name,
                     p->name,
                     i->parent_fv->name,
                     i->name);
+
+        if (get_context()->binary_msc && NULL != i->distant_fv) {
+            add_binary_msc_trace(i, true);
+        }
+
+        Text_Printf(invoke_ri,
+                    "\n    /* Send the request */\n"
+                    "    vm_async_%s_%s_send(size_IN_buf_%s);\n\n",
+                    i->parent_fv->name, i->name, p->name);
+
+    } else {
+
+        /* d. For each IN and OUT params, declare a static buffer to put encoded data */
+        if (NULL != i->in) {
+            Text_Printf(invoke_ri,
+                        "    /* Buffer(s) to put the encoded input parameter(s) */\n");
+        }
+        FOREACH(p, Parameter, i->in, {
+            Text_Printf(invoke_ri,
+                        "    %schar IN_buf_%s[%sasn1Scc%s%s] = {0};\n    size_t size_IN_buf_%s=0;\n",
+                        static_buffer(),
+                        p->name,
+                        (native == p->encoding) ? "sizeof(" : "",
+                        p->type,
+                        (native == p->encoding) ? ")" :
+                        (uper == p->encoding) ? "_REQUIRED_BYTES_FOR_ENCODING" :
+                        "_REQUIRED_BYTES_FOR_ACN_ENCODING",
+                        p->name);
         });
 
+        if (NULL != i->out) {
+            Text_Printf(invoke_ri,
+                        "\n    /* Buffer(s) for the output parameter(s) */\n");
+        }
+        FOREACH(p, Parameter, i->out, {
+            Text_Printf(invoke_ri,
+                        "    %schar OUT_buf_%s[%sasn1Scc%s%s];\n    size_t size_OUT_buf_%s=0;\n",
+                        static_buffer(),
+                        p->name,
+                        (native == p->encoding) ? "sizeof(" : "",
+                        p->type,
+                        (native == p->encoding) ? ")" :
+                        (uper == p->encoding) ? "_REQUIRED_BYTES_FOR_ENCODING" :
+                        "_REQUIRED_BYTES_FOR_ACN_ENCODING",
+                        p->name);
+        });
+
+        /* e. Encode each IN param */
+        if (NULL != i->in) {
+            Text_Printf(invoke_ri, "\n    /* Encode each input parameter */\n");
+        }
+
+        FOREACH(p, Parameter, i->in, {
+            Text_Printf(invoke_ri,
+                        "    size_IN_buf_%s = Encode_%s_%s(IN_buf_%s, %sasn1Scc%s%s, IN_%s);\n"
+                        "    if (-1 == size_IN_buf_%s) {\n"
+                        "#ifdef __unix__\n"
+                        "        printf (\"** Encoding error in %s_RI_%s!!\\n\");\n"
+                        "#endif\n"
+                        "        /* Crash the application due to message loss */\n"
+                        "        extern void abort (void);\n"
+                        "        abort();\n"
+                        "    }\n",
+                        p->name,
+                        BINARY_ENCODING(p),
+                        p->type, p->name,
+                        (native == p->encoding) ? "sizeof(" : "",
+                        p->type,
+                        (native == p->encoding) ? ")" :
+                        (uper == p->encoding) ? "_REQUIRED_BYTES_FOR_ENCODING" :
+                        "_REQUIRED_BYTES_FOR_ACN_ENCODING",
+                        p->name,
+                        p->name,
+                        i->parent_fv->name,
+                        i->name);
+        });
+
+
+        if (get_context()->binary_msc && NULL != i->distant_fv) {
+            add_binary_msc_trace(i, true);
+        }
 
         /* f. Add a call to the vm callback function passing the encoded
          *  inputs as parameters */
-        fprintf(invoke_ri, "\n    /* Call to VM callback function */\n");
+        Text_Printf(invoke_ri, "\n    /* Call to VM callback function */\n");
         char *name = make_string("vm_%s%s_%s",
                 asynch == i->synchronism ? "async_" : "", i->parent_fv->name,
                 i->name);
 
         /* Declare external function (may be in Ada, so no file to include */
-        fprintf(invoke_ri, "    extern void %s(", name);
+        Text_Printf(invoke_ri, "    extern void %s(", name);
         bool comma = false;
         FOREACH(_, Parameter, i->in, {
                 (void) _;
-                fprintf(invoke_ri, "%svoid *, size_t", comma? ", ": "");
-                comma = true;
+                Text_Separator(invoke_ri, &comma, ", ");
+                Text_Printf(invoke_ri, "void *, size_t");
         });
         FOREACH(_, Parameter, i->out, {
                 (void) _;
-                fprintf(invoke_ri, "%svoid *, size_t *", comma? ", ": "");
-                comma = true;
+                Text_Separator(invoke_ri, &comma, ", ");
+                Text_Printf(invoke_ri, "void *, size_t *");
         });
-        fprintf(invoke_ri, ");\n\n");
+        Text_Printf(invoke_ri, ");\n\n");
 
-        fprintf(invoke_ri, "    %s(", name);
+        Text_Printf(invoke_ri, "    %s(", name);
 
         free(name);
 
         /* Add the IN and OUT parameters */
         FOREACH(p, Parameter, i->in, {
-                List_C_Params_And_Size(p, &invoke_ri);}
+                List_C_Params_And_Size(p, invoke_ri);}
         );
         FOREACH(p, Parameter, i->out, {
-                List_C_Params_And_Size(p, &invoke_ri);}
+                List_C_Params_And_Size(p, invoke_ri);}
         );
 
-        fprintf(invoke_ri, ");\n\n");
+        Text_Printf(invoke_ri, ");\n\n");
 
         /* g. Decode each OUT param */
         if (NULL != i->out) {
-            fprintf(invoke_ri, "    /* Decode each output parameter */\n");
+            Text_Printf(invoke_ri, "    /* Decode each output parameter */\n");
         }
 
         FOREACH(p, Parameter, i->out, {
-            fprintf(invoke_ri,
-                    "    if (0 != Decode_%s_%s(OUT_%s, OUT_buf_%s, size_OUT_buf_%s)) {\n"\
-                    "#ifdef __unix__\n"
-                    "        printf(\"\\nError Decoding %s\\n\");\n"
-                    "#endif\n"
-                    "        return;\n"
-                    "    }\n\n",
-                    BINARY_ENCODING(p),
-                    p->type,
-                    p->name,
-                    p->name,
-                    p->name,
-                    p->type);
+            Text_Printf(invoke_ri,
+                        "    if (0 != Decode_%s_%s(OUT_%s, OUT_buf_%s, size_OUT_buf_%s)) {\n"\
+                        "#ifdef __unix__\n"
+                        "        printf(\"\\nError Decoding %s\\n\");\n"
+                        "#endif\n"
+                        "        return;\n"
+                        "    }\n\n",
+                        BINARY_ENCODING(p),
+                        p->type,
+                        p->name,
+                        p->name,
+                        p->name,
+                        p->type);
         });
 
     }
 
-    fprintf(invoke_ri, "}\n\n");
+    Text_Printf(invoke_ri, "}\n\n");
 }
 
 void End_C_Glue_Backend()
@@ -62,6 +62,251 @@ static FILE *code_id = NULL;
  */
 static char *cyclic_name = NULL;
 
+/* Runtime of the shared-memory transport (option --gui-shm), written in
+ * the directory of each GUI function as gui_shm_ring.h */
+static const char *gui_shm_runtime[] = {
+    "/*\n"
+    " * Shared-memory transport of the GUI messages (buildsupport option --gui-shm)\n"
+    " *\n"
+    " * The glue of a GUI function creates a shared-memory region named\n"
+    " * /<uid>_<function>_gui_shm that holds three single-producer,\n"
+    " * single-consumer rings, in place of the POSIX message queues:\n"
+    " *   GUI_SHM_RI        messages from the GUI to the functions (RI calls)\n"
+    " *   GUI_SHM_PI        messages from the functions to the GUI (PI calls)\n"
+    " *   GUI_SHM_PI_PYTHON copy of the PI messages for the Python mappers\n"
+    " * A slot holds the identifier of a message, its size and its content.\n"
+    " * A full ring drops the new message, as a full non-blocking queue does.\n"
+    " * The consumer of the RI ring (the receiver of option --gui-events) and\n"
+    " * the GUI may sleep on the futex of a ring (gui_shm_wait): the producer\n"
+    " * wakes them up, and only touches the futex when a consumer sleeps.\n"
+    " * The layout is fixed (see misc/taste-gui-shm for the Python reader):\n"
+    " *   0    header (64 bytes): \"TASTESHM\", version, number of rings, size\n"
+    " *   64   one descriptor of 192 bytes per ring, the producer index and\n"
+    " *        the consumer index in cache lines of their own\n"
+    " *   ...  the slots of the rings\n"
+    " */\n"
+    "#ifndef GUI_SHM_RING_H\n"
+    "#define GUI_SHM_RING_H\n"
+    "\n"
+    "#include <stdint.h>\n"
+    "#include <stddef.h>\n"
+    "#include <string.h>\n"
+    "#include <errno.h>\n"
+    "#include <time.h>\n"
+    "#include <sched.h>\n"
+    "#include <fcntl.h>\n"
+    "#include <unistd.h>\n"
+    "#include <sys/mman.h>\n"
+    "#include <sys/stat.h>\n"
+    "#include <sys/syscall.h>\n"
+    "#include <linux/futex.h>\n"
+    "\n"
+    "#ifndef GUI_SHM_CAPACITY\n"
+    "#define GUI_SHM_CAPACITY 1024       /* slots per ring, power of two */\n"
+    "#endif\n"
+    "\n"
+    "#ifndef GUI_SHM_SPIN\n"
+    "#define GUI_SHM_SPIN 64             /* yields before sleeping on the futex */\n"
+    "#endif\n"
+    "\n"
+    "#define GUI_SHM_VERSION 1\n"
+    "\n"
+    "enum { GUI_SHM_RI, GUI_SHM_PI, GUI_SHM_PI_PYTHON, GUI_SHM_RINGS };\n"
+    "\n"
+    "typedef struct {\n"
+    "    uint32_t slot_size;             /* bytes of a slot, header included */\n"
+    "    uint32_t capacity;              /* slots, power of two */\n"
+    "    uint64_t offset;                /* of the first slot in the region */\n"
+    "    uint32_t waiting;               /* the consumer sleeps on the futex */\n"
+    "    uint32_t futex;                 /* incremented by each message */\n"
+    "    uint8_t  reserved1[40];\n"
+    "    uint64_t head;                  /* messages written (producer) */\n"
+    "    uint8_t  reserved2[56];\n"
+    "    uint64_t tail;                  /* messages read (consumer) */\n"
+    "    uint8_t  reserved3[56];\n"
+    "} gui_shm_ring;\n"
+    "\n"
+    "typedef struct {\n"
+    "    char         magic[8];          /* \"TASTESHM\", written last */\n"
+    "    uint32_t     version;\n"
+    "    uint32_t     rings;\n"
+    "    uint64_t     size;              /* of the region */\n"
+    "    uint8_t      reserved[40];\n"
+    "    gui_shm_ring ring[GUI_SHM_RINGS];\n"
+    "} gui_shm_region;\n"
+    "\n"
+    "typedef struct {\n"
+    "    int32_t  id;\n"
+    "    uint32_t size;\n"
+    "} gui_shm_message;\n"
+    "\n"
+    "/* Slot sizes are multiples of 8 bytes, for the alignment of the contents */\n"
+    "static inline uint32_t gui_shm_slot_size(size_t max_msg_size)\n"
+    "{\n"
+    "    return (uint32_t) ((sizeof(gui_shm_message) + max_msg_size + 7) & ~7u);\n"
+    "}\n"
+    "\n",
+    "/* Create the region (GUI function side) or attach to it (create = 0).\n"
+    " * The RI ring is sized for ri_size bytes, the PI rings for pi_size bytes */\n"
+    "static inline gui_shm_region *gui_shm_open(const char *name, int create,\n"
+    "                                           size_t ri_size, size_t pi_size)\n"
+    "{\n"
+    "    gui_shm_region *region = NULL;\n"
+    "    size_t          size = sizeof(gui_shm_region);\n"
+    "    int             fd = -1, k;\n"
+    "\n"
+    "    fd = shm_open(name, create ? O_CREAT | O_RDWR : O_RDWR, 0600);\n"
+    "    if (-1 == fd) return NULL;\n"
+    "\n"
+    "    if (create) {\n"
+    "        uint32_t slot[GUI_SHM_RINGS];\n"
+    "        slot[GUI_SHM_RI]        = gui_shm_slot_size(ri_size);\n"
+    "        slot[GUI_SHM_PI]        = gui_shm_slot_size(pi_size);\n"
+    "        slot[GUI_SHM_PI_PYTHON] = gui_shm_slot_size(pi_size);\n"
+    "        for (k = 0; k < GUI_SHM_RINGS; k++) {\n"
+    "            size += (size_t) slot[k] * GUI_SHM_CAPACITY;\n"
+    "        }\n"
+    "        /* The region of a previous run is reset */\n"
+    "        if (-1 == ftruncate(fd, 0) || -1 == ftruncate(fd, (off_t) size)) {\n"
+    "            close(fd);\n"
+    "            return NULL;\n"
+    "        }\n"
+    "        region = (gui_shm_region *) mmap(NULL, size, PROT_READ | PROT_WRITE,\n"
+    "                                         MAP_SHARED, fd, 0);\n"
+    "        if (MAP_FAILED != (void *) region) {\n"
+    "            uint64_t offset = sizeof(gui_shm_region);\n"
+    "            region->version = GUI_SHM_VERSION;\n"
+    "            region->rings   = GUI_SHM_RINGS;\n"
+    "            region->size    = size;\n"
+    "            for (k = 0; k < GUI_SHM_RINGS; k++) {\n"
+    "                region->ring[k].slot_size = slot[k];\n"
+    "                region->ring[k].capacity  = GUI_SHM_CAPACITY;\n"
+    "                region->ring[k].offset    = offset;\n"
+    "                offset += (uint64_t) slot[k] * GUI_SHM_CAPACITY;\n"
+    "            }\n"
+    "            __atomic_thread_fence(__ATOMIC_RELEASE);\n"
+    "            memcpy(region->magic, \"TASTESHM\", 8);\n"
+    "        }\n"
+    "    }\n"
+    "    else {\n"
+    "        struct stat st;\n"
+    "        if (0 == fstat(fd, &st) && (size_t) st.st_size >= size) {\n"
+    "            region = (gui_shm_region *) mmap(NULL, (size_t) st.st_size,\n"
+    "                                             PROT_READ | PROT_WRITE,\n"
+    "                                             MAP_SHARED, fd, 0);\n"
+    "            if (MAP_FAILED != (void *) region\n"
+    "                && (memcmp(region->magic, \"TASTESHM\", 8)\n"
+    "                    || GUI_SHM_VERSION != region->version)) {\n"
+    "                munmap(region, (size_t) st.st_size);\n"
+    "                region = NULL;\n"
+    "            }\n"
+    "        }\n"
+    "    }\n"
+    "    close(fd);\n"
+    "    return MAP_FAILED == (void *) region ? NULL : region;\n"
+    "}\n"
+    "\n"
+    "static inline gui_shm_message *gui_shm_slot(gui_shm_region *region, int ring,\n"
+    "                                            uint64_t index)\n"
+    "{\n"
+    "    gui_shm_ring *r = &region->ring[ring];\n"
+    "    return (gui_shm_message *) ((char *) region + r->offset\n"
+    "                                + (index & (r->capacity - 1)) * r->slot_size);\n"
+    "}\n"
+    "\n",
+    "/* Write a message: 0 if done, -1 if the ring is full or the message is\n"
+    " * too big. A single thread may write in a given ring */\n"
+    "static inline int gui_shm_push(gui_shm_region *region, int ring, int id,\n"
+    "                               const void *content, size_t size)\n"
+    "{\n"
+    "    gui_shm_ring    *r = &region->ring[ring];\n"
+    "    uint64_t        head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);\n"
+    "    gui_shm_message *msg = NULL;\n"
+    "\n"
+    "    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= r->capacity\n"
+    "        || sizeof(gui_shm_message) + size > r->slot_size) {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    msg = gui_shm_slot(region, ring, head);\n"
+    "    msg->id   = id;\n"
+    "    msg->size = (uint32_t) size;\n"
+    "    if (NULL != content) {\n"
+    "        memcpy(msg + 1, content, size);\n"
+    "    }\n"
+    "    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);\n"
+    "\n"
+    "    /* Wake up the consumer if it sleeps. The fence orders the store of\n"
+    "     * head and the load of waiting (see gui_shm_wait): the futex word is\n"
+    "     * only written when the consumer waits */\n"
+    "    __atomic_thread_fence(__ATOMIC_SEQ_CST);\n"
+    "    if (__atomic_load_n(&r->waiting, __ATOMIC_RELAXED)) {\n"
+    "        __atomic_add_fetch(&r->futex, 1, __ATOMIC_RELAXED);\n"
+    "        syscall(SYS_futex, &r->futex, FUTEX_WAKE, 1, NULL, NULL, 0);\n"
+    "    }\n"
+    "    return 0;\n"
+    "}\n"
+    "\n"
+    "/* Read a message in a buffer of max_size bytes: 0 if done, -1 if the\n"
+    " * ring is empty. A single thread may read a given ring */\n"
+    "static inline int gui_shm_pop(gui_shm_region *region, int ring, int *id,\n"
+    "                              void *content, size_t max_size)\n"
+    "{\n"
+    "    gui_shm_ring    *r = &region->ring[ring];\n"
+    "    uint64_t        tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);\n"
+    "    gui_shm_message *msg = NULL;\n"
+    "\n"
+    "    if (tail == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE)) {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    msg = gui_shm_slot(region, ring, tail);\n"
+    "    *id = msg->id;\n"
+    "    memcpy(content, msg + 1, msg->size < max_size ? msg->size : max_size);\n"
+    "    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);\n"
+    "    return 0;\n"
+    "}\n"
+    "\n"
+    "/* Wait until the ring has a message or for timeout_ms milliseconds\n"
+    " * (-1: no timeout). Return 0 if a message is available */\n"
+    "static inline int gui_shm_wait(gui_shm_region *region, int ring,\n"
+    "                               int timeout_ms)\n"
+    "{\n"
+    "    gui_shm_ring    *r = &region->ring[ring];\n"
+    "    uint32_t        seq = 0;\n"
+    "    struct timespec timeout;\n"
+    "    int             spin;\n"
+    "\n"
+    "    /* Spin a little before sleeping: high-rate producers do not have to\n"
+    "     * wake up the consumer for each message */\n"
+    "    for (spin = 0; spin < GUI_SHM_SPIN; spin++) {\n"
+    "        if (__atomic_load_n(&r->tail, __ATOMIC_RELAXED)\n"
+    "            != __atomic_load_n(&r->head, __ATOMIC_ACQUIRE)) {\n"
+    "            return 0;\n"
+    "        }\n"
+    "        sched_yield();\n"
+    "    }\n"
+    "\n"
+    "    /* Either the producer sees waiting and changes the futex word, or\n"
+    "     * this thread sees the new head and does not sleep */\n"
+    "    seq = __atomic_load_n(&r->futex, __ATOMIC_RELAXED);\n"
+    "    __atomic_store_n(&r->waiting, 1, __ATOMIC_RELAXED);\n"
+    "    __atomic_thread_fence(__ATOMIC_SEQ_CST);\n"
+    "    if (__atomic_load_n(&r->tail, __ATOMIC_RELAXED)\n"
+    "        == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE)) {\n"
+    "        timeout.tv_sec  = timeout_ms / 1000;\n"
+    "        timeout.tv_nsec = (long) (timeout_ms % 1000) * 1000000L;\n"
+    "        syscall(SYS_futex, &r->futex, FUTEX_WAIT, seq,\n"
+    "                timeout_ms < 0 ? NULL : &timeout, NULL, 0);\n"
+    "    }\n"
+    "    __atomic_store_n(&r->waiting, 0, __ATOMIC_RELAXED);\n"
+    "\n",
+    "    return __atomic_load_n(&r->tail, __ATOMIC_RELAXED)\n"
+    "           == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) ? -1 : 0;\n"
+    "}\n"
+    "\n"
+    "#endif\n",
+    NULL
+};
+
 
 
 
@@ -300,8 +545,20 @@ void gui_preamble(FV * fv)
 
     // code preamble
     fprintf(code_id, "#include <unistd.h>\n");
-    fprintf(code_id, "#include <mqueue.h>\n");
-    fprintf(code_id, "#include \"queue_manager.h\"\n");
+    if (get_context()->gui_events) {
+        fprintf(code_id, "#include <time.h>\n");
+        fprintf(code_id, "#include <pthread.h>\n");
+        if (!get_context()->gui_shm) {
+            fprintf(code_id, "#include <poll.h>\n");
+        }
+    }
+    if (get_context()->gui_shm) {
+        fprintf(code_id, "#include \"gui_shm_ring.h\"\n");
+    }
+    else {
+        fprintf(code_id, "#include <mqueue.h>\n");
+        fprintf(code_id, "#include \"queue_manager.h\"\n");
+    }
     fprintf(code_id, "#include \"%s_gui_header.h\"\n\n\n", fv->name);
 }
 
@@ -325,6 +582,17 @@ void create_single_queue_initialization_function(char *NODE_NAME,
         "   %s_%s_max_msg_size = compute_max_queue_size_element_for_%s();\n\n",
         NODE_NAME, IF_TYPE_STRING, IF_TYPE_STRING);
 
+    //Event-driven mode: allocate the buffer of the incoming messages once
+    if (RI == IF_KIND && get_context()->gui_events) {
+        fprintf(code_id,
+            "   %s_RI_msgcontent = (char *) malloc((size_t) %s_RI_max_msg_size);\n"
+            "   if (NULL == %s_RI_msgcontent) {\n"
+            "      perror(\"Error when allocating the GUI message buffer\");\n"
+            "      exit(1);\n"
+            "   }\n\n",
+            NODE_NAME, NODE_NAME, NODE_NAME);
+    }
+
     //Create queue
     fprintf (code_id, "   {\n    char *gui_queue_name = NULL;\n");
     fprintf (code_id, "    int  len = snprintf (gui_queue_name, 0, \"%%d_%s_%s_queue\", geteuid());\n", NODE_NAME, IF_TYPE_STRING);
@@ -364,6 +632,44 @@ void create_single_queue_initialization_function(char *NODE_NAME,
 //
 void create_queues_initialization_function(FV *fv)
 {
+    //Shared-memory transport: one region for all the messages, the
+    //size of the messages is not limited by msgsize_max
+    if (get_context()->gui_shm) {
+        fprintf(code_id, "void %s_startup(void)\n"
+                         "{\n"
+                         "   char *gui_shm_name = NULL;\n"
+                         "   int  len = snprintf (gui_shm_name, 0, "
+                         "\"/%%d_%s_gui_shm\", geteuid());\n\n",
+                         fv->name, fv->name);
+        fprintf(code_id,
+            "   %s_RI_max_msg_size = compute_max_queue_size_element_for_RI();\n"
+            "   %s_PI_max_msg_size = compute_max_queue_size_element_for_PI();\n\n",
+            fv->name, fv->name);
+        if (RI_LIST != NULL) {
+            fprintf(code_id,
+                "   %s_RI_msgcontent = (char *) malloc((size_t) %s_RI_max_msg_size);\n"
+                "   if (NULL == %s_RI_msgcontent) {\n"
+                "      perror(\"Error when allocating the GUI message buffer\");\n"
+                "      exit(1);\n"
+                "   }\n\n",
+                fv->name, fv->name, fv->name);
+        }
+        fprintf(code_id,
+            "   gui_shm_name = (char *) malloc ((size_t) len + 1);\n"
+            "   if (NULL != gui_shm_name) {\n"
+            "      snprintf (gui_shm_name, len + 1, \"/%%d_%s_gui_shm\", geteuid());\n"
+            "      %s_rings = gui_shm_open(gui_shm_name, 1, %s_RI_max_msg_size, %s_PI_max_msg_size);\n"
+            "      free (gui_shm_name);\n"
+            "   }\n"
+            "   if (NULL == %s_rings) {\n"
+            "      perror(\"Error when creating the GUI shared memory\");\n"
+            "      exit(1);\n"
+            "   }\n"
+            "}\n\n",
+            fv->name, fv->name, fv->name, fv->name, fv->name);
+        return;
+    }
+
     //
     //Create the initialisation functions to be called at startup
     //
@@ -565,6 +871,187 @@ void create_incomming_data_pooler(char *NODE_NAME)
 
 
 
+//Version of the pooler for the options --gui-events and --gui-shm. The
+//message buffer is allocated once by the startup function, and each
+//activation of the PI drains the messages that are already received,
+//without waiting for more: the PI is protected when the GUI function has
+//sporadic PIs, and waiting in it would delay them. With --gui-shm, the PI
+//reads the RI ring of the shared memory instead of the message queue.
+//With --gui-events, the PI is sporadic: it is called by the receiver of
+//the GUI (see create_gui_event_wait), and ends the event after the drain.
+//
+//   fv         : [in] Pointer on the GUI FV
+//
+static void create_incomming_data_listener(FV * fv)
+{
+    T_RI_PI_NAME_LIST *iterator = RI_LIST;
+
+    if (RI_CURRENT_MAX_NUMBER_OF_PARAMS_IN_MESSAGE == 0)
+        return;
+
+    //Message buffer, allocated once by the startup function
+    fprintf(code_id, "static char *%s_RI_msgcontent = NULL;\n\n", fv->name);
+
+    //Event sent by the receiver and not handled yet (--gui-events)
+    if (get_context()->gui_events) {
+        fprintf(code_id, "static pthread_mutex_t %s_event_lock = PTHREAD_MUTEX_INITIALIZER;\n"
+                         "static pthread_cond_t  %s_event_done = PTHREAD_COND_INITIALIZER;\n"
+                         "static int             %s_event_pending = 0;\n\n",
+                         fv->name, fv->name, fv->name);
+    }
+
+    fprintf(header_id, "void %s_PI_%s();\n\n", fv->name, cyclic_name);
+
+    fprintf(code_id, "void %s_PI_%s()\n", fv->name, cyclic_name);
+    fprintf(code_id, "{\n");
+    fprintf(code_id, "   T_%s_RI_list message_recieved_type;\n\n", fv->name);
+
+    fprintf(code_id, "   if (NULL == %s_RI_msgcontent)\n"
+                     "      return;\n\n", fv->name);
+
+    if (get_context()->gui_shm) {
+        fprintf(code_id,
+            "   while (0 == gui_shm_pop(%s_rings, GUI_SHM_RI, (int *)&message_recieved_type, %s_RI_msgcontent, (size_t) %s_RI_max_msg_size))\n",
+            fv->name, fv->name, fv->name);
+    }
+    else {
+        fprintf(code_id,
+            "   while (!retrieve_message_from_queue(%s_RI_queue_id, %s_RI_max_msg_size, %s_RI_msgcontent, (int *)&message_recieved_type))\n",
+            fv->name, fv->name, fv->name);
+    }
+    fprintf(code_id, "   {\n");
+    fprintf(code_id, "      switch(message_recieved_type)\n");
+    fprintf(code_id, "      {\n");
+    while (iterator != NULL) {
+        fprintf(code_id,
+            "       case i_%s : INVOKE_RI_%s (%s_RI_msgcontent);\n",
+            iterator->name, iterator->name, fv->name);
+        fprintf(code_id, "                 break;\n");
+        iterator = iterator->next;
+    }
+    fprintf(code_id, "       default : break;\n");
+    fprintf(code_id, "      }\n");
+    fprintf(code_id, "   }\n");
+    if (get_context()->gui_events) {
+        fprintf(code_id, "\n   //The receiver can wait for the next messages\n");
+        fprintf(code_id, "   pthread_mutex_lock(&%s_event_lock);\n"
+                         "   %s_event_pending = 0;\n"
+                         "   pthread_cond_signal(&%s_event_done);\n"
+                         "   pthread_mutex_unlock(&%s_event_lock);\n",
+                         fv->name, fv->name, fv->name, fv->name);
+    }
+    fprintf(code_id, "}\n");
+}
+
+
+
+//Option --gui-events: function called by the receiver of the GUI
+//(<fv>_gui_receiver, created by the preprocessing) to wait for the
+//messages. It returns 1 when the receiver must send an event to the
+//polling PI, or 0 after timeout_ms milliseconds. A single event is pending
+//at a time: the next messages are waited for once the PI has drained the
+//queue, so the receiver does not flood the queue of the sporadic PI.
+//The message queue is non-blocking and its messages are read by
+//retrieve_message_from_queue: the receiver blocks in poll() on its
+//descriptor (a file descriptor on Linux) without consuming them. With
+//--gui-shm it sleeps on the futex of the RI ring.
+//
+//   fv         : [in] Pointer on the GUI FV
+//
+static void create_gui_event_wait(FV * fv)
+{
+    if (RI_CURRENT_MAX_NUMBER_OF_PARAMS_IN_MESSAGE == 0)
+        return;
+
+    fprintf(header_id, "int %s_gui_wait(int timeout_ms);\n\n", fv->name);
+
+    fprintf(code_id, "\n\n\nint %s_gui_wait(int timeout_ms)\n", fv->name);
+    fprintf(code_id, "{\n");
+    if (!get_context()->gui_shm) {
+        fprintf(code_id, "   struct pollfd   queue = { .fd = (int) %s_RI_queue_id, "
+                         ".events = POLLIN };\n", fv->name);
+    }
+    fprintf(code_id, "   struct timespec now, deadline;\n"
+                     "   int             ready = 0;\n\n");
+
+    //Not started yet: the receiver tries again at its next period
+    fprintf(code_id, "   if (NULL == %s_RI_msgcontent || timeout_ms <= 0)\n"
+                     "      return 0;\n\n", fv->name);
+
+    fprintf(code_id, "   clock_gettime(CLOCK_REALTIME, &deadline);\n"
+                     "   deadline.tv_sec  += timeout_ms / 1000;\n"
+                     "   deadline.tv_nsec += (long) (timeout_ms %% 1000) * 1000000L;\n"
+                     "   if (deadline.tv_nsec >= 1000000000L) {\n"
+                     "      deadline.tv_sec  += 1;\n"
+                     "      deadline.tv_nsec -= 1000000000L;\n"
+                     "   }\n\n");
+
+    fprintf(code_id, "   //Wait until the previous event is handled\n"
+                     "   pthread_mutex_lock(&%s_event_lock);\n"
+                     "   while (%s_event_pending\n"
+                     "          && 0 == pthread_cond_timedwait(&%s_event_done, &%s_event_lock, &deadline))\n"
+                     "      ;\n"
+                     "   ready = !%s_event_pending;\n"
+                     "   pthread_mutex_unlock(&%s_event_lock);\n"
+                     "   if (!ready)\n"
+                     "      return 0;\n\n",
+                     fv->name, fv->name, fv->name, fv->name, fv->name,
+                     fv->name);
+
+    fprintf(code_id, "   //Then for a message, until the deadline\n"
+                     "   clock_gettime(CLOCK_REALTIME, &now);\n"
+                     "   timeout_ms = (int) ((deadline.tv_sec - now.tv_sec) * 1000\n"
+                     "                       + (deadline.tv_nsec - now.tv_nsec) / 1000000);\n"
+                     "   if (timeout_ms < 0)\n"
+                     "      timeout_ms = 0;\n");
+    if (get_context()->gui_shm) {
+        fprintf(code_id, "   ready = 0 == gui_shm_wait(%s_rings, GUI_SHM_RI, timeout_ms);\n",
+                         fv->name);
+    }
+    else {
+        fprintf(code_id, "   ready = poll(&queue, 1, timeout_ms) > 0;\n");
+    }
+    fprintf(code_id, "   if (ready) {\n"
+                     "      pthread_mutex_lock(&%s_event_lock);\n"
+                     "      %s_event_pending = 1;\n"
+                     "      pthread_mutex_unlock(&%s_event_lock);\n"
+                     "   }\n"
+                     "   return ready;\n"
+                     "}\n\n",
+                     fv->name, fv->name, fv->name);
+}
+
+
+
+
+//Generates the code that stores a PI message in the queue of the GUI or in the
+//queue of the Python mappers (or in the rings of the shared memory, --gui-shm)
+//
+//   fv_name    : [in] Name of the FV
+//   if_name    : [in] Name of the PI
+//   python     : [in] true for the queue of the Python mappers
+//   data       : [in] true if the PI has parameters (variable <if_name>__data)
+//
+static void create_message_write(char *fv_name, char *if_name,
+                                 bool python, bool data)
+{
+    char *content = data ? make_string("(void*)&%s__data", if_name)
+                         : make_string("NULL");
+
+    if (get_context()->gui_shm) {
+        fprintf(code_id,
+            "   gui_shm_push(%s_rings, GUI_SHM_PI%s, i_%s, %s, sizeof(T_%s__data));\n\n",
+            fv_name, python ? "_PYTHON" : "", if_name, content, if_name);
+    }
+    else {
+        fprintf(code_id,
+            "   write_message_to_queue(%s_PI%s_queue_id, sizeof(T_%s__data), %s, i_%s);\n\n",
+            fv_name, python ? "_Python" : "", if_name, content, if_name);
+    }
+    free(content);
+}
+
+
 
 //This function generates for a given Node (FV) the code that allows to send informations to the outside
 //application trough a didicated message queue.
@@ -688,37 +1175,27 @@ void create_outcomming_data_sender(FV * FV_NODE)
 
             //Call the queue manager to store the data
             if (strcmp (FV_NODE->name, "taste_probe_console")) {
-                fprintf(code_id,
-                "   write_message_to_queue(%s_PI_queue_id, sizeof(T_%s__data), (void*)&%s__data, i_%s);\n\n",
-                FV_NODE->name,
-                IF_list_iterator->value->name,
-                IF_list_iterator->value->name,
-                IF_list_iterator->value->name);
+                create_message_write(FV_NODE->name,
+                                     IF_list_iterator->value->name,
+                                     false, true);
             }
 
             // Same for the Python TM queue
-            fprintf(code_id,
-                "   write_message_to_queue(%s_PI_Python_queue_id, sizeof(T_%s__data), (void*)&%s__data, i_%s);\n\n",
-                FV_NODE->name,
-                IF_list_iterator->value->name,
-                IF_list_iterator->value->name,
-                IF_list_iterator->value->name);
+            create_message_write(FV_NODE->name,
+                                 IF_list_iterator->value->name,
+                                 true, true);
             } else {
             //No assignement code, as no parameters are associated to the current IF, thus
             //call directly the queue manager to store the data
                         if (strcmp (FV_NODE->name, "taste_probe_console")) {
-                fprintf(code_id,
-                "   write_message_to_queue(%s_PI_queue_id, sizeof(T_%s__data), NULL, i_%s);\n\n",
-                FV_NODE->name,
-                IF_list_iterator->value->name,
-                IF_list_iterator->value->name);
+                create_message_write(FV_NODE->name,
+                                     IF_list_iterator->value->name,
+                                     false, false);
             }
             // Same for the Python TM queue
-            fprintf(code_id,
-                "   write_message_to_queue(%s_PI_Python_queue_id, sizeof(T_%s__data), NULL, i_%s);\n\n",
-                FV_NODE->name,
-                IF_list_iterator->value->name,
-                IF_list_iterator->value->name);
+            create_message_write(FV_NODE->name,
+                                 IF_list_iterator->value->name,
+                                 true, false);
             }
 
             //Step 3 : Finalize
@@ -904,6 +1381,16 @@ int Init_GUI_Backend(FV * fv)
     //sprintf(enum_header_name, "%s_enums_def.h\0", NODE_NAME);
     create_file(path, enum_header_name, &enums_header_id);
 
+    if (get_context()->gui_shm) {
+        FILE *shm_header = NULL;
+        create_file(path, "gui_shm_ring.h", &shm_header);
+        fprintf(shm_header, "%s", do_not_modify_warning);
+        for (int k = 0; NULL != gui_shm_runtime[k]; k++) {
+            fprintf(shm_header, "%s", gui_shm_runtime[k]);
+        }
+        close_file(&shm_header);
+    }
+
     //Call the preamble function that will start to fill the created
     //files with global informations (types def, variable definitions...)
     gui_preamble(fv);
@@ -1085,12 +1572,19 @@ void End_GUI_Glue_Backend(FV * fv)
     fprintf(enums_header_id, "\n\n#endif\n");
 
     //Close the file containing enumerated types listing RI and PI
-    fclose(enums_header_id);
+    close_file(&enums_header_id);
 
 
     //Global variables for RI queue management
+    if (get_context()->gui_shm) {
+        fprintf(code_id, "\n//Rings of the incomming and outgoing messages\n");
+        fprintf(code_id, "static gui_shm_region *%s_rings = NULL;\n\n\n",
+                fv->name);
+    }
+    else {
     fprintf(code_id, "\n//Handle to the queue of incomming messages\n");
     fprintf(code_id, "static mqd_t    %s_RI_queue_id;\n\n\n", fv->name);
+    }
 
     //Define global variables for RI queue size management
     fprintf(code_id,
@@ -1098,12 +1592,14 @@ void End_GUI_Glue_Backend(FV * fv)
     fprintf(code_id, "int    %s_RI_max_msg_size = 0;\n\n\n", fv->name);
 
     //Global variables for PI queue management
+    if (!get_context()->gui_shm) {
     fprintf(code_id, "\n//Handle to the queue of incomming messages\n");
     fprintf(code_id, "static mqd_t    %s_PI_queue_id;\n\n\n", fv->name);
 
     /* MP 23/11/2009 : Adding a separate TM (PI) queue for the Python Mappers */
     fprintf(code_id, "static mqd_t    %s_PI_Python_queue_id;\n\n\n",
         fv->name);
+    }
 
     //Define global variables for PI queue size management
     fprintf(code_id,
@@ -1111,7 +1607,13 @@ void End_GUI_Glue_Backend(FV * fv)
     fprintf(code_id, "int    %s_PI_max_msg_size = 0;\n\n\n", fv->name);
 
     //Create the code for calling of the RI depending on the recieved messages
-    create_incomming_data_pooler(fv->name);
+    if (get_context()->gui_events || get_context()->gui_shm) {
+        create_incomming_data_listener(fv);
+        if (get_context()->gui_events)
+            create_gui_event_wait(fv);
+    }
+    else
+        create_incomming_data_pooler(fv->name);
 
     //Create the code to be called by the GUI designer to get infos from VM side
     create_outcomming_data_sender(fv);
@@ -1121,13 +1623,13 @@ void End_GUI_Glue_Backend(FV * fv)
 
     //Finalize header code file
     fprintf(header_id, "\n\n#endif\n");
-    fclose(header_id);
+    close_file(&header_id);
 
     //Create the queues management code for exchanging data with the outside
     create_gui_fv_queues(fv);
 
     //finalize code file
-    fclose(code_id);
+    close_file(&code_id);
 }
 
 
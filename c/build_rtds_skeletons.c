@@ -11,7 +11,6 @@
 #include <string.h>
 #include <sys/stat.h>   
 #include <assert.h>
-#include <unistd.h>
 
 #include "my_types.h"
 #include "practical_functions.h"
@@ -20,23 +19,66 @@
  *  RTDS project files are huge XML files.
  *  Rather than generating them from scratch, this backend
  *  creates a standard project from an existing template 
- *  (stored in header files), and makes a call to the 'sed'
- *  command to replace strings with the actual function names,
- *  signal list and procedure lists.
- *  Note: because we use the sed command, this cannot work on
- *  Windows (unless cygwin is installed)
+ *  (stored in header files), and replaces the placeholders
+ *  of the template with the actual function names, signal
+ *  list and procedure lists when the files are written.
 */
 
 #include "rtds_project_template.h"
 #include "rtds_process_template.h"
 #include "rtds_scheduled.h"
 
+/* Placeholder of a template and the string that replaces it */
+typedef struct {
+  const char *name;
+  const char *value;
+} Template_Value;
+
+/*
+ * Write a template in a file, replacing all occurrences of the
+ * placeholders (in a single pass: the values are not searched).
+ * The text between the placeholders is copied as is.
+ */
+static void Write_Template (FILE                 *file,
+                            const unsigned char  *text,
+                            size_t               size,
+                            const Template_Value *values,
+                            size_t               count)
+{
+  size_t start = 0, pos = 0, k, len = 0;
+
+  while (pos < size) {
+        for (k = 0; k < count; k++) {
+                len = strlen (values[k].name);
+                if (values[k].name[0] == text[pos] &&
+                    len <= size - pos &&
+                    !memcmp (text + pos, values[k].name, len)) {
+                        break;
+                }
+        }
+        if (k == count) {
+                pos++;
+                continue;
+        }
+        fwrite (text + start, 1, pos - start, file);
+        fputs (NULL != values[k].value ? values[k].value : "", file);
+        pos  += len;
+        start = pos;
+  }
+  fwrite (text + start, 1, size - start, file);
+}
+
 /* Create directories and static files */
-void Create_New_RTDS_Project (FV *fv)
+void Create_New_RTDS_Project (FV   *fv,
+                              char *inputline,
+                              char *outputline,
+                              char *sig_decl,
+                              char *proc_decl)
 {
   char *path            = NULL,
        *filename        = NULL,
-       *codegenpath     = NULL;
+       *codegenpath     = NULL,
+       *process_name    = NULL;
 
   FILE *project         = NULL, 
        *process         = NULL,
@@ -83,9 +125,42 @@ void Create_New_RTDS_Project (FV *fv)
             );
 
   /* Dump the project templates from the rtds header files */
-  fprintf (project,   "%s", rtds_project_template);
-  fprintf (process,   "%s", rtds_process_template);
-  fprintf (scheduled, "%s", rtds_scheduled);
+  process_name = make_string ("%s_process", fv->name);
+  {
+        const Template_Value project_values[] = {
+                { "MODELNAME",             fv->name     },
+                { "generated-process",     process_name },
+                { "CODEGENDIR",            fv->name     },
+                { "TEMPLATEDIR",           "../profile" }
+        };
+        const Template_Value process_values[] = {
+                { "MODELNAME",             fv->name     },
+                { "INPUTLINE",             inputline    },
+                { "OUTPUTLINE",            outputline   },
+                { "SIGNALS_DECLARATION",   sig_decl     },
+                { "PROCEDURE_DECLARATION", proc_decl    }
+        };
+        const Template_Value scheduled_values[] = {
+                { "MODELNAME",             fv->name     }
+        };
+
+        Write_Template (project,
+                        rtds_project_template,
+                        rtds_project_template_len,
+                        project_values,
+                        sizeof project_values / sizeof project_values[0]);
+        Write_Template (process,
+                        rtds_process_template,
+                        rtds_process_template_len,
+                        process_values,
+                        sizeof process_values / sizeof process_values[0]);
+        Write_Template (scheduled,
+                        rtds_scheduled,
+                        rtds_scheduled_len,
+                        scheduled_values,
+                        sizeof scheduled_values / sizeof scheduled_values[0]);
+  }
+  free (process_name);
 
   /*
    * Create a compile script to automate the process for the user
@@ -121,10 +196,10 @@ void Create_New_RTDS_Project (FV *fv)
         fv->name);
   fprintf (compile_script, "cd \"$curdir\"\n");
 
-  fclose (project);
-  fclose (process);
-  fclose (scheduled);
-  fclose (compile_script);
+  close_file (&project);
+  close_file (&process);
+  close_file (&scheduled);
+  close_file (&compile_script);
 
   filename = make_string ("%s/rtds_GenerateCodeForTASTE.sh", path);
   if (chmod (filename, S_IRWXG | S_IRWXO | S_IRWXU)) {
@@ -146,26 +221,14 @@ void GW_RTDS_Backend(FV *fv)
   char *inputline   = NULL,
        *outputline  = NULL,
        *sig_decl    = NULL,
-       *proc_decl   = NULL,
-       *path        = NULL,
-       *script_name = NULL;
-  FILE *script      = NULL;
+       *proc_decl   = NULL;
 
   if (fv->system_ast->context->onlycv) return;
 
   if (rtds == fv->language && fv->system_ast->context->gw) {
 
-#ifndef __unix__
-        printf("Warning: skeleton generation for RTDS works only on Linux/FreeBSD\n");
-#endif
-
         /*
-         * (1) Dump the template project files
-         */
-        Create_New_RTDS_Project (fv);
-
-        /*
-         * (2) Create strings to declare each interface
+         * (1) Create strings to declare each interface
          * The strings will be used to fill the project templates
          */
         FOREACH(i, Interface, fv->interfaces, {
@@ -184,7 +247,7 @@ void GW_RTDS_Backend(FV *fv)
                                              strlen(i->in->value->type));
                                 build_string (&sig_decl, ")", strlen(")"));
                         }
-                        build_string (&sig_decl, ";\\\n\\\n", strlen(";\\\n\\\n"));
+                        build_string (&sig_decl, ";\n\n", strlen(";\n\n"));
                 }
 
                 /*
@@ -220,13 +283,13 @@ void GW_RTDS_Backend(FV *fv)
                                              i->name, 
                                              strlen (i->name));
                                 build_string (&proc_decl, 
-                                             "(\\\n",
-                                             strlen("(\\\n"));
+                                             "(\n",
+                                             strlen("(\n"));
                                 FOREACH (p, Parameter, i->in, {
                                         if (p!=i->in->value) {
                                                 build_string (&proc_decl,
-                                                             ",\\\n",
-                                                             strlen (",\\\n"));
+                                                             ",\n",
+                                                             strlen (",\n"));
                                         }
                                         build_string (&proc_decl, 
                                                      "IN ",
@@ -242,12 +305,12 @@ void GW_RTDS_Backend(FV *fv)
                                 FOREACH (p, Parameter, i->out, {
                                         if (NULL != i->in || p!=i->out->value) {
                                                 build_string (&proc_decl,
-                                                             ",\\\n",
-                                                             strlen (",\\\n"));
+                                                             ",\n",
+                                                             strlen (",\n"));
                                         }
                                         build_string (&proc_decl, 
-                                                     "IN\\/OUT ",
-                                                     strlen ("IN\\/OUT "));
+                                                     "IN/OUT ",
+                                                     strlen ("IN/OUT "));
                                         build_string (&proc_decl,
                                                      p->name,
                                                      strlen (p->name));
@@ -257,157 +320,22 @@ void GW_RTDS_Backend(FV *fv)
                                                      strlen (p->type));
                                 })
                                 build_string (&proc_decl,
-                                             "\\\n) EXTERNAL;\\\n\\\n",
-                                             strlen ("\\\n) EXTERNAL;\\\n\\\n"));
+                                             "\n) EXTERNAL;\n\n",
+                                             strlen ("\n) EXTERNAL;\n\n"));
 
                         }
                 }
         })
-#ifndef __unix__
-        printf ("!! Non-Linux users, do the following:\n");
-        printf ("Open the generated RTDS project and set the process name to");
-        printf (" \"%s\"\n", fv->name);
-        printf ("Then in SDL text boxes add the following declarations:\n");
-        printf ("%s\n\n%s\n\n", 
-                NULL!=sig_decl? sig_decl: "", 
-                NULL!=proc_decl?proc_decl:"");
-        printf ("And fill the SDL connections:\nFrom ENV To %s with", fv->name);
-        printf ("[%s]\nand from %s to ENV with [%s]\n\n",
-                NULL != inputline? inputline: "",
-                fv->name,
-                NULL != outputline? outputline: "");
-#else
-        /*
-         * (3) Invoke sed to replace strings in the template files 
-         */
-        script_name = make_string ("./tmp_rtds_script_%s.sh", fv->name);
-        script  = fopen (script_name, "w");
-
-        assert (NULL != script);
-
-        path    = fv->system_ast->context->output;
-
-        /* Project template file: */
-        fprintf (script, "sed \'s,MODELNAME,%s,g\' %s%s/%s_project.rdp >_tmp && mv _tmp %s%s/%s_project.rdp\n\n", 
-                        fv->name, 
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s,generated-process,%s_process,g\' %s%s/%s_project.rdp >_tmp && mv _tmp %s%s/%s_project.rdp\n\n",
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s,CODEGENDIR,%s,g\' %s%s/%s_project.rdp >_tmp && mv _tmp %s%s/%s_project.rdp\n\n",
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s,TEMPLATEDIR,../profile,g\' %s%s/%s_project.rdp >_tmp && mv _tmp %s%s/%s_project.rdp\n\n",
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        /* Process template file: */
-        fprintf (script, "sed \'s,MODELNAME,%s,g\' %s%s/%s_process.rdd >_tmp && mv _tmp %s%s/%s_process.rdd\n\n",  
-                        fv->name, 
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s/INPUTLINE/%s/g\' %s%s/%s_process.rdd >_tmp && mv _tmp %s%s/%s_process.rdd\n\n",  
-                        NULL != inputline? inputline:"", 
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s/OUTPUTLINE/%s/g\' %s%s/%s_process.rdd >_tmp && mv _tmp %s%s/%s_process.rdd\n\n",  
-                        NULL != outputline? outputline: "", 
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s,SIGNALS_DECLARATION,%s,g\' %s%s/%s_process.rdd >_tmp && mv _tmp %s%s/%s_process.rdd\n\n",  
-                        NULL != sig_decl? sig_decl: "", 
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        fprintf (script, "sed \'s/PROCEDURE_DECLARATION/%s/g\' %s%s/%s_process.rdd >_tmp && mv _tmp %s%s/%s_process.rdd\n\n",  
-                        NULL != proc_decl? proc_decl: "", 
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        fv->name
-        );
-
-        /* Schedule template file */
-        fprintf (script, "sed \'s,MODELNAME,%s,g\' %s%s/scheduled.rdd >_tmp && mv _tmp %s%s/scheduled.rdd\n\n",
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name,
-                        NULL!=path?path:"",
-                        fv->name
-        );
-
-
-        fclose (script);
-
-        if (chmod (script_name, S_IRWXG | S_IRWXO | S_IRWXU)) {
-            fprintf (stderr, "Unable to change mode of RTDS script and make it executable\n");
-            exit (-1);
-        }
-
-        if (system(script_name)) {
-            fprintf (stderr, "Unable to run %s\n", script_name);
-            exit (-1);
-        }
 
         /*
-         * Delete the sed script
+         * (2) Dump the project files, with the strings in place of
+         * the placeholders of the templates
          */
-        if (!get_context()->test) {
-            unlink (script_name);
-        }
-        free (script_name);
-        script_name = NULL;
-#endif
+        Create_New_RTDS_Project (fv, inputline, outputline, sig_decl, proc_decl);
+
+        free (inputline);
+        free (outputline);
+        free (sig_decl);
+        free (proc_decl);
   }
 }
@@ -19,6 +19,8 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "symbol_table.h"
+#include "profile.h"
 
 /* Data shared by the functions of this module */
 
@@ -37,6 +39,8 @@ static Bus *bus = NULL;
 static Device *device = NULL;
 static Connection *connection = NULL;
 static char *search_name = NULL;
+/* Set once the unconnected RIs have been reported (Find_All_Calling_FV) */
+static bool connections_checked = false;
 static Device_list *drivers = NULL;
 
 /* Function returning a pointer to the system AST */
@@ -336,7 +340,7 @@ void Set_Context_Variable (char *name, size_t len1, char *type, size_t len2,
  Context_Parameter *cp = NULL;
  unsigned int i = 0;
 
- cp = (Context_Parameter *) malloc (sizeof (Context_Parameter));
+ Create_Context_Parameter (&cp);
 
  assert (NULL != cp);
 
@@ -472,6 +476,138 @@ void Set_Timer_Resolution(char *val, size_t len) {
     }
 }
 
+/* Period of the PI that reads the messages of the GUIs, and of their
+ * receivers (option --gui-events) */
+void Set_GUI_Period(char *val, size_t len) {
+    errno = 0;
+    if (NULL != (system_ast->context)) {
+        char *str = make_string("%.*s", len, val);
+        int period = (int) strtol(str, (char **)NULL, 10);
+        if (0 != errno || period < 1) {
+            ERROR("[ERROR] GUI period must be a positive number of ms\n");
+        }
+        else {
+            system_ast->context->gui_period = period;
+        }
+        free(str);
+    }
+}
+
+/* Generate timer managers based on a timing wheel (option --timer-wheel) */
+void Set_Timer_Wheel()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->timer_wheel = true;
+    }
+}
+
+/* Set the number of external tools (asn1.exe...) that may run in parallel */
+void Set_Jobs(char *val, size_t len) {
+    errno = 0;
+    if (NULL != (system_ast->context)) {
+        char *str = make_string("%.*s", len, val);
+        int jobs = (int) strtol(str, (char **)NULL, 10);
+        if (0 != errno || jobs < 1) {
+            ERROR("[ERROR] Number of jobs must be a positive number\n");
+        }
+        else {
+            system_ast->context->jobs = jobs;
+        }
+        free(str);
+    }
+}
+
+/* Record the time and memory used by each phase (option --profile) */
+void Set_Profile()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->profile = true;
+    }
+}
+
+/* Trace the RI calls in binary ring buffers (option --binary-msc) */
+void Set_Binary_MSC()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->binary_msc = true;
+    }
+}
+
+/* Call the co-located C/C++ functions directly (option --direct-calls) */
+void Set_Direct_Calls()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->direct_calls = true;
+    }
+}
+
+/* Generate the glue buffers in thread-local storage
+ * (option --thread-local-buffers) */
+void Set_Thread_Local_Buffers()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->thread_local_buffers = true;
+    }
+}
+
+/* Send the GUI messages as events to the GUI functions (option --gui-events) */
+void Set_GUI_Events()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->gui_events = true;
+    }
+}
+
+/* Exchange the GUI messages through shared memory (option --gui-shm) */
+void Set_GUI_Shm()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->gui_shm = true;
+    }
+}
+
+/* Stop if a partition is not schedulable (option --fail-unschedulable) */
+void Set_Fail_Unschedulable()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->fail_unschedulable = true;
+    }
+}
+
+/* Keep the calling threads of the Ada passive functions in task attributes
+ * instead of a protected stack (option --task-attributes) */
+void Set_Task_Attributes()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->task_attributes = true;
+    }
+}
+
+/* Encode the parameter of the async RIs of the threads directly in the
+ * PolyORB-HI-C request (option --direct-encode) */
+void Set_Direct_Encode()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->direct_encode = true;
+    }
+}
+
+/* Stop after the semantic checks (option --check-only) */
+void Set_Check_Only()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->check_only = true;
+    }
+}
+
+/* Only regenerate the glue code of the functions whose inputs changed
+ * since the last run (option --incremental) */
+void Set_Incremental()
+{
+    if (NULL != (system_ast->context)) {
+        system_ast->context->incremental = true;
+    }
+}
 
 /* Set Future - Flag that can be used for temporary purposes,
  * like when migrating from one TASTE version to another one when all
@@ -523,6 +659,28 @@ void Set_Stack(char *val, size_t len)
     build_string(&(system_ast->context->stacksize), val, len);
 }
 
+/* Set the file of the stack budget parameters (option --stack-config) */
+void Set_Stack_Config(char *val, size_t len)
+{
+    if (NULL == (system_ast->context))
+        return;
+    build_string(&(system_ast->context->stack_config), val, len);
+}
+
+/* Location of the function in the interface view (file:line:column) */
+void Set_FV_Location(char *location, size_t len)
+{
+    assert (NULL != fv);
+    build_string (&(fv->location), location, len);
+}
+
+/* Location of the current interface, to be called before End_IF */
+void Set_IF_Location(char *location, size_t len)
+{
+    if (NULL != interface)
+        build_string (&(interface->location), location, len);
+}
+
 void Set_Instance_Of(char *component, size_t len)
 {
     assert (0 < len && NULL != fv);
@@ -562,7 +720,7 @@ void New_Process(char *procname,
             process->cpu->name = make_string ("%s_%s",
                                               process->processor_board_name,
                                               old_cpu_name);
-            //free(old_cpu_name);
+            free(old_cpu_name);
         }
         process->coverage = coverage;
     }
@@ -575,7 +733,7 @@ void New_Processor (char *name,       size_t name_length,
                     char *cflags,     size_t cflags_length,
                     char *ldflags,    size_t ldflags_length)
 {
-    processor = malloc(sizeof(Processor));
+    Create_Processor(&processor);
     assert(NULL != processor);
 
     processor->name          = NULL;
@@ -606,7 +764,7 @@ void New_Processor (char *name,       size_t name_length,
 void New_Bus(char *name, size_t name_length, char *classifier,
                    size_t classifier_length)
 {
-    bus = malloc(sizeof(Bus));
+    Create_Bus(&bus);
     assert (NULL != bus);
 
         bus->name = NULL;
@@ -636,7 +794,7 @@ void New_Connection(char *src_system, size_t src_system_length,
                   dst_port_length = src_port_length;
     }
 
-   connection = malloc(sizeof(Connection));
+   Create_Connection(&connection);
    assert (NULL != connection);
 
    connection->src_system       = NULL;
@@ -690,7 +848,7 @@ void New_Device   (char *name,
                   char  *asn1_modulename,
                   size_t   asn1_modulename_length)
 {
-    device = malloc(sizeof(Device));
+    Create_Device(&device);
     assert (NULL != device);
 
     device->name                    = NULL;
@@ -893,6 +1051,14 @@ void New_Interface(char *name,         size_t length,
     if (NULL != distant_name) {
         build_string (&(interface->distant_name),
                       distant_name, dist_name_length);
+
+        /* Recent versions of TASTE-IV may qualify the name of the PI
+         * ("name.suffix"): only keep the name, otherwise the RI would not
+         * be connected (this used to be done during the preprocessing) */
+        if (RI == direction) {
+            char *res = strchr(interface->distant_name, '.');
+            if (NULL != res) *res = '\0';
+        }
     }
 
     /* Set the port name as the interface name, so that if later
@@ -990,6 +1156,10 @@ void Add_In_Param(char *name,     size_t l1,
     parameter->interface = interface;
     parameter->param_direction = param_in;
 
+    /* The parameter has its own copies of the converted strings */
+    free(type);
+    if (param_name != name) free(param_name);
+
     Add_Param(&parameter, &(interface->in));
 }
 
@@ -1017,6 +1187,10 @@ void Add_Out_Param(char *name, size_t l1,
     parameter->interface = interface;
     parameter->param_direction = param_out;
 
+    /* The parameter has its own copies of the converted strings */
+    free(type);
+    if (param_name != name) free(param_name);
+
     Add_Param(&parameter, &(interface->out));
 }
 
@@ -1065,7 +1239,7 @@ void End_IF()
     }
 
     /* Add new interface to the list contained in the Function definition */
-    APPEND_TO_LIST (Interface, fv->interfaces, interface);
+    Add_Interface_To_FV (fv, interface);
 }
 
 /* Last function to call: add the new FV to the System AST */
@@ -1088,8 +1262,16 @@ void End_FV()
             thread_runtime;}
     )
 
+    fv->position = (NULL == system_ast->functions) ?
+                   0 : LIST_COUNT(system_ast->functions);
+    Symbol_Table_Add(system_ast->fv_index, fv->name, fv);
     APPEND_TO_LIST(FV, system_ast->functions, fv);
 
+    /* The RIs connected to this function can now be resolved */
+    FOREACH(pi, Interface, fv->interfaces, {
+        Connect_Pending_RIs(pi);
+    });
+
     fv = NULL;
 }
 
@@ -1117,21 +1299,201 @@ void CompareFVname(FV * fv_local, FV ** result)
     }
 }
 
-/* main function to be called */
+/* main function to be called - functions are indexed by name in End_FV */
 FV *FindFV(char *fv_name)
 {
     FV *result_fv = NULL;
-    SetSearchName(fv_name);
-    FOREACH(f, FV, system_ast->functions, {
-        CompareFVname(f, &result_fv);
-    });
-    SetSearchName(NULL);
+
+    if (NULL == fv_name)
+        return NULL;
+
+    result_fv = Symbol_Table_Find(system_ast->fv_index, fv_name);
 
     return result_fv;
 }
 
 /* End Find FV functions */
 
+/* Add an interface to a function and keep the lookup indexes up to date.
+ * Interfaces must be named (and RIs connected) before they are added */
+void Add_Interface_To_FV(FV *function, Interface *i)
+{
+    assert (NULL != function && NULL != i);
+
+    APPEND_TO_LIST (Interface, function->interfaces, i);
+
+    if (NULL != i->name) {
+        Symbol_Table_Add(function->interface_index, i->name, i);
+    }
+    Index_RI(function, i);
+
+    /* PI added to a function that is already in the system */
+    if (PI == i->direction && function == FindFV(function->name)) {
+        Connect_Pending_RIs(i);
+    }
+}
+
+/* Key of the RI index: the function and the PI the RI is connected to
+ * ("function\nPI"). It is built in the buffer when it fits, to avoid an
+ * allocation for each lookup (the caller frees the key if it is not the
+ * buffer) */
+static char *RI_Key(char *buffer, size_t size,
+                    const char *fv_name, const char *pi_name)
+{
+    size_t fv_length = strlen(fv_name), pi_length = strlen(pi_name);
+
+    if (fv_length + pi_length + 2 > size) {
+        return make_string("%s\n%s", fv_name, pi_name);
+    }
+    memcpy(buffer, fv_name, fv_length);
+    buffer[fv_length] = '\n';
+    memcpy(buffer + fv_length + 1, pi_name, pi_length + 1);
+    return buffer;
+}
+
+static void Index_RI_By_Distant_Name(FV *function, Interface *i, bool refresh)
+{
+    char buffer[128], *key = NULL;
+
+    if (NULL == i->distant_fv || NULL == i->distant_name)
+        return;
+
+    key = RI_Key(buffer, sizeof(buffer), i->distant_fv, i->distant_name);
+    if (refresh) {
+        Symbol_Table_Set(function->ri_index, key, i);
+    }
+    else {
+        Symbol_Table_Add(function->ri_index, key, i);
+    }
+    if (key != buffer) free(key);
+}
+
+/* Index an RI by the name of the PI it is connected to, so that
+ * FindCorrespondingRI does not have to scan the interfaces of the caller.
+ * If several RIs of the function call the same PI, the first one is kept,
+ * as with the scan of the interfaces */
+void Index_RI(FV *function, Interface *i)
+{
+    if (RI != i->direction)
+        return;
+
+    Connect_RI(i);
+    Index_RI_By_Distant_Name(function, i, false);
+}
+
+/* Same as Index_RI, for an RI that the preprocessing rewired (or that was
+ * found in place of a rewired one): it replaces the indexed RI */
+void Reindex_RI(FV *function, Interface *i)
+{
+    if (RI != i->direction)
+        return;
+
+    Connect_RI(i);
+    Index_RI_By_Distant_Name(function, i, true);
+}
+
+/* Connection graph: each RI points to the PI it calls, and each PI has
+ * the list of RIs calling it. The connections are given by names
+ * (distant_fv, distant_name), and the called function may not be parsed
+ * yet: such RIs are kept in system_ast->pending_ris until End_FV. */
+
+/* True if the RI is (still) connected by name to the PI */
+static bool RI_Calls_PI(Interface *ri, Interface *pi)
+{
+    return NULL != ri->distant_fv && NULL != ri->distant_name &&
+           NULL != pi->name && NULL != pi->parent_fv &&
+           !strcmp(ri->distant_name, pi->name) &&
+           !strcmp(ri->distant_fv, pi->parent_fv->name);
+}
+
+static void Link_RI(Interface *ri, Interface *pi)
+{
+    ri->connected_pi = pi;
+    APPEND_TO_LIST(Interface, pi->calling_ris, ri);
+}
+
+static void Report_Unconnected_RI(Interface *ri)
+{
+    printf("[ERROR] Required Interface %s in function %s is not "
+           "connected. Glue code cannot be generated.\n",
+           ri->name, ri->parent_fv->name);
+    add_error();
+}
+
+/* (Re)connect an RI to its PI, after it was added or rewired */
+void Connect_RI(Interface *ri)
+{
+    FV        *callee = NULL;
+    Interface *pi = NULL;
+    char      *key = NULL;
+
+    assert (RI == ri->direction);
+
+    if (NULL != ri->connected_pi) {
+        REMOVE_FROM_LIST(Interface, ri->connected_pi->calling_ris, ri);
+        ri->connected_pi = NULL;
+    }
+
+    if (NULL == ri->distant_fv || NULL == ri->distant_name) {
+        if (connections_checked && NULL != ri->parent_fv
+            && false == ri->parent_fv->is_component_type) {
+            Report_Unconnected_RI(ri);
+        }
+        return;
+    }
+
+    callee = FindFV(ri->distant_fv);
+    if (NULL != callee) {
+        pi = FindInterface(callee, ri->distant_name);
+        if (NULL != pi && PI != pi->direction) {
+            /* An RI can have the same name as the PI */
+            pi = NULL;
+            FOREACH(i, Interface, callee->interfaces, {
+                if (NULL == pi && PI == i->direction && RI_Calls_PI(ri, i))
+                    pi = i;
+            });
+        }
+    }
+
+    if (NULL != pi && RI_Calls_PI(ri, pi)) {
+        Link_RI(ri, pi);
+    }
+    else {
+        Interface_list *pending = NULL;
+
+        key = make_string("%s\n%s", ri->distant_fv, ri->distant_name);
+        pending = Symbol_Table_Find(system_ast->pending_ris, key);
+        APPEND_TO_LIST(Interface, pending, ri);
+        Symbol_Table_Set(system_ast->pending_ris, key, pending);
+        free(key);
+    }
+}
+
+/* Connect the RIs that were waiting for a PI (called when the PI and its
+ * function are both in the system) */
+void Connect_Pending_RIs(Interface *pi)
+{
+    Interface_list *pending = NULL;
+    char           *key = NULL;
+
+    if (PI != pi->direction || NULL == pi->name || NULL == pi->parent_fv)
+        return;
+
+    key = make_string("%s\n%s", pi->parent_fv->name, pi->name);
+    pending = Symbol_Table_Find(system_ast->pending_ris, key);
+
+    if (NULL != pending) {
+        /* RIs rewired since they were put on hold are skipped */
+        FOREACH(ri, Interface, pending, {
+            if (NULL == ri->connected_pi && RI_Calls_PI(ri, pi)) {
+                Link_RI(ri, pi);
+            }
+        });
+        Symbol_Table_Set(system_ast->pending_ris, key, NULL);
+    }
+    free(key);
+}
+
 /* FindInterface of a given FV */
 void CompareIFname(Interface * i, Interface ** result)
 {
@@ -1147,6 +1509,18 @@ void CompareIFname(Interface * i, Interface ** result)
 Interface *FindInterface(FV * function, char *interface_name)
 {
     Interface *result = NULL;
+
+    if (NULL == interface_name)
+        return NULL;
+
+    result = Symbol_Table_Find(function->interface_index, interface_name);
+
+    /* The index is filled by Add_Interface_To_FV: if an interface was
+     * renamed after it was added, fall back to a scan of the list */
+    if (NULL != result && !strcmp(result->name, interface_name))
+        return result;
+
+    result = NULL;
     SetSearchName(interface_name);
     FOREACH(i, Interface, function->interfaces, {
             CompareIFname(i, &result);})
@@ -1167,6 +1541,8 @@ void CompareParName(Parameter * p, Parameter ** result)
     }
 }
 
+/* Parameter lists are bounded by the signature of a single interface
+ * (a handful of elements): they are not indexed */
 Parameter *FindInParameter(Interface *i, char *param_name)
 {
     Parameter *result = NULL;
@@ -1190,14 +1566,38 @@ Parameter *FindOutParameter(Interface * i, char *param_name)
 }
 
 /* Given a PI (from any function) and a known caller, find the corresponding
- * RI in the remote function
+ * RI in the remote function.
+ * As for the sets, the index is only used for functions with many
+ * interfaces: below the threshold the scan is faster than building the key
+ * and checking the indexed RI (see misc/lookup-bench.c)
 */
 Interface *FindCorrespondingRI(FV *remote, Interface *pi)
 {
+    Interface *result = NULL;
+    bool      indexed = LIST_COUNT(remote->interfaces) >= SET_INDEX_THRESHOLD;
+
+    if (indexed) {
+        char buffer[128],
+             *key = RI_Key(buffer, sizeof(buffer),
+                           pi->parent_fv->name, pi->name);
+
+        result = Symbol_Table_Find(remote->ri_index, key);
+        if (key != buffer) free(key);
+
+        /* Check that the indexed RI was not rewired since it was indexed */
+        if (NULL != result &&
+            NULL != result->distant_name && NULL != result->distant_fv &&
+            !strcmp (result->distant_name, pi->name) &&
+            !strcmp (result->distant_fv, pi->parent_fv->name)) {
+            return result;
+        }
+    }
+
     FOREACH (i, Interface, remote->interfaces, {
         if (RI == i->direction &&
             !strcmp (i->distant_name, pi->name) &&
             !strcmp (i->distant_fv, pi->parent_fv->name)) {
+            if (indexed) Reindex_RI(remote, i);
             return i;
         }
     });
@@ -1206,42 +1606,65 @@ Interface *FindCorrespondingRI(FV *remote, Interface *pi)
 
 /* End Find Interface functions */
 
-/* Return the list of FV calling a given PI
-   the conditions are, for each RI of each FV that :
-        - RI's distant name = PI's name
-        - RI's distant FV = PI's parent FV
-*/
+/* Sort callers in the order of the system functions */
+static int Compare_FV_Position(const void *a, const void *b)
+{
+    const FV *fv_a = *(FV * const *) a;
+    const FV *fv_b = *(FV * const *) b;
+
+    return (fv_a->position > fv_b->position) -
+           (fv_a->position < fv_b->position);
+}
+
+/* Return the list of FV calling a given PI (i.e. the functions of the
+ * RIs in the connection graph), in the order of the system functions.
+ * The first call also reports the RIs that are not connected. */
 FV_list *Find_All_Calling_FV(Interface * i)
 {
     FV_list *result = NULL;
-    bool match = false;
-
-    FOREACH (function, FV, system_ast->functions, {
-        match = false;
-        if (false == function->is_component_type) {
-            FOREACH(iface, Interface, function->interfaces, {
-                if (false == match) {
-                    if (RI == iface->direction) {
-                        if (iface->distant_name == NULL || iface->distant_fv == NULL) {
-                            printf("[ERROR] Required Interface %s in function %s is not "
-                                   "connected. Glue code cannot be generated.\n",
-                                   iface->name, function->name);
-                            add_error();
-                        }
+    FV      **callers = NULL;
+    size_t  count = 0;
+    size_t  j;
+
+    if (false == connections_checked) {
+        connections_checked = true;
+        FOREACH (function, FV, system_ast->functions, {
+            if (false == function->is_component_type) {
+                FOREACH(iface, Interface, function->interfaces, {
+                    if (RI == iface->direction &&
+                        (NULL == iface->distant_name ||
+                         NULL == iface->distant_fv)) {
+                        Report_Unconnected_RI(iface);
                     }
-                    if (NULL != iface->distant_name && NULL != i->name &&
-                        NULL != iface->distant_fv && NULL != i->parent_fv &&
-                        RI == iface->direction &&
-                        !strcmp (iface->distant_name, i->name) &&
-                        !strcmp (iface->distant_fv, i->parent_fv->name))
-                            match = true;
-                }
-            })
-        }
-        if (true == match) {
-            APPEND_TO_LIST (FV, result, function);
+                });
+            }
+        });
+    }
+
+    if (NULL == i->calling_ris)
+        return NULL;
+
+    callers = malloc(LIST_COUNT(i->calling_ris) * sizeof(FV *));
+    assert(NULL != callers);
+
+    FOREACH(ri, Interface, i->calling_ris, {
+        bool duplicate = false;
+        assert(ri->connected_pi == i);
+        if (false == ri->parent_fv->is_component_type) {
+            for (j = 0; j < count; j++) {
+                if (callers[j] == ri->parent_fv) duplicate = true;
+            }
+            if (false == duplicate) callers[count++] = ri->parent_fv;
         }
-    })
+    });
+
+    qsort(callers, count, sizeof(FV *), Compare_FV_Position);
+
+    for (j = 0; j < count; j++) {
+        APPEND_TO_LIST (FV, result, callers[j]);
+    }
+    free(callers);
+
     if (get_context()->test && NULL != result) {
         printf("\n[Interface %s in FV %s] is called by:\n",
                 i->name,
@@ -1257,13 +1680,17 @@ FV_list *Find_All_Calling_FV(Interface * i)
 /* First function to call to initialize the AST */
 void C_Init()
 {
+    Profile_Init();
     Create_System(&system_ast);
+    connections_checked = false;
 }
 
 /* Remove the current system AST from memory */
 void Delete_System_AST()
 {
     Clear_System(system_ast);
+    free(system_ast);
+    system_ast = NULL;
 }
 
 /* Get dataview file name based (same as dataview.aadl
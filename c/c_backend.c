@@ -16,17 +16,29 @@
  * The data structures for the C AST are defined in the file my_types.h
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <assert.h>
+#include <stdbool.h>
 
 #include <errno.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 #include "my_types.h"
 #include "practical_functions.h"
 #include "backends.h"
 #include "c_ast_construction.h"
+#include "tool_jobs.h"
+#include "arena.h"
+#include "ast_cache.h"
+#include "profile.h"
+#include "incremental.h"
 
 /* 
  * Fatal error counter
@@ -37,14 +49,184 @@ void add_error()
     error_count++;
 }
 
+/* Generate the glue code of one function */
+static void Glue_Backends(FV *fv)
+{
+    Profile_Begin("glue code", fv->name);
+    PROFILE_BACKEND(GLUE_OG_Backend, fv);
+    PROFILE_BACKEND(GLUE_RTDS_Backend, fv);
+    PROFILE_BACKEND(GLUE_MiniCV_Backend, fv);
+    PROFILE_BACKEND(GLUE_C_Backend, fv);
+    PROFILE_BACKEND(GLUE_GUI_Backend, fv);
+    PROFILE_BACKEND(GLUE_Ada_Wrappers_Backend, fv);
+    PROFILE_BACKEND(GLUE_C_Wrappers_Backend, fv);
+    PROFILE_BACKEND(GLUE_VT_Backend, fv);
+    PROFILE_BACKEND(GLUE_MicroPython_Backend, fv);
+    PROFILE_BACKEND(GLUE_ROS_Bridge_Backend, fv);
+    Profile_End();
+}
+
+typedef struct {
+    pid_t   pid;
+    int     pipe;   /* read end, to get the counters of the worker */
+    FV      *fv;
+} Glue_Worker;
+
+/* Worker is done: add its counters to ours and check its status */
+static bool Join_Glue_Worker(Glue_Worker *worker, int status)
+{
+    int    counts[2] = {0, 0};
+    size_t bytes = 0;
+
+    if (sizeof counts == read(worker->pipe, counts, sizeof counts)
+        && sizeof bytes == read(worker->pipe, &bytes, sizeof bytes)) {
+        Add_Output_Files_Count(counts[0], counts[1]);
+        Add_Output_Bytes_Count(bytes);
+        Profile_Receive(worker->pipe);
+    }
+    close(worker->pipe);
+    worker->pid = 0;
+
+    if (!WIFEXITED(status) || 0 != WEXITSTATUS(status)) {
+        ERROR("[ERROR] Glue code generation of function %s failed\n",
+              worker->fv->name);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Run the glue backends of all functions, using up to get_context()->jobs
+ * processes. The backends keep their state (output files, etc.) in static
+ * variables: each function is processed in a forked copy of buildsupport
+ * so that they do not interfere. The AST is not modified by the glue
+ * backends, hence the generated code is identical to a serial run.
+ */
+static void Parallel_Glue_Backends(FV_list *functions)
+{
+    int         max_jobs = get_context()->jobs;
+    int         running = 0;
+    bool        ok = true;
+    Glue_Worker *workers = calloc((size_t) max_jobs, sizeof(Glue_Worker));
+
+    assert(NULL != workers);
+
+    FV_list *next = functions;
+
+    while (NULL != next || running > 0) {
+        /* Start workers in the free slots */
+        for (int w = 0; w < max_jobs && NULL != next; w++) {
+            int fds[2];
+            FV *fv = next->value;
+
+            if (0 != workers[w].pid) continue;
+            next = next->next;
+            if (true == fv->is_component_type) continue;
+            if (Unchanged_Function(fv)) continue;
+
+            if (0 != pipe(fds)) {
+                ERROR("[ERROR] Could not create pipe (%s)\n",
+                      strerror(errno));
+                exit(-1);
+            }
+
+            /* Flush the output buffers, otherwise the child prints them too */
+            fflush(NULL);
+
+            workers[w].pid = fork();
+
+            if (0 == workers[w].pid) {
+                int    written = 0, unchanged = 0, counts[2];
+                size_t bytes = Get_Output_Bytes_Count();
+                size_t first_phase = Profile_Count();
+                size_t parent_files = Open_Files_Count();
+
+                close(fds[0]);
+                Get_Output_Files_Count(&written, &unchanged);
+                Glue_Backends(fv);
+                /* The files that the parent had open are written by the
+                 * parent: write only the ones of this function */
+                Close_Files_Opened_After(parent_files);
+                Get_Output_Files_Count(&counts[0], &counts[1]);
+                counts[0] -= written;
+                counts[1] -= unchanged;
+                bytes = Get_Output_Bytes_Count() - bytes;
+                if (sizeof counts != write(fds[1], counts, sizeof counts)
+                    || sizeof bytes != write(fds[1], &bytes, sizeof bytes)) {
+                    ERROR("[ERROR] Could not report the generated files\n");
+                }
+                Profile_Send(fds[1], first_phase);
+                fflush(NULL);
+                _exit(0);
+            }
+            else if (-1 == workers[w].pid) {
+                ERROR("[ERROR] Could not fork (%s)\n", strerror(errno));
+                exit(-1);
+            }
+
+            close(fds[1]);
+            workers[w].pipe = fds[0];
+            workers[w].fv = fv;
+            running++;
+        }
+
+        if (0 == running) continue;
+
+        int   status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+
+        if (-1 == pid) {
+            if (EINTR == errno) continue;
+            break;
+        }
+
+        for (int w = 0; w < max_jobs; w++) {
+            if (pid == workers[w].pid) {
+                ok = Join_Glue_Worker(&workers[w], status) && ok;
+                running--;
+                break;
+            }
+        }
+    }
+
+    free(workers);
+
+    if (false == ok) {
+        exit(-1);
+    }
+}
+
 /*:
  * Main function called after the Ada AADL parser has completed.
 */
 void C_End()
 {
+    Arena *arena = get_system_ast()->arena;
+
+    /* Save the parsed model for the next runs (option --cache) */
+    if (0 == error_count) {
+        Save_AST_Cache();
+    }
+
+    /* End of the "parsing" phase, opened by C_Init */
+    Profile_End();
+
     /* Perform semantic checks of the user input */
+    Arena_Phase(arena, "semantic checks");
+    Profile_Begin("semantic checks", NULL);
     Semantic_Checks();
 
+    /* Option --check-only: stop here (e.g. editors checking on each save) */
+    if (get_context()->check_only) {
+        Profile_End();
+        Profile_Report();
+        if (error_count > 0) {
+            fprintf(stderr, "\nFound %d errors\n", error_count);
+            exit(1);
+        }
+        exit(0);
+    }
+
     /*
      * OpenGEODE support:
      * Replace SDL language with Ada for building glue code
@@ -95,6 +277,7 @@ void C_End()
             }
         });
     });
+    Profile_End();
 
     /*
      * If Semantic errors have been found (errors in the user AADL models),
@@ -107,10 +290,13 @@ void C_End()
 
     else {
         /* Generation of the build script */
+        Profile_Begin("build script", NULL);
         Generate_Build_Script();
+        Profile_End();
 
         /* Skeleton-generation, if -gw flag is set. Done before the preprocesing backend
            which possibly creates additional functions */
+        Profile_Begin("skeletons", NULL);
         FOREACH(fv, FV, get_system_ast()->functions, {
             if (get_context()->gw && NULL != fv->zipfile && !get_context()->glue) {
                 printf ("[INFO] No skeleton is generated for function \"%s\"\n"
@@ -123,28 +309,29 @@ void C_End()
 
             if (get_context()->gw &&
                 (NULL == fv->zipfile || get_context()->glue)) {
-                    GW_SDL_Backend(fv);
-                    GW_Simulink_Backend(fv);
-                    GW_C_Backend(fv);
-                    GW_VDM_Backend(fv);
-                    GW_VHDL_Backend(fv);
-                    GW_Ada_Backend(fv);
-                    GW_SCADE_Backend(fv);
-                    GW_RTDS_Backend(fv);
-                    GW_Driver_Backend(fv);
-                    GW_MicroPython_Backend(fv);
+                    PROFILE_BACKEND(GW_SDL_Backend, fv);
+                    PROFILE_BACKEND(GW_Simulink_Backend, fv);
+                    PROFILE_BACKEND(GW_C_Backend, fv);
+                    PROFILE_BACKEND(GW_VDM_Backend, fv);
+                    PROFILE_BACKEND(GW_VHDL_Backend, fv);
+                    PROFILE_BACKEND(GW_Ada_Backend, fv);
+                    PROFILE_BACKEND(GW_SCADE_Backend, fv);
+                    PROFILE_BACKEND(GW_RTDS_Backend, fv);
+                    PROFILE_BACKEND(GW_Driver_Backend, fv);
+                    PROFILE_BACKEND(GW_MicroPython_Backend, fv);
             }
 
             /* Export to SMP2: generate glue code and Python AST */
             if (true == get_context()->smp2 && (false == fv->is_component_type)) {
-                GLUE_OG_Backend(fv);
-                GLUE_RTDS_Backend(fv);
-                GLUE_MiniCV_Backend(fv);
-                GLUE_C_Backend(fv);
+                PROFILE_BACKEND(GLUE_OG_Backend, fv);
+                PROFILE_BACKEND(GLUE_RTDS_Backend, fv);
+                PROFILE_BACKEND(GLUE_MiniCV_Backend, fv);
+                PROFILE_BACKEND(GLUE_C_Backend, fv);
                 Generate_Python_AST(get_system_ast(), NULL);
 
             }
         })
+        Profile_End();
 
 
         /*
@@ -152,7 +339,25 @@ void C_End()
          * Various model tranformations of the interface view
          */
         if (get_context()->glue) {
+            Arena_Phase(arena, "preprocessing");
+            Profile_Begin("preprocessing", NULL);
             Preprocessing_Backend(get_system_ast());
+            Profile_End();
+
+            /* Priorities of the threads and response-time analysis */
+            Profile_Begin("schedulability", NULL);
+            Schedulability_Analysis(get_system_ast());
+            Profile_End();
+
+            /* Stack size of the threads */
+            Profile_Begin("stack sizes", NULL);
+            Stack_Analysis(get_system_ast());
+            Profile_End();
+
+            /* Names of the functions and interfaces in the binary traces */
+            if (get_context()->binary_msc) {
+                Generate_MSC_Trace_Ids(get_system_ast());
+            }
         }
         /*
          * Preprocessing may have raised some further semantic errors.
@@ -170,9 +375,16 @@ void C_End()
             Dump_model(get_system_ast());
         }
 
+        /* Option --incremental: find the functions that did not change */
+        if (get_context()->glue) {
+            Load_Manifest(get_system_ast());
+        }
+
         /*
          * Execute various backends applicable to each FV
          */
+        Arena_Phase(arena, "backends");
+        Profile_Begin("backends", NULL);
         FOREACH(fv, FV, get_system_ast()->functions, {
             if (false == fv->is_component_type) {
                 /*
@@ -181,34 +393,32 @@ void C_End()
                  * the only place where the glue code is requested
                  */
                 if (get_context()->gw && !get_context()->glue && NULL == fv->zipfile) {
-                    Call_asn2dataModel(fv);
+                    PROFILE_BACKEND(Call_asn2dataModel, fv);
                 }
 
                 /* Process all functional states declared in the interface view */
                 if (get_context()->gw && (NULL == fv->zipfile || get_context()->glue)) {
-                    Process_Context_Parameters(fv);
+                    PROFILE_BACKEND(Process_Context_Parameters, fv);
                 }
 
                 /* Process function directives */
                 if (get_context()->glue || get_context()->test) {
-                    Process_Directives (fv);
+                    PROFILE_BACKEND(Process_Directives, fv);
                 }
 
-                if (get_context()->glue) {
-                    GLUE_OG_Backend(fv);
-                    GLUE_RTDS_Backend(fv);
-                    GLUE_MiniCV_Backend(fv);
-                    GLUE_C_Backend(fv);
-                    GLUE_GUI_Backend(fv);
-                    GLUE_Ada_Wrappers_Backend(fv);
-                    GLUE_C_Wrappers_Backend(fv); 
-                    GLUE_VT_Backend(fv);
-                    GLUE_MicroPython_Backend(fv);
-                    GLUE_ROS_Bridge_Backend(fv);
+                if (get_context()->glue && get_context()->jobs <= 1
+                    && !Unchanged_Function(fv)) {
+                    Glue_Backends(fv);
                 }
             }
         })
 
+        /* With --jobs, generate the glue code of several functions at once */
+        if (get_context()->glue && get_context()->jobs > 1) {
+            Parallel_Glue_Backends(get_system_ast()->functions);
+        }
+        Profile_End();
+
         /*
          * Perform the second part of the Vertical transformation:
          * Generate driver configuration
@@ -216,18 +426,54 @@ void C_End()
          * Additionnally create an AADL file of the concurrency view
          * for display only in TASTE-IV
          */
+        bool unchanged_system = get_context()->glue && Unchanged_System();
+
             if (get_context()->glue) {
+                Profile_Begin("concurrency view", NULL);
                 FOREACH (process, Process, get_system_ast()->processes, {
                     Process_Driver_Configuration (process);
                 })
 
-                Generate_Full_ConcurrencyView((get_system_ast()->processes),
-                                             (get_system_ast()->name));
-                AADL_CV_Unparser ();
+                if (!unchanged_system) {
+                    Generate_Full_ConcurrencyView((get_system_ast()->processes),
+                                                 (get_system_ast()->name));
+                    AADL_CV_Unparser ();
+                }
+                Profile_End();
             }
 
         /* Generation of system configuration used by C_ASN1_Types.h */
-        System_Config(get_system_ast());
+        if (!unchanged_system) {
+            Profile_Begin("system config", NULL);
+            System_Config(get_system_ast());
+            Profile_End();
+        }
+
+        /* Write the generated files that changed since the last run */
+        Profile_Begin("output files", NULL);
+        Output_Files_Summary();
+        if (get_context()->glue) {
+            Save_Manifest();
+        }
+        Profile_End();
+
+        /*
+         * Call the external tools (asn2dataModel, asn1.exe) requested by
+         * the backends - identical calls are made only once
+         */
+        Profile_Begin("external tools", NULL);
+        Run_Tool_Jobs();
+        Profile_End();
+
+        /* Option --profile: report the time and memory used by each phase */
+        Profile_Report();
+
+        /* Test mode: report the memory used by the AST */
+        if (get_context()->test) {
+            Arena_Report(arena);
+        }
 
+        /* Release the AST in one go */
+        Delete_System_AST();
     }
 }
@@ -18,8 +18,9 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "text_builder.h"
 
-static FILE *h = NULL, *cfile = NULL;
+static Text_Builder *h = NULL, *cfile = NULL;
 
 /* Adds header to files */
 void c_wrappers_preamble(FV * fv)
@@ -39,12 +40,12 @@ void c_wrappers_preamble(FV * fv)
 
     /* a. header file preamble */
 
-    fprintf(h, "%s"
-               "#ifndef %s_POLYORB_INTERFACE\n"
-               "#define %s_POLYORB_INTERFACE\n",
-               do_not_modify_warning,
-               fv->name,
-               fv->name);
+    Text_Printf(h, "%s"
+                   "#ifndef %s_POLYORB_INTERFACE\n"
+                   "#define %s_POLYORB_INTERFACE\n",
+                   do_not_modify_warning,
+                   fv->name,
+                   fv->name);
 
     /* Generates #include "types.h" (in Ada:PolyORB_HI.Generated.Types)
      * IF at least one async IF has a param */
@@ -54,18 +55,18 @@ void c_wrappers_preamble(FV * fv)
         }
     });
 
-    fprintf (h, "#include <stddef.h>\n\n");
+    Text_Printf(h, "#include <stddef.h>\n\n");
 
     if (hasparam) {
-        fprintf (h, "#include \"types.h\"\n");
-        fprintf(cfile, "#include \"po_hi_gqueue.h\"\n");
+        Text_Printf(h, "#include \"types.h\"\n");
+        Text_Printf(cfile, "#include \"po_hi_gqueue.h\"\n");
     }
 
     /* Note: if user code is in Ada, from C it is not possible to make it
      * execute its elaboration. It must be WITH'd from an Ada source */
 
-    fprintf(h, "#include \"deployment.h\"\n"
-               "#include \"po_hi_transport.h\"\n");
+    Text_Printf(h, "#include \"deployment.h\"\n"
+                   "#include \"po_hi_transport.h\"\n");
 
 
     /* For each sync RI, include the distant (sync) wrapper
@@ -73,9 +74,9 @@ void c_wrappers_preamble(FV * fv)
        of the file */
     FOREACH(i, Interface, fv->interfaces, {
         if (RI == i->direction && synch == i->synchronism) {
-            fprintf(h, "#include \"../../%s/%s_polyorb_interface.h\"\n",
-                       i->distant_fv,
-                       i->distant_fv);
+            Text_Printf(h, "#include \"../../%s/%s_polyorb_interface.h\"\n",
+                           i->distant_fv,
+                           i->distant_fv);
         }
     });
 
@@ -108,20 +109,20 @@ void c_wrappers_preamble(FV * fv)
                 }
             });
             if (result) {
-                fprintf(h,
-                        "#include \"../../%s/%s_polyorb_interface.h\"\n",
-                        ct->name, ct->name);
+                Text_Printf(h,
+                            "#include \"../../%s/%s_polyorb_interface.h\"\n",
+                            ct->name, ct->name);
             }
         });
     }
 
     /* body file preamble */
-    fprintf(cfile, "%s"
-                   "#include \"%s_polyorb_interface.h\"\n\n"
-                   "#include \"activity.h\"\n"
-                   "#include \"types.h\"\n",
-                   do_not_modify_warning,
-                   fv->name);
+    Text_Printf(cfile, "%s"
+                       "#include \"%s_polyorb_interface.h\"\n\n"
+                       "#include \"activity.h\"\n"
+                       "#include \"types.h\"\n",
+                       do_not_modify_warning,
+                       fv->name);
 
     /* If this function has protected PI, include POHIC semaphore header */
     if (passive_runtime == fv->runtime_nature) {
@@ -130,12 +131,12 @@ void c_wrappers_preamble(FV * fv)
             if (PI == i->direction && protected == i->rcm) haspro = 1;
         });
         if (haspro) {
-            fprintf(cfile, "#include \"po_hi_protected.h\"\n\n");
+            Text_Printf(cfile, "#include \"po_hi_protected.h\"\n\n");
         }
     }
 
     /* Include polyorb-hi header containing po_hi_get_task_id */
-    fprintf(cfile, "#include \"po_hi_task.h\"\n");
+    Text_Printf(cfile, "#include \"po_hi_task.h\"\n");
 
     /* Include the header files to get the function prototypes */
     if (!fv->artificial) {
@@ -143,17 +144,17 @@ void c_wrappers_preamble(FV * fv)
                 && simulink != fv->language
                 && qgenc    != fv->language
                 && vhdl     !=  fv->language) {
-            fprintf (cfile, "#include \"%s_vm_if.h\"\n\n", fv->name);
+            Text_Printf(cfile, "#include \"%s_vm_if.h\"\n\n", fv->name);
         }
         else if(simulink != fv->language
                 && qgenc != fv->language
                 && vhdl  != fv->language) {
-            fprintf (cfile, "#include \"%s.h\"\n\n", fv->name);
+            Text_Printf(cfile, "#include \"%s.h\"\n\n", fv->name);
         }
         else if (simulink == fv->language && NULL != fv->interfaces) {
             Interface *simulink_entrypoint = fv->interfaces->value;
-            fprintf (cfile, "#include \"%s_Simulink.Simulink.h\"\n\n",
-                            simulink_entrypoint->name);
+            Text_Printf(cfile, "#include \"%s_Simulink.Simulink.h\"\n\n",
+                               simulink_entrypoint->name);
         }
     }
 }
@@ -175,11 +176,11 @@ int Init_C_Wrappers_Backend(FV * fv)
 
     /* create .c file */
     sprintf(filename, "%s_polyorb_interface.c", fv->name);
-    create_file(path, filename, &cfile);
+    cfile = Create_Text_File(path, filename);
 
     /* create .h file */
     sprintf(filename, "%s_polyorb_interface.h", fv->name);
-    create_file(path, filename, &h);
+    h = Create_Text_File(path, filename);
 
     free(filename);
 
@@ -195,8 +196,8 @@ int Init_C_Wrappers_Backend(FV * fv)
 
 void close_c_wrappers()
 {
-    close_file(&cfile);
-    close_file(&h);
+    Close_Text_File(&cfile);
+    Close_Text_File(&h);
 }
 
 /*
@@ -210,98 +211,161 @@ void add_sync_PI_to_c_wrappers(Interface * i)
         return;
 
     /* header file : declare the function  */
-    fprintf(h, "/*----------------------------------------------------\n"
-               "-- %srotected Provided Interface \"%s\"\n"
-               "----------------------------------------------------*/\n"
+    Text_Printf(h, "/*----------------------------------------------------\n"
+                   "-- %srotected Provided Interface \"%s\"\n"
+                   "----------------------------------------------------*/\n"
 
-               "void sync_%s_%s(",
-               protected == i->rcm ? "P" : "Unp", i->name,
-               i->parent_fv->name,
-               i->name);
+                   "void sync_%s_%s(",
+                   protected == i->rcm ? "P" : "Unp", i->name,
+                   i->parent_fv->name,
+                   i->name);
 
     bool comma = false;
     FOREACH(p, Parameter, i->in, {
         (void) p;
-        fprintf(h, "%svoid *, size_t", comma? ", ": "");
-        comma = true;
+        Text_Separator(h, &comma, ", ");
+        Text_Printf(h, "void *, size_t");
     });
 
     FOREACH(p, Parameter, i->out, {
         (void) p;
-        fprintf(h, "%svoid *, size_t *", comma? ", ": "");
-        comma = true;
+        Text_Separator(h, &comma, ", ");
+        Text_Printf(h, "void *, size_t *");
     });
 
-    fprintf(h, ");\n\n");
+    Text_Printf(h, ");\n\n");
 
     /* body file : declare the function */
-    fprintf(cfile,
-            "/*----------------------------------------------------\n"
-            "-- %srotected Provided Interface \"%s\"\n"
-            "----------------------------------------------------*/\n"
+    Text_Printf(cfile,
+                "/*----------------------------------------------------\n"
+                "-- %srotected Provided Interface \"%s\"\n"
+                "----------------------------------------------------*/\n"
 
-            "void sync_%s_%s(",
-            protected == i->rcm ? "P" : "Unp",
-            i->name,
-            i->parent_fv->name,
-            i->name);
+                "void sync_%s_%s(",
+                protected == i->rcm ? "P" : "Unp",
+                i->name,
+                i->parent_fv->name,
+                i->name);
 
     comma = false;
     FOREACH(p, Parameter, i->in, {
-            fprintf(cfile, "%svoid *%s, size_t %s_len",
-                           comma? ", ": "",
-                           p->name,
-                           p->name);
-            comma = true;
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "void *%s, size_t %s_len", p->name, p->name);
     });
 
     FOREACH(p, Parameter, i->out, {
-        fprintf(cfile, "%svoid *%s, size_t *%s_len",
-                       comma? ", ": "",
-                       p->name,
-                       p->name);
-        comma = true;
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "void *%s, size_t *%s_len", p->name, p->name);
     });
 
-    fprintf(cfile, ")\n{\n");
+    Text_Printf(cfile, ")\n{\n");
 
     /* body of the function: */
     if (protected == i->rcm) {
-        fprintf(cfile, "   extern %staste_protected_object %s_protected;\n",
-                       get_context()->aadlv2 ? "process_package__" : "",
-                       i->parent_fv->name);
-        fprintf(cfile,
-                "   __po_hi_protected_lock (%s_protected.protected_id);\n",
-                i->parent_fv->name);
+        Text_Printf(cfile, "   extern %staste_protected_object %s_protected;\n",
+                           get_context()->aadlv2 ? "process_package__" : "",
+                           i->parent_fv->name);
+        Text_Printf(cfile,
+                    "   __po_hi_protected_lock (%s_protected.protected_id);\n",
+                    i->parent_fv->name);
     }
 
-    fprintf(cfile, "   %s_%s(", i->parent_fv->name, i->name);
+    Text_Printf(cfile, "   %s_%s(", i->parent_fv->name, i->name);
 
+    comma = false;
     FOREACH(p, Parameter, i->in, {
-        fprintf(cfile, "%s%s, %s_len", p == i->in->value ? "" : ", ",
-                       p->name, p->name);
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "%s, %s_len", p->name, p->name);
+    });
+
+    FOREACH(p, Parameter, i->out, {
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "%s, %s_len", p->name, p->name);
     });
 
-    if (NULL != i->in && NULL != i->out) {
-        fprintf(cfile, ", ");
+    Text_Printf(cfile, ");\n");
+
+    if (protected == i->rcm) {
+        Text_Printf(cfile,
+                    "   __po_hi_protected_unlock (%s_protected.protected_id);\n",
+                    i->parent_fv->name);
     }
 
+    Text_Printf(cfile, "}\n\n");
+}
+
+/*
+   Option --direct-calls: add a typed entry point to a synchronous PI, for
+   the C/C++ functions of the same partition. The parameters are passed
+   to the user code without encoding, the protected PIs still take the lock.
+*/
+void add_direct_PI_to_c_wrappers(Interface * i)
+{
+    bool direct = false;
+    bool comma = false;
+
+    if (NULL == cfile)
+        return;
+
+    FOREACH(ri, Interface, i->calling_ris, {
+        if (i == Direct_Call_Target(ri)) direct = true;
+    });
+    if (!direct)
+        return;
+
+    /* Callers declare the function themselves, as for the vm_ functions */
+    Text_Printf(cfile,
+                "/*----------------------------------------------------\n"
+                "-- Direct call to \"%s\" from the same partition\n"
+                "----------------------------------------------------*/\n"
+                "void sync_direct_%s_%s(",
+                i->name,
+                i->parent_fv->name,
+                i->name);
+
+    FOREACH(p, Parameter, i->in, {
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "const asn1Scc%s *IN_%s", p->type, p->name);
+    });
+
     FOREACH(p, Parameter, i->out, {
-        fprintf(cfile, "%s%s, %s_len",
-                       p == i->out->value ? "" : ", ",
-                       p->name,
-                       p->name);
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "asn1Scc%s *OUT_%s", p->type, p->name);
     });
 
-    fprintf(cfile, ");\n");
+    Text_Printf(cfile, "%s)\n{\n", comma? "": "void");
 
     if (protected == i->rcm) {
-        fprintf(cfile,
-                "   __po_hi_protected_unlock (%s_protected.protected_id);\n",
-                i->parent_fv->name);
+        Text_Printf(cfile, "   extern %staste_protected_object %s_protected;\n",
+                           get_context()->aadlv2 ? "process_package__" : "",
+                           i->parent_fv->name);
+        Text_Printf(cfile,
+                    "   __po_hi_protected_lock (%s_protected.protected_id);\n",
+                    i->parent_fv->name);
     }
 
-    fprintf(cfile, "}\n\n");
+    Text_Printf(cfile, "   %s_PI_%s(", i->parent_fv->name, i->name);
+
+    comma = false;
+    FOREACH(p, Parameter, i->in, {
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "IN_%s", p->name);
+    });
+
+    FOREACH(p, Parameter, i->out, {
+        Text_Separator(cfile, &comma, ", ");
+        Text_Printf(cfile, "OUT_%s", p->name);
+    });
+
+    Text_Printf(cfile, ");\n");
+
+    if (protected == i->rcm) {
+        Text_Printf(cfile,
+                    "   __po_hi_protected_unlock (%s_protected.protected_id);\n",
+                    i->parent_fv->name);
+    }
+
+    Text_Printf(cfile, "}\n\n");
 }
 
 /*
@@ -316,40 +380,40 @@ void add_async_PI_to_c_wrappers(Interface * i)
         return;
 
     /* header file : declare the function */
-    fprintf(h, "/*----------------------------------------------------\n"
-               "-- Asynchronous Provided Interface \"%s\"\n"
-               "----------------------------------------------------*/\n"
+    Text_Printf(h, "/*----------------------------------------------------\n"
+                   "-- Asynchronous Provided Interface \"%s\"\n"
+                   "----------------------------------------------------*/\n"
 
-               "void po_hi_c_%s_%s(__po_hi_task_id",
-               i->name,
-               i->parent_fv->name,
-               pi_name);
+                   "void po_hi_c_%s_%s(__po_hi_task_id",
+                   i->name,
+                   i->parent_fv->name,
+                   pi_name);
 
     if (NULL != i->in) {
-        fprintf(h, ", dataview__%s_buffer_impl",
-                   string_to_lower(i->in->value->type));
+        Text_Printf(h, ", dataview__%s_buffer_impl",
+                       string_to_lower(i->in->value->type));
     }
 
-    fprintf(h, ");\n\n");
+    Text_Printf(h, ");\n\n");
 
     /* body file : define the function */
-    fprintf(cfile,
-            "/* ------------------------------------------------------\n"
-            "-- Asynchronous Provided Interface \"%s\"\n"
-            "------------------------------------------------------ */\n"
+    Text_Printf(cfile,
+                "/* ------------------------------------------------------\n"
+                "-- Asynchronous Provided Interface \"%s\"\n"
+                "------------------------------------------------------ */\n"
 
-            "void po_hi_c_%s_%s(__po_hi_task_id e",
-            i->name,
-            i->parent_fv->name,
-            pi_name);
+                "void po_hi_c_%s_%s(__po_hi_task_id e",
+                i->name,
+                i->parent_fv->name,
+                pi_name);
 
     if (NULL != i->in) {
-        fprintf(cfile, ", dataview__%s_buffer_impl buf",
-                       string_to_lower(i->in->value->type));
+        Text_Printf(cfile, ", dataview__%s_buffer_impl buf",
+                           string_to_lower(i->in->value->type));
     }
 
-    fprintf(cfile, ")\n{\n");
-    fprintf(cfile, "    (void)e;\n");
+    Text_Printf(cfile, ")\n{\n");
+    Text_Printf(cfile, "    (void)e;\n");
 
     /* Then 2 options:
        1) either we are in a thread created by the VT, in which case the PI
@@ -366,88 +430,130 @@ void add_async_PI_to_c_wrappers(Interface * i)
                 distant_fv = interface->distant_fv;
             }
         });
-        fprintf(cfile, "   sync_%s_%s (",
-                       distant_fv,
-                       i->distant_name);
+        Text_Printf(cfile, "   sync_%s_%s (",
+                           distant_fv,
+                           i->distant_name);
     } else {
-        fprintf(cfile, "   %s_%s(", i->parent_fv->name, i->name);
+        Text_Printf(cfile, "   %s_%s(", i->parent_fv->name, i->name);
     }
     if (NULL != i->in) {
-        fprintf(cfile, "buf.buffer, buf.length");
+        Text_Printf(cfile, "buf.buffer, buf.length");
     }
-    fprintf(cfile, ");\n}\n\n");
+    Text_Printf(cfile, ");\n}\n\n");
     free(pi_name);
 }
 
+/*
+ * Option --direct-encode: the caller (invoke_ri.c) gets the buffer of the
+ * request of the RI, encodes its parameter in it, and sends it. This saves
+ * the intermediate buffer of invoke_ri.c and the copy to the request.
+ * Only the thread calls its RIs (see Direct_Encode), and the request is
+ * copied in the queue by store_out: it can be a static variable.
+ */
+static void add_direct_encode_RI_to_c_wrappers(Interface * i)
+{
+    char *ri_name = string_to_lower(i->name);
+    char *port    = make_string("%s_global_outport_%s",
+                                i->parent_fv->name, ri_name);
+
+    Text_Printf(h,
+                "void *vm_async_%s_%s_buffer(size_t *size);\n"
+                "void vm_async_%s_%s_send(size_t length);\n",
+                i->parent_fv->name, i->name,
+                i->parent_fv->name, i->name);
+
+    Text_Printf(cfile,
+                "/* Request of the RI \"%s\": the parameter is encoded in it */\n"
+                "static __po_hi_request_t request_%s;\n\n"
+                "void *vm_async_%s_%s_buffer(size_t *size)\n"
+                "{\n"
+                "   *size = sizeof(request_%s.vars.%s.%s.buffer);\n"
+                "   return &(request_%s.vars.%s.%s.buffer);\n"
+                "}\n\n",
+                i->name,
+                ri_name,
+                i->parent_fv->name, i->name,
+                ri_name, port, port,
+                ri_name, port, port);
+
+    Text_Printf(cfile,
+                "void vm_async_%s_%s_send(size_t length)\n"
+                "{\n"
+                "   request_%s.vars.%s.%s.length = length;\n"
+                "   request_%s.port = %s;\n"
+                "   __po_hi_gqueue_store_out("
+                "%s_%s_k, %s_local_outport_%s, &request_%s);\n"
+                "   __po_hi_send_output(%s_%s_k, %s);\n"
+                "}\n\n",
+                i->parent_fv->name, i->name,
+                ri_name, port, port,
+                ri_name, port,
+                i->parent_fv->process->identifier, i->parent_fv->name,
+                i->parent_fv->name, ri_name, ri_name,
+                i->parent_fv->process->identifier, i->parent_fv->name, port);
+
+    free(port);
+    free(ri_name);
+}
+
 /* Add a RI */
 void add_RI_to_c_wrappers(Interface * i)
 {
-    FILE *s = h, *b = cfile;
+    Text_Builder *s = h, *b = cfile;
+    bool         comma = false;
 
     if (NULL == s || NULL == b)
         return;
 
     /* b. header : declare the function */
-    fprintf(s,
-            "/* ------------------------------------------------------\n");
-    fprintf(s, "--  %s Required Interface \"%s\"\n",
-               asynch == i->synchronism ? "Asynchronous" : "Synchronous",
-               i->name);
-    fprintf(s, "------------------------------------------------------ */\n");
-
-    fprintf(s, "void vm_%s%s_%s(",
-               asynch == i->synchronism ? "async_" : "",
-               i->parent_fv->name,
-               i->name);
+    Text_Printf(s,
+                "/* ------------------------------------------------------\n");
+    Text_Printf(s, "--  %s Required Interface \"%s\"\n",
+                   asynch == i->synchronism ? "Asynchronous" : "Synchronous",
+                   i->name);
+    Text_Printf(s, "------------------------------------------------------ */\n");
+
+    Text_Printf(s, "void vm_%s%s_%s(",
+                   asynch == i->synchronism ? "async_" : "",
+                   i->parent_fv->name,
+                   i->name);
 
     FOREACH(p, Parameter, i->in, {
-        fprintf(s, "%svoid *%s, size_t %s_len",
-                   p == i->in->value ? "" : ", ",
-                   p->name,
-                   p->name);
+        Text_Separator(s, &comma, ", ");
+        Text_Printf(s, "void *%s, size_t %s_len", p->name, p->name);
     });
 
-    if (NULL != i->in && NULL != i->out) {
-        fprintf(s, ", ");
-    }
-
     FOREACH(p, Parameter, i->out, {
-        fprintf(s, "%svoid *, size_t *",
-                   p == i->out->value ? "" : ", ");
+        (void) p;
+        Text_Separator(s, &comma, ", ");
+        Text_Printf(s, "void *, size_t *");
     });
 
-    fprintf(s, ");\n");
+    Text_Printf(s, ");\n");
 
     /* c. code : definition of the function */
-    fprintf(b,
-            "/* ------------------------------------------------------\n"
-            "--  %s Required Interface \"%s\"\n"
-            "------------------------------------------------------ */\n"
-            "void vm_%s%s_%s(",
-            asynch == i->synchronism ? "Asynchronous" : "Synchronous",
-            i->name,
-            asynch == i->synchronism ? "async_" : "", i->parent_fv->name,
-            i->name);
+    Text_Printf(b,
+                "/* ------------------------------------------------------\n"
+                "--  %s Required Interface \"%s\"\n"
+                "------------------------------------------------------ */\n"
+                "void vm_%s%s_%s(",
+                asynch == i->synchronism ? "Asynchronous" : "Synchronous",
+                i->name,
+                asynch == i->synchronism ? "async_" : "", i->parent_fv->name,
+                i->name);
 
+    comma = false;
     FOREACH(p, Parameter, i->in, {
-        fprintf(b, "%svoid *%s, size_t %s_len",
-                   p == i->in->value ? "" : ", ",
-                   p->name,
-                   p->name);
+        Text_Separator(b, &comma, ", ");
+        Text_Printf(b, "void *%s, size_t %s_len", p->name, p->name);
     });
 
-    if (NULL != i->in && NULL != i->out) {
-        fprintf(b, ", ");
-    }
-
     FOREACH(p, Parameter, i->out, {
-        fprintf(b, "%svoid *%s, size_t *%s_len",
-                   p == i->out->value ? "" : ", ",
-                   p->name,
-                   p->name);
+        Text_Separator(b, &comma, ", ");
+        Text_Printf(b, "void *%s, size_t *%s_len", p->name, p->name);
     });
 
-    fprintf(b, ")\n{\n");
+    Text_Printf(b, ")\n{\n");
 
     if (asynch == i->synchronism) {
         char *ri_name = string_to_lower(i->name);
@@ -461,48 +567,48 @@ void add_RI_to_c_wrappers(Interface * i)
          */
         if (thread_runtime == i->parent_fv->runtime_nature) {
             /* Current FV is a thread -> send the message to PolyORB */
-            fprintf(b, "   __po_hi_request_t request;\n\n");
+            Text_Printf(b, "   __po_hi_request_t request;\n\n");
 
             /* If the message has parameters, then copy it to POHIC buffers */
             if (NULL != i->in) {
-                fprintf(b, "   __po_hi_copy_array"
-                           "(&(request.vars.%s_global_outport_%s."
-                           "%s_global_outport_%s.buffer),"
-                           " %s, %s_len);\n",
-                           i->parent_fv->name, /* sending port identifier */
-                           ri_name,            /* data identifier */
-                           i->parent_fv->name, /* sending port identifier */
-                           ri_name,            /* data identifier */
-                           i->in->value->name, /* unique IN parameter buffer */
-                           i->in->value->name);/* unique IN parameter size   */
-
-                fprintf(b, "   request.vars.%s_global_outport_%s"
-                           ".%s_global_outport_%s.length = %s_len;\n",
-                           i->parent_fv->name,  /* sending port identifier */
-                           ri_name,             /* data identifier */
-                           i->parent_fv->name,  /* sending port identifier */
-                           ri_name,             /* data identifier = RI name */
-                           i->in->value->name); /* unique IN parameter size  */
+                Text_Printf(b, "   __po_hi_copy_array"
+                               "(&(request.vars.%s_global_outport_%s."
+                               "%s_global_outport_%s.buffer),"
+                               " %s, %s_len);\n",
+                               i->parent_fv->name, /* sending port identifier */
+                               ri_name,            /* data identifier */
+                               i->parent_fv->name, /* sending port identifier */
+                               ri_name,            /* data identifier */
+                               i->in->value->name, /* unique IN parameter buffer */
+                               i->in->value->name);/* unique IN parameter size   */
+
+                Text_Printf(b, "   request.vars.%s_global_outport_%s"
+                               ".%s_global_outport_%s.length = %s_len;\n",
+                               i->parent_fv->name,  /* sending port identifier */
+                               ri_name,             /* data identifier */
+                               i->parent_fv->name,  /* sending port identifier */
+                               ri_name,             /* data identifier = RI name */
+                               i->in->value->name); /* unique IN parameter size  */
             }
 
             /* Also set the port number to identify the message */
-            fprintf(b, "   request.port = %s_global_outport_%s;\n",
-                    i->parent_fv->name, ri_name);
+            Text_Printf(b, "   request.port = %s_global_outport_%s;\n",
+                        i->parent_fv->name, ri_name);
 
-            fprintf(b, "   __po_hi_gqueue_store_out("
-                       "%s_%s_k, %s_local_outport_%s, &request);\n",
-                       i->parent_fv->process->identifier, /* sending node */
-                       i->parent_fv->name,
-                       i->parent_fv->name,
-                       ri_name);
+            Text_Printf(b, "   __po_hi_gqueue_store_out("
+                           "%s_%s_k, %s_local_outport_%s, &request);\n",
+                           i->parent_fv->process->identifier, /* sending node */
+                           i->parent_fv->name,
+                           i->parent_fv->name,
+                           ri_name);
 
             /* Direct invocation of RI */
-            fprintf(b, "   __po_hi_send_output("
-                       "%s_%s_k, %s_global_outport_%s);\n",
-                       i->parent_fv->process->identifier,
-                       i->parent_fv->name,
-                       i->parent_fv->name,
-                       ri_name);
+            Text_Printf(b, "   __po_hi_send_output("
+                           "%s_%s_k, %s_global_outport_%s);\n",
+                           i->parent_fv->process->identifier,
+                           i->parent_fv->name,
+                           i->parent_fv->name,
+                           ri_name);
 
             free(ri_name);
 
@@ -529,67 +635,65 @@ void add_RI_to_c_wrappers(Interface * i)
                 count ++;
             });
             if (1 == count) {
-                fprintf(b, "   vm_async_%s_%s_vt(",
-                           calltmp->value->name,
-                           i->name);
+                Text_Printf(b, "   vm_async_%s_%s_vt(",
+                               calltmp->value->name,
+                               i->name);
 
                 /*  If any, add the IN parameter (async RI) */
                 if (NULL != i->in) {
-                    fprintf(b, "%s, %s_len",
-                               i->in->value->name,
-                               i->in->value->name);
+                    Text_Printf(b, "%s, %s_len",
+                                   i->in->value->name,
+                                   i->in->value->name);
                 }
-                fprintf(b, ");\n");
+                Text_Printf(b, ");\n");
             }
             else if (count > 1) {
                 /* Several possible callers: get current thread id */
-                fprintf(b, "   switch(__po_hi_get_task_id()) {\n");
+                Text_Printf(b, "   switch(__po_hi_get_task_id()) {\n");
                 FOREACH(caller, FV, calltmp, {
-                    fprintf(b, "      case %s_%s_k: vm_async_%s_%s_vt(",
-                            caller->process->identifier,
-                            caller->name,
-                            caller->name,
-                            i->name);
+                    Text_Printf(b, "      case %s_%s_k: vm_async_%s_%s_vt(",
+                                caller->process->identifier,
+                                caller->name,
+                                caller->name,
+                                i->name);
                     if (NULL != i->in) {
                         /* Add the IN parameter (async RI) */
-                        fprintf(b, "%s, %s_len",
-                                   i->in->value->name,
-                                   i->in->value->name);
+                        Text_Printf(b, "%s, %s_len",
+                                       i->in->value->name,
+                                       i->in->value->name);
                         }
-                        fprintf(b, "); break;\n");
+                        Text_Printf(b, "); break;\n");
                 });
-                fprintf(b, "      default: break;\n");
-                fprintf(b, "   }\n");
+                Text_Printf(b, "      default: break;\n");
+                Text_Printf(b, "   }\n");
             }
         }
     }
 
     else {   /* Synchronous RI: direct call to remote polyorb_interface.c */
 
-        fprintf(b, "   sync_%s_%s(",
-                i->distant_fv,
-                NULL != i->distant_name ? i->distant_name : i->name);
+        Text_Printf(b, "   sync_%s_%s(",
+                    i->distant_fv,
+                    NULL != i->distant_name ? i->distant_name : i->name);
 
-        bool comma = false;
+        comma = false;
         FOREACH(p, Parameter, i->in, {
-            fprintf(b, "%s%s, %s_len",
-                       comma? ", ": "",
-                       p->name,
-                       p->name);
-            comma = true;
+            Text_Separator(b, &comma, ", ");
+            Text_Printf(b, "%s, %s_len", p->name, p->name);
         });
 
         FOREACH(p, Parameter, i->out, {
-            fprintf(b, "%s%s, %s_len",
-                       comma? ", ": "",
-                       p->name,
-                       p->name);
-            comma = true;
+            Text_Separator(b, &comma, ", ");
+            Text_Printf(b, "%s, %s_len", p->name, p->name);
         });
-        fprintf(b, ");\n");
+        Text_Printf(b, ");\n");
     }
 
-    fprintf(b, "}\n\n");
+    Text_Printf(b, "}\n\n");
+
+    if (Direct_Encode(i)) {
+        add_direct_encode_RI_to_c_wrappers(i);
+    }
 }
 
 void End_C_Wrappers_Backend(FV * fv)
@@ -602,7 +706,7 @@ void End_C_Wrappers_Backend(FV * fv)
        Add_Protected_Interfaces (fv, h, cfile);
        Add_Unprotected_Interfaces(fv, h, cfile); */
 
-    fprintf(h, "#endif\n");
+    Text_Printf(h, "#endif\n");
     close_c_wrappers();
 }
 
@@ -613,8 +717,10 @@ void GLUE_C_Wrappers_Interface(Interface * i)
     if (PI == i->direction) {
         if (asynch == i->synchronism)
             add_async_PI_to_c_wrappers(i);
-        else
+        else {
             add_sync_PI_to_c_wrappers(i);
+            add_direct_PI_to_c_wrappers(i);
+        }
     } else if (RI == i->direction) {
         add_RI_to_c_wrappers(i);
     }
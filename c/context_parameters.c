@@ -20,6 +20,7 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "tool_jobs.h"
 
 
 
@@ -168,26 +169,17 @@ void Process_Context_Parameters(FV *fv)
             dataview_path, 
             dataview_uniq);
 
-    ERROR ("%s %s\n", 
-            will_fail? "Because of the above warning(s), "
-                       "the following command cannot be executed :\n":
-            "Executing",
-            command);
-
     if (will_fail) {
+        ERROR ("Because of the above warning(s), "
+               "the following command cannot be executed :\n %s\n",
+               command);
         ERROR ("Fix the warnings and restart buildsupport, "
                "or run it manually, you need it!\n");
         exit (-1);
     }
 
-    if (!will_fail && system (command)) {
-        ERROR ("[ERROR] The command failed. Try it yourself "
-               "(correct paths, access to files, etc.)\n");
-        exit (-1);
-    }
-    else if (!get_context()->test) {
-        remove (filename);
-    }
+    /* Run later by Run_Tool_Jobs, which also removes the ASN.1 file */
+    Schedule_Tool_Job ("asn1.exe", command, NULL, filename, true);
 
     free (filename);
     free (command);
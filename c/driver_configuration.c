@@ -19,6 +19,7 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "tool_jobs.h"
 
 
 void Process_Node_Driver_Configuration(Device *device, char *node)
@@ -103,15 +104,7 @@ void Process_Node_Driver_Configuration(Device *device, char *node)
                 filename,
                 device->asn1_filename);
 
-        ERROR ("[INFO] Executing %s\n", command);
-
-        if (system (command)) {
-            ERROR ("[ERROR] The command failed. Try it yourself (correct paths, access to files, etc.)\n");
-            exit (-1);
-        }
-        else if (!get_context()->test) {
-            remove (filename);
-        }
+        Schedule_Tool_Job ("asn1.exe", command, NULL, filename, true);
 
         free (filename);
         free (command);
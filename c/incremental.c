@@ -0,0 +1,565 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Incremental generation (option --incremental)
+ *
+ * The orchestrator calls buildsupport after each change of the models,
+ * and most changes touch one or two functions. With this option, the glue
+ * backends of a function are only called if its inputs changed since the
+ * last run; the files of the other functions are kept as they are.
+ *
+ * The inputs of the glue backends of a function are summarized in a
+ * fingerprint (FNV-1a hash), computed after the preprocessing:
+ *   - the function itself: language, nature, interfaces and parameters,
+ *     context parameters, priority, stack size, process binding...
+ *   - its neighbours: the functions connected to its interfaces, its
+ *     calling threads and the passive functions it calls, and their own
+ *     neighbours (e.g. the glue of a thread includes the calls of the
+ *     passive functions that it protects)
+ *   - the options of the command line and the buildsupport binary
+ * The files generated from the whole system (concurrency view,
+ * system_config.h) have their own fingerprint, which includes all
+ * functions and the deployment.
+ *
+ * The fingerprints are saved in the manifest (.buildsupport-manifest in
+ * the output directory) at the end of a successful run. The manifest is
+ * removed as soon as it is read, so that an interrupted run generates all
+ * files the next time. A function is skipped only if its directory still
+ * exists: remove the output directory (or the manifest) to generate
+ * everything.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "symbol_table.h"
+#include "incremental.h"
+
+#define MANIFEST_NAME    ".buildsupport-manifest"
+
+/* Change the version when the fingerprints change for the same inputs */
+#define MANIFEST_VERSION 1
+
+typedef struct t_entry {
+    FV              *fv;
+    uint64_t        own;            /* the function alone */
+    uint64_t        near;           /* with its neighbours */
+    uint64_t        fingerprint;    /* with the neighbours of these */
+    struct t_entry  **callees;      /* passive functions it calls (thread) */
+    size_t          callee_count;
+} Entry;
+
+static Entry        *entries = NULL;
+static size_t       entry_count = 0;
+static Symbol_Table *by_name = NULL;    /* function name -> Entry */
+static Symbol_Table *previous = NULL;   /* function name -> last fingerprint */
+static uint64_t     system_fingerprint = 0;
+static uint64_t     previous_system = 0;
+static int          unchanged_functions = 0;
+static bool         unchanged_system = false;
+
+/* FNV-1a, as in the symbol tables */
+static void mix(uint64_t *h, const void *data, size_t len)
+{
+    const unsigned char *bytes = data;
+
+    for (size_t k = 0; k < len; k++) {
+        *h ^= bytes[k];
+        *h *= 1099511628211ULL;
+    }
+}
+
+static void mix_u64(uint64_t *h, uint64_t value)
+{
+    mix(h, &value, sizeof value);
+}
+
+static void mix_str(uint64_t *h, const char *s)
+{
+    if (NULL == s) {
+        mix_u64(h, 0);
+    }
+    else {
+        size_t len = strlen(s);
+        mix_u64(h, (uint64_t) len + 1);
+        mix(h, s, len);
+    }
+}
+
+static void mix_parameters(uint64_t *h, Parameter_list *params)
+{
+    FOREACH(p, Parameter, params, {
+        mix_str(h, p->name);
+        mix_str(h, p->type);
+        mix_str(h, p->asn1_module);
+        mix_u64(h, (uint64_t) p->basic_type);
+        mix_str(h, p->asn1_filename);
+        mix_u64(h, (uint64_t) p->encoding);
+        mix_u64(h, (uint64_t) p->param_direction);
+    });
+    mix_u64(h, 0);
+}
+
+/* Interfaces are referred to by function and name */
+static void mix_interface_name(uint64_t *h, Interface *i)
+{
+    mix_str(h, NULL != i->parent_fv ? i->parent_fv->name : NULL);
+    mix_str(h, i->name);
+}
+
+static void mix_interface(uint64_t *h, Interface *i)
+{
+    mix_str(h, i->name);
+    mix_str(h, i->port_name);
+    mix_u64(h, (uint64_t) i->direction);
+    mix_u64(h, (uint64_t) i->synchronism);
+    mix_u64(h, (uint64_t) i->rcm);
+    mix_u64(h, (uint64_t) i->period);
+    mix_u64(h, i->wcet_low);
+    mix_str(h, i->wcet_low_unit);
+    mix_u64(h, i->wcet_high);
+    mix_str(h, i->wcet_high_unit);
+    mix_str(h, i->distant_fv);
+    mix_str(h, i->distant_name);
+    mix_u64(h, i->queue_size);
+    mix_u64(h, i->ignore_params);
+    if (NULL != i->distant_qgen) {
+        mix_str(h, i->distant_qgen->fv_name);
+        mix_u64(h, (uint64_t) i->distant_qgen->language);
+        mix_str(h, i->distant_qgen->qgen_init);
+    }
+    mix_parameters(h, i->in);
+    mix_parameters(h, i->out);
+
+    FOREACH(thread, FV, i->calling_threads, {
+        mix_str(h, thread->name);
+    });
+    mix_u64(h, 0);
+    FOREACH(pi, Interface, i->calling_pis, {
+        mix_interface_name(h, pi);
+    });
+    mix_u64(h, 0);
+    FOREACH(ri, Interface, i->calling_ris, {
+        mix_interface_name(h, ri);
+    });
+    mix_u64(h, 0);
+    if (NULL != i->connected_pi) {
+        mix_interface_name(h, i->connected_pi);
+    }
+}
+
+static void mix_process(uint64_t *h, Process *p)
+{
+    if (NULL == p) {
+        mix_u64(h, 0);
+        return;
+    }
+    mix_str(h, p->name);
+    mix_str(h, p->identifier);
+    mix_str(h, p->processor_board_name);
+    mix_u64(h, p->coverage);
+    if (NULL != p->cpu) {
+        mix_str(h, p->cpu->name);
+        mix_str(h, p->cpu->classifier);
+        mix_str(h, p->cpu->platform_name);
+        mix_str(h, p->cpu->envvars);
+        mix_str(h, p->cpu->user_cflags);
+        mix_str(h, p->cpu->user_ldflags);
+    }
+}
+
+/* The function alone */
+static uint64_t function_hash(FV *fv)
+{
+    uint64_t h = 14695981039346656037ULL;
+
+    mix_str(&h, fv->name);
+    mix_str(&h, fv->nameWithCase);
+    mix_u64(&h, (uint64_t) fv->runtime_nature);
+    mix_u64(&h, (uint64_t) fv->language);
+    mix_str(&h, fv->zipfile);
+    mix_u64(&h, (uint64_t) fv->thread_id);
+    mix_u64(&h, (uint64_t) fv->priority);
+    mix_u64(&h, fv->stack_size);
+    mix_u64(&h, fv->artificial);
+    mix_str(&h, fv->original_name);
+    mix_u64(&h, fv->timer);
+    mix_u64(&h, fv->is_component_type);
+    mix_str(&h, fv->instance_of);
+    mix_process(&h, fv->process);
+
+    FOREACH(timer, String, fv->timer_list, {
+        mix_str(&h, timer);
+    });
+    mix_u64(&h, 0);
+
+    FOREACH(cp, Context_Parameter, fv->context_parameters, {
+        mix_str(&h, cp->name);
+        mix_str(&h, cp->fullNameWithCase);
+        mix_str(&h, cp->value);
+        mix_str(&h, cp->type.name);
+        mix_str(&h, cp->type.module);
+        mix_str(&h, cp->type.asn1_filename);
+        mix_u64(&h, (uint64_t) cp->type.basic_type);
+    });
+    mix_u64(&h, 0);
+
+    FOREACH(thread, FV, fv->calling_threads, {
+        mix_str(&h, thread->name);
+    });
+    mix_u64(&h, 0);
+
+    FOREACH(i, Interface, fv->interfaces, {
+        mix_interface(&h, i);
+    });
+    return h;
+}
+
+/*
+ * Options and binary that affect the generated code. Update it when you add
+ * a field to the Context (the options that only change how buildsupport
+ * runs, like --jobs or --profile, are not part of it)
+ */
+static uint64_t global_hash(System *s)
+{
+    Context     *ctx = s->context;
+    uint64_t    h = 14695981039346656037ULL;
+    struct stat st;
+
+    mix_u64(&h, MANIFEST_VERSION);
+
+    /* A new version of buildsupport may generate different code */
+    if (0 == stat("/proc/self/exe", &st)) {
+        mix_u64(&h, (uint64_t) st.st_size);
+        mix_u64(&h, (uint64_t) st.st_mtime);
+    }
+
+    mix_str(&h, s->name);
+    mix_str(&h, ctx->output);
+    mix_str(&h, ctx->ifview);
+    mix_str(&h, ctx->dataview);
+    mix_str(&h, ctx->stacksize);
+    mix_str(&h, ctx->stack_config);
+    mix_u64(&h, (uint64_t) ctx->glue);
+    mix_u64(&h, ctx->smp2);
+    mix_u64(&h, (uint64_t) ctx->gw);
+    mix_u64(&h, (uint64_t) ctx->keep_case);
+    mix_u64(&h, (uint64_t) ctx->onlycv);
+    mix_u64(&h, (uint64_t) ctx->aadlv2);
+    mix_u64(&h, (uint64_t) ctx->debug);
+    mix_u64(&h, (uint64_t) ctx->test);
+    mix_u64(&h, ctx->future);
+    mix_u64(&h, (uint64_t) ctx->polyorb_hi_c);
+    mix_u64(&h, ctx->needs_basictypes);
+    mix_u64(&h, (uint64_t) ctx->timer_resolution);
+    mix_u64(&h, ctx->timer_wheel);
+    mix_u64(&h, ctx->binary_msc);
+    mix_u64(&h, ctx->direct_calls);
+    mix_u64(&h, ctx->thread_local_buffers);
+    mix_u64(&h, ctx->gui_events);
+    mix_u64(&h, (uint64_t) ctx->gui_period);
+    mix_u64(&h, ctx->gui_shm);
+    mix_u64(&h, ctx->fail_unschedulable);
+    mix_u64(&h, ctx->task_attributes);
+    mix_u64(&h, ctx->direct_encode);
+    return h;
+}
+
+static void mix_neighbour(uint64_t *h, const char *name, bool first_round)
+{
+    Entry *e = Symbol_Table_Find(by_name, name);
+
+    mix_u64(h, NULL == e ? 0 : first_round ? e->own : e->near);
+}
+
+/* Hash of a function with the (first round) or near (second round) hashes
+ * of its neighbours */
+static uint64_t neighbours_hash(uint64_t h, Entry *e, bool first_round)
+{
+    mix_u64(&h, first_round ? e->own : e->near);
+
+    FOREACH(i, Interface, e->fv->interfaces, {
+        mix_neighbour(&h, i->distant_fv, first_round);
+        if (NULL != i->connected_pi && NULL != i->connected_pi->parent_fv) {
+            mix_neighbour(&h, i->connected_pi->parent_fv->name, first_round);
+        }
+        FOREACH(ri, Interface, i->calling_ris, {
+            if (NULL != ri->parent_fv) {
+                mix_neighbour(&h, ri->parent_fv->name, first_round);
+            }
+        });
+        FOREACH(pi, Interface, i->calling_pis, {
+            if (NULL != pi->parent_fv) {
+                mix_neighbour(&h, pi->parent_fv->name, first_round);
+            }
+        });
+        FOREACH(thread, FV, i->calling_threads, {
+            mix_neighbour(&h, thread->name, first_round);
+        });
+    });
+    FOREACH(thread, FV, e->fv->calling_threads, {
+        mix_neighbour(&h, thread->name, first_round);
+    });
+    for (size_t k = 0; k < e->callee_count; k++) {
+        mix_u64(&h, first_round ? e->callees[k]->own : e->callees[k]->near);
+    }
+    return h;
+}
+
+/* Functions and deployment: concurrency view and system_config.h */
+static uint64_t system_hash(uint64_t h, System *s)
+{
+    for (size_t k = 0; k < entry_count; k++) {
+        mix_u64(&h, entries[k].fingerprint);
+    }
+
+    FOREACH(p, Process, s->processes, {
+        mix_process(&h, p);
+        FOREACH(b, Aplc_binding, p->bindings, {
+            mix_str(&h, b->fv->name);
+        });
+        mix_u64(&h, 0);
+        FOREACH(i, Interface, p->interfaces, {
+            mix_interface_name(&h, i);
+        });
+        mix_u64(&h, 0);
+        FOREACH(d, Device, p->drivers, {
+            mix_str(&h, d->name);
+            mix_str(&h, d->classifier);
+            mix_str(&h, d->associated_processor);
+            mix_str(&h, d->configuration);
+            mix_str(&h, d->asn1_filename);
+            mix_str(&h, d->asn1_typename);
+            mix_str(&h, d->asn1_modulename);
+            mix_str(&h, d->accessed_bus);
+            mix_str(&h, d->access_port);
+        });
+        mix_u64(&h, 0);
+    });
+    mix_u64(&h, 0);
+
+    FOREACH(b, Bus, s->buses, {
+        mix_str(&h, b->name);
+        mix_str(&h, b->classifier);
+    });
+    mix_u64(&h, 0);
+
+    FOREACH(pkg, Package, s->packages, {
+        mix_str(&h, pkg);
+    });
+    mix_u64(&h, 0);
+
+    FOREACH(cnt, Connection, s->connections, {
+        mix_str(&h, cnt->src_system);
+        mix_str(&h, cnt->src_port);
+        mix_str(&h, cnt->bus);
+        mix_str(&h, cnt->dst_system);
+        mix_str(&h, cnt->dst_port);
+    });
+    return h;
+}
+
+static void Compute_Fingerprints(System *s)
+{
+    uint64_t global = global_hash(s);
+    size_t   k = 0;
+
+    FOREACH(fv, FV, s->functions, {
+        (void) fv;
+        entry_count++;
+    });
+    entries = calloc(entry_count + 1, sizeof(Entry));
+    by_name = Create_Symbol_Table();
+    assert(NULL != entries && NULL != by_name);
+
+    FOREACH(fv, FV, s->functions, {
+        entries[k].fv  = fv;
+        entries[k].own = function_hash(fv);
+        Symbol_Table_Add(by_name, fv->name, &entries[k]);
+        k++;
+    });
+
+    /* The glue of a thread depends on the passive functions it calls */
+    for (k = 0; k < entry_count; k++) {
+        FOREACH(thread, FV, entries[k].fv->calling_threads, {
+            Entry *caller = Symbol_Table_Find(by_name, thread->name);
+            if (NULL != caller) {
+                caller->callees = realloc(caller->callees,
+                                          (caller->callee_count + 1)
+                                          * sizeof(Entry *));
+                assert(NULL != caller->callees);
+                caller->callees[caller->callee_count++] = &entries[k];
+            }
+        });
+    }
+
+    for (k = 0; k < entry_count; k++) {
+        entries[k].near =
+            neighbours_hash(14695981039346656037ULL, &entries[k], true);
+    }
+    for (k = 0; k < entry_count; k++) {
+        entries[k].fingerprint = neighbours_hash(global, &entries[k], false);
+    }
+    system_fingerprint = system_hash(global, s);
+}
+
+static char *Manifest_Path(void)
+{
+    return make_string("%s/%s", OUTPUT_PATH, MANIFEST_NAME);
+}
+
+static bool Exists(const char *path, bool directory)
+{
+    struct stat st;
+
+    return 0 == stat(path, &st)
+           && (directory ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode));
+}
+
+/* External interface (see incremental.h) */
+void Load_Manifest(System *s)
+{
+    char               *path = NULL, *line = NULL;
+    size_t             size = 0;
+    FILE               *manifest = NULL;
+    unsigned long long value = 0;
+
+    if (!get_context()->incremental) return;
+
+    Compute_Fingerprints(s);
+    previous = Create_Symbol_Table();
+    assert(NULL != previous);
+
+    /*
+     * One line per function: "F <fingerprint> <name>"
+     * and one for the whole system: "S <fingerprint>"
+     */
+    path = Manifest_Path();
+    manifest = fopen(path, "r");
+    if (NULL != manifest) {
+        while (-1 != getline(&line, &size, manifest)) {
+            char kind = '\0';
+            int  offset = 0;
+
+            line[strcspn(line, "\n")] = '\0';
+            if (2 != sscanf(line, "%c %llx %n", &kind, &value, &offset)) {
+                continue;
+            }
+            if ('S' == kind) {
+                previous_system = (uint64_t) value;
+            }
+            else if ('F' == kind && offset > 0 && '\0' != line[offset]) {
+                uint64_t *fingerprint = malloc(sizeof *fingerprint);
+                assert(NULL != fingerprint);
+                *fingerprint = (uint64_t) value;
+                if (!Symbol_Table_Add(previous, line + offset, fingerprint)) {
+                    free(fingerprint);
+                }
+            }
+        }
+        fclose(manifest);
+        free(line);
+        /* Files are about to change: it is valid again at the end */
+        remove(path);
+    }
+    free(path);
+}
+
+bool Unchanged_Function(FV *fv)
+{
+    Entry    *e = NULL;
+    uint64_t *old = NULL;
+    char     *dir = NULL;
+    bool     unchanged = false;
+
+    if (!get_context()->incremental || NULL == by_name) return false;
+
+    e   = Symbol_Table_Find(by_name, fv->name);
+    old = Symbol_Table_Find(previous, fv->name);
+    if (NULL == e || NULL == old || *old != e->fingerprint) return false;
+
+    dir = make_string("%s/%s", OUTPUT_PATH, fv->name);
+    unchanged = Exists(dir, true);
+    free(dir);
+
+    if (unchanged) {
+        unchanged_functions++;
+    }
+    return unchanged;
+}
+
+bool Unchanged_System(void)
+{
+    char *cv = NULL, *config = NULL;
+
+    if (!get_context()->incremental || NULL == by_name
+        || 0 == previous_system || previous_system != system_fingerprint) {
+        return false;
+    }
+
+    cv     = make_string("%s/ConcurrencyView", OUTPUT_PATH);
+    config = make_string("%s/system_config.h", OUTPUT_PATH);
+    unchanged_system = Exists(cv, true) && Exists(config, false);
+    free(cv);
+    free(config);
+    return unchanged_system;
+}
+
+void Save_Manifest(void)
+{
+    char *path = Manifest_Path(), *tmp = NULL;
+    FILE *manifest = NULL;
+    int  generated = 0;
+
+    if (!get_context()->incremental || NULL == by_name) {
+        remove(path);
+        free(path);
+        return;
+    }
+
+    /* Write in a temporary file: concurrent runs never see partial data */
+    tmp = make_string("%s.%ld.tmp", path, (long) getpid());
+    manifest = fopen(tmp, "w");
+    if (NULL == manifest) {
+        ERROR("[WARNING] Could not create the manifest %s\n", path);
+        free(tmp);
+        free(path);
+        return;
+    }
+
+    fprintf(manifest, "# Fingerprints of the generated code "
+                      "(buildsupport --incremental)\n");
+    fprintf(manifest, "S %016llx\n",
+            (unsigned long long) system_fingerprint);
+    for (size_t k = 0; k < entry_count; k++) {
+        if (!entries[k].fv->is_component_type) {
+            fprintf(manifest, "F %016llx %s\n",
+                    (unsigned long long) entries[k].fingerprint,
+                    entries[k].fv->name);
+            generated++;
+        }
+    }
+
+    if (0 != fclose(manifest) || 0 != rename(tmp, path)) {
+        ERROR("[WARNING] Could not write the manifest %s\n", path);
+        remove(tmp);
+    }
+    free(tmp);
+    free(path);
+
+    printf("[INFO] Incremental generation: %d of %d functions unchanged%s\n",
+           unchanged_functions, generated,
+           unchanged_system ? ", concurrency view unchanged" : "");
+}
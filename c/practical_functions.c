@@ -3,6 +3,8 @@
  * License is LGPL, check LICENSE file */
 /* Practical functions used by the backends */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,6 +19,9 @@
 #include <stdbool.h>
 
 #include "practical_functions.h"
+#include "symbol_table.h"
+#include "arena.h"
+#include "c_ast_construction.h"
 
 /* Convert ASN.1 types: change '-' to '_' */
 char *asn2underscore(char *s, size_t len)
@@ -150,6 +155,52 @@ int Compare_Port (Port *one, Port *two)
   return (!strcmp(one, two));
 }
 
+/* Keys of the values in large sets - see the Compare functions above */
+const char *Key_String (String *s)
+{
+    return s;
+}
+
+const char *Key_Package (Package *p)
+{
+    return p;
+}
+
+const char *Key_Interface (Interface *i)
+{
+    return NULL != i->distant_name ? i->distant_name : i->name;
+}
+
+const char *Key_FV (FV *fv)
+{
+    return fv->name;
+}
+
+const char *Key_Protected_Object_Name (Protected_Object_Name *p)
+{
+    return p;
+}
+
+const char *Key_ASN1_Filename (ASN1_Filename *f)
+{
+    return f;
+}
+
+const char *Key_ASN1_Module (ASN1_Module *m)
+{
+    return m;
+}
+
+const char *Key_ASN1_Type (ASN1_Type *t)
+{
+    return t->name;
+}
+
+const char *Key_Port (Port *p)
+{
+    return p;
+}
+
 void Clear_Port (Port **p)
 {
     free (*p);
@@ -244,9 +295,99 @@ char *build_comma_string(char **str, char *text_to_add, size_t length)
     return *str;
 }
 
+/*
+ * Generated files are first written in memory. When they are closed, the
+ * content is compared with the file on disk, which is replaced (atomically)
+ * only if it differs. Unchanged files keep their timestamp, so that the
+ * build scripts do not recompile them.
+ */
+typedef struct t_output_file {
+    FILE                    *stream;
+    char                    *filename;
+    char                    *buffer;
+    size_t                  size;
+    struct t_output_file    *next;
+} Output_File;
+
+static Output_File  *output_files = NULL;     /* the last created first */
+static size_t       open_files = 0;
+static int          files_written = 0;
+static int          files_unchanged = 0;
+static size_t       bytes_generated = 0;
+
+/* Return true if the file on disk has exactly the given content */
+static bool same_content(char *filename, char *buffer, size_t size)
+{
+    struct stat st;
+    FILE        *f = NULL;
+    char        chunk[8192];
+    size_t      offset = 0, len = 0;
+    bool        same = true;
+
+    if (0 != stat(filename, &st) || (size_t) st.st_size != size)
+        return false;
+
+    if (NULL == (f = fopen(filename, "rb")))
+        return false;
+
+    while (same && 0 < (len = fread(chunk, 1, sizeof chunk, f))) {
+        if (offset + len > size || memcmp(chunk, buffer + offset, len))
+            same = false;
+        offset += len;
+    }
+    fclose(f);
+
+    return same && offset == size;
+}
+
+/* Write the content of a generated file on disk, if it changed */
+static void commit_output_file(Output_File *out)
+{
+    struct stat st;
+    char        *tmp = NULL;
+    FILE        *f = NULL;
+    bool        exists = false;
+
+    fclose(out->stream);
+    out->stream = NULL;
+    bytes_generated += out->size;
+
+    if (same_content(out->filename, out->buffer, out->size)) {
+        files_unchanged++;
+        return;
+    }
+
+    exists = (0 == stat(out->filename, &st));
+
+    tmp = make_string("%s.tmp", out->filename);
+    f = fopen(tmp, "wb");
+    assert(NULL != f);
+
+    if (out->size != fwrite(out->buffer, 1, out->size, f) || 0 != fclose(f)
+        || (exists && 0 != chmod(tmp, st.st_mode & 07777))
+        || 0 != rename(tmp, out->filename)) {
+        ERROR("[ERROR] Could not write file %s\n", out->filename);
+        remove(tmp);
+        add_error();
+    }
+    else {
+        files_written++;
+    }
+    free(tmp);
+}
+
+static void free_output_file(Output_File *out)
+{
+    free(out->filename);
+    free(out->buffer);
+    free(out);
+}
+
 /* Creates a new file in a subdirectory */
 int create_file(char *fv_name, char *file, FILE ** f)
 {
+    static bool registered = false;
+    Output_File *out = NULL;
     char *filename = NULL;
     char *current_dir = ".";
 
@@ -262,18 +403,111 @@ int create_file(char *fv_name, char *file, FILE ** f)
     assert(NULL != filename);
 
     printf("Creating file: %s\n", filename);
-    *f = fopen(filename, "w");
-    assert(NULL != *f);
 
-    free(filename);
+    out = malloc(sizeof(*out));
+    assert(NULL != out);
+
+    out->filename = filename;
+    out->buffer   = NULL;
+    out->size     = 0;
+    out->stream   = open_memstream(&out->buffer, &out->size);
+    assert(NULL != out->stream);
+    out->next     = output_files;
+    output_files  = out;
+    open_files++;
+
+    /* Files that are not closed explicitly are written when exiting */
+    if (!registered) {
+        atexit(Close_All_Files);
+        registered = true;
+    }
+
+    *f = out->stream;
     return 0;
 }
 
 void close_file(FILE ** f)
 {
-    if (NULL != *f) {
+    Output_File **ptr = &output_files;
+
+    if (NULL == *f)
+        return;
+
+    while (NULL != *ptr && (*ptr)->stream != *f)
+        ptr = &(*ptr)->next;
+
+    if (NULL != *ptr) {
+        Output_File *out = *ptr;
+        *ptr = out->next;
+        open_files--;
+        commit_output_file(out);
+        free_output_file(out);
+    }
+    else {
+        /* Not a file made by create_file */
         fclose(*f);
-        *f = NULL;
+    }
+    *f = NULL;
+}
+
+/* Write all generated files that were not closed yet */
+void Close_All_Files()
+{
+    Close_Files_Opened_After(0);
+}
+
+size_t Open_Files_Count()
+{
+    return open_files;
+}
+
+/* Write the files that were created after the given number of files were
+ * open: they are at the beginning of the list */
+void Close_Files_Opened_After(size_t count)
+{
+    Output_File *out = NULL;
+
+    while (NULL != output_files && open_files > count) {
+        out = output_files;
+        output_files = out->next;
+        open_files--;
+        commit_output_file(out);
+        free_output_file(out);
+    }
+}
+
+/* Number of generated files that were (not) rewritten so far */
+void Get_Output_Files_Count(int *written, int *unchanged)
+{
+    *written   = files_written;
+    *unchanged = files_unchanged;
+}
+
+/* Account for the files generated by another process */
+void Add_Output_Files_Count(int written, int unchanged)
+{
+    files_written   += written;
+    files_unchanged += unchanged;
+}
+
+/* Size of all generated files so far (written or not) */
+size_t Get_Output_Bytes_Count()
+{
+    return bytes_generated;
+}
+
+void Add_Output_Bytes_Count(size_t bytes)
+{
+    bytes_generated += bytes;
+}
+
+/* Report the number of generated files that were (not) rewritten */
+void Output_Files_Summary()
+{
+    Close_All_Files();
+    if (0 < files_written + files_unchanged) {
+        printf("[INFO] Generated files: %d written, %d unchanged\n",
+               files_written, files_unchanged);
     }
 }
 
@@ -307,7 +541,7 @@ void Create_Aplc_binding(Aplc_binding ** a)
         *a = NULL;
     }
 
-    *a = (Aplc_binding *) malloc(sizeof(**a));
+    *a = AST_Alloc(sizeof(**a));
 
     if (NULL != *a) {
         (*a)->fv = NULL;
@@ -328,18 +562,15 @@ void Clear_Aplc_binding(Aplc_binding * a)
 // Clear an Aplc_binding_list type
 void Clear_Aplc_bindings_List(Aplc_binding_list * p)
 {
-    Aplc_binding_list *next = NULL;
-
-    while (NULL != p) {
-
-        Clear_Aplc_binding(p->value);
-        free(p->value);
-        p->value = NULL;
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, Aplc_binding, p, {
+        Clear_Aplc_binding(elem);
+    });
+}
 
-        next = p->next;
-        free(p);
-        p = next;
-    }
+static void release_process(void *p)
+{
+    Clear_Process(p);
 }
 
 // Allocate memory for a Process type
@@ -349,7 +580,7 @@ void Create_Process(Process ** p)
         *p = NULL;
     }
 
-    *p = (Process *) malloc(sizeof(**p));
+    *p = AST_Alloc_Node(sizeof(**p), release_process);
     if (NULL != *p) {
         (*p)->cpu = NULL;
         (*p)->name = NULL;
@@ -380,193 +611,228 @@ void Clear_Process(Process * p)
 
     if (NULL != p->identifier) {
         free(p->identifier);
-        p->name = NULL;
+        p->identifier = NULL;
     }
 
     if (NULL != p->bindings) {
         Clear_Aplc_bindings_List(p->bindings);
     }
 
-    if (p->cpu != NULL) {
-        if (p->cpu->name != NULL) {
-            free(p->cpu->name);
-        }
-        if (p->cpu->classifier != NULL) {
-            free(p->cpu->classifier);
-        }
-        free(p->cpu);
-    }
-
-    if (NULL != p->drivers) {
-        Clear_Devices_List (p->drivers);
-    }
+    /* The processor and the drivers are nodes of their own, which may be
+     * shared by several processes: they free their strings themselves */
+    p->cpu = NULL;
 }
 
 // Clear a Processes_list type
 void Clear_Processes_List(Process_list * p)
 {
-    Process_list *next = NULL;
-
-    while (NULL != p) {
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, Process, p, {
+        Clear_Process(elem);
+    });
+}
 
-        Clear_Process(p->value);
-        free(p->value);
-        p->value = NULL;
+static void release_device(void *dev)
+{
+    Clear_Device(dev);
+}
 
-        next = p->next;
-        free(p);
-        p = next;
-    }
+// Allocate memory for a Device (driver) type
+void Create_Device(Device ** dev)
+{
+    *dev = AST_Alloc_Node(sizeof(**dev), release_device);
+    assert(NULL != *dev);
 }
 
 void Clear_Device(Device * dev)
 {
-    if (NULL != dev->name) {
-        free(dev->name);
-    }
-
-    if (NULL != dev->classifier) {
-        free(dev->classifier);
-    }
+    free(dev->name);
+    dev->name = NULL;
+    free(dev->classifier);
+    dev->classifier = NULL;
+    free(dev->configuration);
+    dev->configuration = NULL;
+    free(dev->asn1_filename);
+    dev->asn1_filename = NULL;
+    free(dev->asn1_typename);
+    dev->asn1_typename = NULL;
+    free(dev->asn1_modulename);
+    dev->asn1_modulename = NULL;
+    free(dev->associated_processor);
+    dev->associated_processor = NULL;
+    free(dev->accessed_bus);
+    dev->accessed_bus = NULL;
+    free(dev->access_port);
+    dev->access_port = NULL;
+}
 
-    if (NULL != dev->configuration) {
-        free(dev->configuration);
-    }
 
-    if (NULL != dev->asn1_filename) {
-        free (dev->asn1_filename);
-    }
+void Clear_Devices_List(Device_list * p)
+{
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, Device, p, {
+        Clear_Device(elem);
+    });
+}
 
-    if (NULL != dev->associated_processor) {
-        free(dev->associated_processor);
-    }
 
-    if (NULL != dev->accessed_bus) {
-        free(dev->accessed_bus);
-    }
+void Clear_Packages_List(Package_list * p)
+{
+    /* The list is freed with the AST arena, the names are on the heap */
+    FOREACH (package, Package, p, {
+        free(package);
+    });
+}
 
-    if (NULL != dev->access_port) {
-        free(dev->access_port);
-    }
+static void release_connection(void *conn)
+{
+    Clear_Connection(conn);
 }
 
+// Allocate memory for a Connection type
+void Create_Connection(Connection ** conn)
+{
+    *conn = AST_Alloc_Node(sizeof(**conn), release_connection);
+    assert(NULL != *conn);
+}
 
-void Clear_Devices_List(Device_list * p)
+void Clear_Connection(Connection * conn)
 {
-    Device_list *next = NULL;
+    free(conn->src_system);
+    conn->src_system = NULL;
+    free(conn->src_port);
+    conn->src_port = NULL;
+    free(conn->bus);
+    conn->bus = NULL;
+    free(conn->dst_system);
+    conn->dst_system = NULL;
+    free(conn->dst_port);
+    conn->dst_port = NULL;
+}
 
-    while (NULL != p) {
+static void release_processor(void *cpu)
+{
+    Clear_Processor(cpu);
+}
 
-        Clear_Device(p->value);
-        free(p->value);
-        p->value = NULL;
+// Allocate memory for a Processor type
+void Create_Processor(Processor ** cpu)
+{
+    *cpu = AST_Alloc_Node(sizeof(**cpu), release_processor);
+    assert(NULL != *cpu);
+}
 
-        next = p->next;
-        free(p);
-        p = next;
-    }
+// Free the strings of a Processor type
+void Clear_Processor(Processor * cpu)
+{
+    free(cpu->name);
+    cpu->name = NULL;
+    free(cpu->classifier);
+    cpu->classifier = NULL;
+    free(cpu->platform_name);
+    cpu->platform_name = NULL;
+    free(cpu->envvars);
+    cpu->envvars = NULL;
+    free(cpu->user_cflags);
+    cpu->user_cflags = NULL;
+    free(cpu->user_ldflags);
+    cpu->user_ldflags = NULL;
 }
 
+static void release_bus(void *bus)
+{
+    Clear_Bus(bus);
+}
 
-void Clear_Packages_List(Package_list * p)
+// Allocate memory for a Bus type
+void Create_Bus(Bus ** bus)
 {
-    Package_list *next = NULL;
+    *bus = AST_Alloc_Node(sizeof(**bus), release_bus);
+    assert(NULL != *bus);
+}
 
-    while (NULL != p) {
+// Free the strings of a Bus type
+void Clear_Bus(Bus * bus)
+{
+    free(bus->name);
+    bus->name = NULL;
+    free(bus->classifier);
+    bus->classifier = NULL;
+}
 
-        free(p->value);
-        p->value = NULL;
+static void release_context_parameter(void *cp)
+{
+    Clear_Context_Parameter(cp);
+}
 
-        next = p->next;
-        free(p);
-        p = next;
-    }
+// Allocate memory for a Context_Parameter type
+void Create_Context_Parameter(Context_Parameter ** cp)
+{
+    *cp = AST_Alloc_Node(sizeof(**cp), release_context_parameter);
+    assert(NULL != *cp);
 }
 
-void Clear_Connection(Connection * conn)
+// Free the strings of a Context_Parameter type
+void Clear_Context_Parameter(Context_Parameter * cp)
 {
-    if (conn->src_system != NULL) {
-        free(conn->src_system);
-    }
-    if (conn->src_port != NULL) {
-        free(conn->src_port);
-    }
-    if (conn->bus != NULL) {
-        free(conn->bus);
-    }
-    if (conn->dst_system != NULL) {
-        free(conn->dst_system);
-    }
-    if (conn->dst_port != NULL) {
-        free(conn->dst_port);
-    }
+    free(cp->name);
+    cp->name = NULL;
+    free(cp->fullNameWithCase);
+    cp->fullNameWithCase = NULL;
+    free(cp->value);
+    cp->value = NULL;
+    free(cp->type.name);
+    cp->type.name = NULL;
+    free(cp->type.module);
+    cp->type.module = NULL;
+    free(cp->type.asn1_filename);
+    cp->type.asn1_filename = NULL;
 }
 
 void Clear_Connections_List(Connection_list * p)
 {
-    Connection_list *next = NULL;
-
-    while (NULL != p) {
-
-        Clear_Connection(p->value);
-        free(p->value);
-        p->value = NULL;
-
-        next = p->next;
-        free(p);
-        p = next;
-    }
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, Connection, p, {
+        Clear_Connection(elem);
+    });
 }
 
 
 // Remove a binding from a process
 void Remove_Binding(FV * fv)
 {
-    Aplc_binding_list *l = NULL, *next = NULL;
+    Aplc_binding *binding = NULL;
 
     // First check that there is a binding for this FV. If not, return.
     if (NULL == fv->process)
         return;
 
-    next = fv->process->bindings;
-    l = next;
-
-    while (NULL != next) {
-        if (next->value->fv == fv) {
-            if (next == l) {
-                fv->process->bindings = l->next;
-                free(next);
-                next = NULL;
-            } else {
-                l->next = next->next;
-                free(next);
-                next = NULL;
-            }
-        } else {
-            l = next;
-            next = l->next;
+    FOREACH(b, Aplc_binding, fv->process->bindings, {
+        if (NULL == binding && b->fv == fv) {
+            binding = b;
         }
+    });
+
+    if (NULL != binding) {
+        REMOVE_FROM_LIST(Aplc_binding, fv->process->bindings, binding);
     }
 }
 
 // Clear a list of FV
 void Clear_FV_List(FV_list * p)
 {
-    FV_list *next = NULL;
-
-    while (NULL != p) {
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, FV, p, {
+        Clear_FV(elem);
+    });
+}
 
-        Clear_FV(p->value);
-        free(p->value);
-        p->value = NULL;
 
-        next = p->next;
-        free(p);
-        p = next;
-    }
+static void release_parameter(void *p)
+{
+    Clear_Parameter(p);
 }
 
-
 /* Allocate memory for a Parameter type */
 void Create_Parameter(Parameter ** p)
 {
@@ -574,7 +840,7 @@ void Create_Parameter(Parameter ** p)
         *p = NULL;
     }
 
-    *p = (Parameter *) malloc(sizeof(**p));
+    *p = AST_Alloc_Node(sizeof(**p), release_parameter);
     assert(NULL != *p);
 
     (*p)->name = NULL;
@@ -601,55 +867,34 @@ void Clear_Parameter(Parameter * p)
         free(p->type);
         p->type = NULL;
     }
-    /*
-       if (NULL != p->asn1_module) {
-       free(p->asn1_module);
-       p->asn1_module = NULL;
-       } */
+
+    if (NULL != p->asn1_module) {
+        free(p->asn1_module);
+        p->asn1_module = NULL;
+    }
+
+    if (NULL != p->asn1_filename) {
+        free(p->asn1_filename);
+        p->asn1_filename = NULL;
+    }
 }
 
 /* Add an IN or OUT parameter to the list of parameters for the current PI or RI */
 void Add_Param(Parameter ** parameter, Parameter_list ** ret)
 {
-    Parameter_list *p = NULL;
-    Parameter_list *nav = NULL;
+    assert(NULL != parameter);
 
-    p = (Parameter_list *) malloc(sizeof(*p));
-    if (NULL != p) {
-
-        if (NULL != parameter) {
-            p->value = *parameter;
-            //*parameter = NULL;  /* Don't clear it here, otherwise the 'encoding' property cannot be set */
-        }
-
-        p->next = NULL;
-
-        if (NULL == *ret) {
-            *ret = p;
-        } else {
-            nav = *ret;
-            while (NULL != nav->next)
-                nav = nav->next;
-            nav->next = p;
-        }
-    }
+    /* Don't clear *parameter here, otherwise the 'encoding' property cannot be set */
+    APPEND_TO_LIST(Parameter, *ret, *parameter);
 }
 
 // Clear a Parameter_list type
 void Clear_Param_List(Parameter_list * p)
 {
-    Parameter_list *next = NULL;
-
-    while (NULL != p) {
-
-        Clear_Parameter(p->value);
-        free(p->value);
-        p->value = NULL;
-
-        next = p->next;
-        free(p);
-        p = next;
-    }
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, Parameter, p, {
+        Clear_Parameter(elem);
+    });
 }
 
 // this function allocates memory for a new Distant_QGen
@@ -657,7 +902,7 @@ void Create_Qgen(Distant_QGen ** i)
 {
     assert (NULL == *i);
 
-    *i = (Distant_QGen *) malloc(sizeof(**i));
+    *i = AST_Alloc(sizeof(**i));
 
     assert(NULL != *i);
 
@@ -666,12 +911,17 @@ void Create_Qgen(Distant_QGen ** i)
     (*i)->qgen_init = NULL;
 }
 
+static void release_interface(void *i)
+{
+    Clear_Interface(i);
+}
+
 // this function allocates memory for a new Interface
 void Create_Interface(Interface ** i)
 {
     assert (NULL == *i);
 
-    *i = (Interface *) malloc(sizeof(**i));
+    *i = AST_Alloc_Node(sizeof(**i), release_interface);
 
     assert(NULL != *i);
 
@@ -692,8 +942,12 @@ void Create_Interface(Interface ** i)
     (*i)->distant_fv = NULL;
     (*i)->distant_qgen = distant_qgen;
     (*i)->calling_threads = NULL;
+    (*i)->calling_thread_set = NULL;
     (*i)->distant_name = NULL;
     (*i)->calling_pis = NULL;
+    (*i)->connected_pi = NULL;
+    (*i)->calling_ris = NULL;
+    (*i)->location = NULL;
 }
 
 // this function clears up an Interface data structure
@@ -735,15 +989,23 @@ void Clear_Interface(Interface * i)
         i->distant_fv = NULL;
     }
 
+    /* distant_qgen is freed with the AST arena, fv_name is the name of
+     * a function */
     if (NULL != i->distant_qgen) {
-        free(i->distant_qgen);
-        i->distant_qgen = NULL;
+        free(i->distant_qgen->qgen_init);
+        i->distant_qgen->qgen_init = NULL;
     }
+    i->distant_qgen = NULL;
 
 
     if (NULL != i->distant_name) {
-        free(i->name);
-        i->name = NULL;
+        free(i->distant_name);
+        i->distant_name = NULL;
+    }
+
+    if (NULL != i->location) {
+        free(i->location);
+        i->location = NULL;
     }
 
     /* Don' t try to free the lists here */
@@ -755,18 +1017,10 @@ void Clear_Interface(Interface * i)
 // Clear memory of an Interface_list chained list
 void Clear_Interfaces_List(Interface_list * l)
 {
-
-    Interface_list *next = NULL;
-
-    while (NULL != l) {
-        Clear_Interface(l->value);
-        free(l->value);
-        l->value = NULL;
-
-        next = l->next;
-        free(l);
-        l = next;
-    }
+    /* The nodes and the list are freed with the AST arena */
+    FOREACH (elem, Interface, l, {
+        Clear_Interface(elem);
+    });
 }
 
 // Duplicate a parameter, with the exception of the "interface" field, which is context-dependent
@@ -884,10 +1138,26 @@ void Create_Context(Context ** context)
         (*context)->aadlv2           = 0;
         (*context)->test             = 0;
         (*context)->debug            = 0;
+        (*context)->future           = false;
         (*context)->polyorb_hi_c     = 0;
         (*context)->stacksize        = NULL;
+        (*context)->stack_config     = NULL;
         (*context)->needs_basictypes = false;
         (*context)->timer_resolution = 100;  // milliseconds
+        (*context)->timer_wheel      = false;
+        (*context)->jobs             = 1;    // external tools in parallel
+        (*context)->profile          = false;
+        (*context)->binary_msc       = false;
+        (*context)->direct_calls     = false;
+        (*context)->thread_local_buffers = false;
+        (*context)->gui_events       = false;
+        (*context)->gui_period       = 40;
+        (*context)->gui_shm          = false;
+        (*context)->fail_unschedulable = false;
+        (*context)->task_attributes  = false;
+        (*context)->direct_encode    = false;
+        (*context)->check_only       = false;
+        (*context)->incremental      = false;
 }
 
 // Free the memory of a Context data structure
@@ -896,17 +1166,26 @@ void Clear_Context(Context * context)
     if (NULL != context) {
         if (NULL != context->output)
             free(context->output);
+        free(context->ifview);
+        free(context->dataview);
         if (NULL != context->stacksize)
             free(context->stacksize);
+        if (NULL != context->stack_config)
+            free(context->stack_config);
         free(context);
     }
 }
 
 
+static void release_fv(void *fv)
+{
+    Clear_FV(fv);
+}
+
 // Allocate memory for a new FV
 void Create_FV(FV ** fv)
 {
-    *fv = (FV *) malloc(sizeof(**fv));
+    *fv = AST_Alloc_Node(sizeof(**fv), release_fv);
 
     if (NULL != *fv) {
         (*fv)->name = NULL;
@@ -917,7 +1196,10 @@ void Create_FV(FV ** fv)
         (*fv)->zipfile = NULL;
         (*fv)->runtime_nature = unknown_runtime;
         (*fv)->calling_threads = NULL;
+        (*fv)->calling_thread_set = NULL;
         (*fv)->thread_id = 0;
+        (*fv)->priority = 0;
+        (*fv)->stack_size = 0;
         (*fv)->process = NULL;
         (*fv)->context_parameters = NULL;
         /* artificial: for VT-created functions */
@@ -929,6 +1211,10 @@ void Create_FV(FV ** fv)
         (*fv)->timer_list = NULL;
         (*fv)->is_component_type = false;
         (*fv)->instance_of = NULL;
+        (*fv)->interface_index = Create_Symbol_Table();
+        (*fv)->ri_index = Create_Symbol_Table();
+        (*fv)->position = 0;
+        (*fv)->location = NULL;
     }
 
 }
@@ -959,6 +1245,19 @@ void Clear_FV(FV * fv)
         fv->zipfile = NULL;
     }
 
+    if (NULL != fv->location) {
+        free (fv->location);
+        fv->location = NULL;
+    }
+
+    free(fv->original_name);
+    fv->original_name = NULL;
+    free(fv->instance_of);
+    fv->instance_of = NULL;
+
+    /* The names of the timers are those of the context parameters */
+    fv->timer_list = NULL;
+
     if (NULL != fv->calling_threads) {
         fv->calling_threads = NULL;
     }
@@ -968,6 +1267,11 @@ void Clear_FV(FV * fv)
     if (NULL != fv->instance_of) {
         fv->instance_of = NULL;
     }
+
+    Clear_Symbol_Table(fv->interface_index);
+    fv->interface_index = NULL;
+    Clear_Symbol_Table(fv->ri_index);
+    fv->ri_index = NULL;
 }
 
 
@@ -977,6 +1281,8 @@ void Create_System(System ** s)
     *s = (System *) malloc(sizeof(**s));
 
     if (NULL != *s) {
+        /* The nodes of the AST are allocated in the arena (AST_Alloc) */
+        (*s)->arena = Create_Arena();
         (*s)->name = NULL;
         Create_Context(&((*s)->context));
         (*s)->functions = NULL;
@@ -984,6 +1290,8 @@ void Create_System(System ** s)
         (*s)->processes = NULL;
         (*s)->packages = NULL;
         (*s)->connections = NULL;
+        (*s)->fv_index = Create_Symbol_Table();
+        (*s)->pending_ris = Create_Symbol_Table();
     }
 }
 
@@ -1000,12 +1308,59 @@ void Clear_System(System * s)
 
     Clear_Context(s->context);
 
-    Clear_FV_List(s->functions);
-
     Clear_Packages_List(s->packages);
 
-    Clear_Connections_List(s->connections);
+    Clear_Symbol_Table(s->fv_index);
+    s->fv_index = NULL;
+    Clear_Symbol_Table(s->pending_ris);
+    s->pending_ris = NULL;
+
+    /* Release all the nodes of the AST at once. The functions, interfaces,
+     * processes, etc. free their strings before (see AST_Alloc_Node), also
+     * those that are no longer in the lists of the System */
+    Free_Arena(s->arena);
+    s->arena = NULL;
+}
+
+/* Allocate memory for a node of the AST - it is freed with the System */
+void *AST_Alloc(size_t size)
+{
+    System *s = get_system_ast();
+
+    assert(NULL != s && NULL != s->arena);
+    return Arena_Alloc(s->arena, size);
+}
+
+/* Allocate a node of the AST that owns strings (make_string, build_string):
+ * release (node) frees them when the System is deleted */
+void *AST_Alloc_Node(size_t size, void (*release)(void *))
+{
+    void *node = AST_Alloc(size);
+
+    Arena_Defer_Free(get_system_ast()->arena, release, node);
+    return node;
+}
+
+static void free_symbol_table(void *table)
+{
+    Clear_Symbol_Table(table);
+}
+
+/* Generation of the set indexes (see UPDATE_SET_INDEX) */
+size_t set_index_generation = 0;
+
+void Invalidate_Set_Indexes(void)
+{
+    set_index_generation++;
+}
+
+/* Allocate a symbol table that is freed with the System (set indexes) */
+Symbol_Table *AST_Symbol_Table(void)
+{
+    Symbol_Table *table = Create_Symbol_Table();
 
+    Arena_Defer_Free(get_system_ast()->arena, free_symbol_table, table);
+    return table;
 }
 
 /* Check if a FV has context parameters (exclude Directives, Timers, etc.) */
@@ -1055,6 +1410,83 @@ int CountActivePI(Interface_list *interfaces)
     return res;
 }
 
+/* Check that two lists of parameters have the same types, in order */
+static bool Same_Param_Types(Parameter_list *one, Parameter_list *two)
+{
+    while (NULL != one && NULL != two) {
+        if (strcmp(one->value->type, two->value->type)) return false;
+        one = one->next;
+        two = two->next;
+    }
+    return NULL == one && NULL == two;
+}
+
+/*
+ * Option --direct-calls: return the provided interface called by a sync RI
+ * when both functions are in C or C++ and run in the same partition (the
+ * RI can then pass its typed parameters to the PI, without encoding them),
+ * or NULL if the call has to go through the VM
+ */
+Interface *Direct_Call_Target(Interface *ri)
+{
+    FV          *caller = ri->parent_fv,
+                *callee = NULL;
+    Interface   *pi = NULL;
+
+    if (!get_context()->direct_calls || !get_context()->polyorb_hi_c
+        || RI != ri->direction || synch != ri->synchronism
+        || NULL == ri->distant_fv
+        || (c != caller->language && cpp != caller->language)
+        || NULL == caller->process) {
+        return NULL;
+    }
+
+    callee = FindFV(ri->distant_fv);
+    if (NULL == callee || callee->artificial
+        || (c != callee->language && cpp != callee->language)
+        || callee->process != caller->process) {
+        return NULL;
+    }
+
+    pi = ri->connected_pi;
+    if (NULL == pi || callee != pi->parent_fv || synch != pi->synchronism
+        || !Same_Param_Types(ri->in, pi->in)
+        || !Same_Param_Types(ri->out, pi->out)) {
+        return NULL;
+    }
+    return pi;
+}
+
+/*
+ * Option --direct-encode: check if the parameter of an async RI can be
+ * encoded directly in the PolyORB-HI-C request of the calling thread.
+ * The request is a static variable, reused for each message: this is only
+ * safe if nothing but the thread itself runs the code of the function
+ * (a thread with no synchronous PI). The functions created by the vertical
+ * transformation and the languages without invoke_ri.c are not concerned.
+ */
+bool Direct_Encode(Interface *ri)
+{
+    FV   *fv = ri->parent_fv;
+    bool result = true;
+
+    if (!get_context()->direct_encode || !get_context()->polyorb_hi_c
+        || RI != ri->direction || asynch != ri->synchronism
+        || NULL == ri->in || NULL != ri->in->next
+        || thread_runtime != fv->runtime_nature || NULL == fv->process
+        || fv->artificial || fv->is_component_type
+        || sdl == fv->language || blackbox_device == fv->language
+        || qgenada == ri->distant_qgen->language
+        || qgenc == ri->distant_qgen->language) {
+        return false;
+    }
+
+    FOREACH(pi, Interface, fv->interfaces, {
+        if (PI == pi->direction && synch == pi->synchronism) result = false;
+    });
+    return result;
+}
+
 /* Check if a list of input parameters match a list of output parameters.
  * IMPORTANT : it must be checked first that the number of IN and OUT
  * parameters are the same (using CountParams)
@@ -1141,7 +1573,7 @@ void List_QGen_Param_Types_And_Names(Parameter * p, FILE ** file)
 }
 
 /* Write to file the list of parameters, separated by commas (used for a call function) */
-void List_QGen_Param_Names(Parameter * p, FILE ** file, Language lang)
+void List_QGen_Param_Names(Parameter * p, Text_Builder * text, Language lang)
 {
     unsigned int separator = 0;
 
@@ -1154,10 +1586,10 @@ void List_QGen_Param_Names(Parameter * p, FILE ** file, Language lang)
 
     if ((qgenada == lang) ||
         (qgenc == lang && integer != p->basic_type && real != p->basic_type && boolean != p->basic_type))
-        fprintf(*file, "%s%s_%s", separator ? ", " : " ",
+        Text_Printf(text, "%s%s_%s", separator ? ", " : " ",
             (param_in == p->param_direction) ? "IN" : "OUT", p->name);
     else
-        fprintf(*file, "%s%s_%s", separator ? ", " : " ",
+        Text_Printf(text, "%s%s_%s", separator ? ", " : " ",
             (param_in == p->param_direction) ? "*IN" : "OUT", p->name);
 }
 
@@ -1188,7 +1620,7 @@ void Add_With_RI_Wrapper_to_Ada(Interface * i, FILE ** file)
  * Write to file the list of parameters with their type, separated with commas:
  * const asn1SccTYPE1 *IN_param1, ..., asn1SccTYPEi *OUT_parami
  */
-void List_C_Types_And_Params_With_Pointers(Parameter * p, FILE ** file)
+void List_C_Types_And_Params_With_Pointers(Parameter * p, Text_Builder * text)
 {
     unsigned int comma = 0;
 
@@ -1199,7 +1631,7 @@ void List_C_Types_And_Params_With_Pointers(Parameter * p, FILE ** file)
              && (NULL != p->interface->in
                  || p != p->interface->out->value)));
 
-    fprintf(*file, "%s%sasn1Scc%s *%s_%s",
+    Text_Printf(text, "%s%sasn1Scc%s *%s_%s",
             comma ? ", " : "",
             (param_in == p->param_direction) ? "const " : "",
             p->type,
@@ -1227,7 +1659,7 @@ void List_C_Params(Parameter * p, FILE ** file)
 }
 
 // ForEachWithParam function : Write to file the list of parameters + size separated with commas (form "IN_buf_param1, size_IN_buf_param1,.., OUT_buf_parami, &size_OUT_buf_parami....") 
-void List_C_Params_And_Size(Parameter * p, FILE ** file)
+void List_C_Params_And_Size(Parameter * p, Text_Builder * text)
 {
     unsigned int comma = 0;
 
@@ -1238,7 +1670,7 @@ void List_C_Params_And_Size(Parameter * p, FILE ** file)
              && (NULL != p->interface->in
                  || p != p->interface->out->value)));
 
-    fprintf(*file, "%s%s_buf_%s, %s_buf_%s",
+    Text_Printf(text, "%s%s_buf_%s, %s_buf_%s",
             comma ? ", " : "",
             (param_in == p->param_direction) ? "IN" : "OUT",
             p->name,
@@ -1336,7 +1768,7 @@ void create_enum_file(FV *fv)
     })
     fprintf (f, "\n};\n");
 
-    fclose(f);
+    close_file(&f);
     free(path);
 }
 
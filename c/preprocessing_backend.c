@@ -16,12 +16,15 @@
      manager (one per partition).
   5) Set the "ignore_params" flag on interfaces that run on the same node
   6) Create a TASTE API that provides useful features to User functions
+  7) With --gui-events, add a receiver function that sends the messages
+     of each GUI as events to its (then sporadic) polling PI
  */
 
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include <assert.h>
 #include <stdbool.h>
@@ -35,8 +38,264 @@ static int thread_id = 0;
 // Files used for the timer management
 FILE *header = NULL, *code = NULL;
 
+/*
+ * Option --timer-wheel: code of the timer manager based on a hashed timing
+ * wheel. The active timers are linked in the slot of the tick when they
+ * expire (modulo the number of slots): SET and RESET take a constant time
+ * and a tick only visits the timers of one slot, instead of decrementing
+ * all the timers of the node. A duration that is not a multiple of the
+ * resolution is rounded up, and the delay is subtracted from the next
+ * duration of the timer, so that a periodic timer does not drift.
+ */
+static void Timer_Wheel_Manager(FV *fv, String_list *all_timers, int count)
+{
+    int timer_res = get_context()->timer_resolution;
+    int slots = 64;
+
+    /* Keep the slots short: no more than one timer per two slots */
+    while (slots < 2 * count) slots *= 2;
+
+    fprintf (code, "/*\n"
+                   " * Timing wheel: each active timer is linked in the slot of the tick\n"
+                   " * of its expiration. Durations that are not a multiple of the timer\n"
+                   " * resolution are rounded up to the next tick; the delay is carried\n"
+                   " * over and subtracted from the next duration of the timer.\n"
+                   " */\n"
+                   "#define TIMER_RESOLUTION %d\n"
+                   "#define WHEEL_SLOTS      %d\n\n"
+                   "static struct {\n"
+                   "    unsigned long long expiry;   /* tick of the expiration */\n"
+                   "    long long late;              /* delay of the expiration (ms) */\n"
+                   "    long long carry;             /* delay of the last expiration */\n"
+                   "    int next, prev;              /* in the slot (index + 1, 0 = none) */\n"
+                   "    enum { inactive, active } state;\n"
+                   "} timers[%d];\n\n"
+                   "/* First timer of each slot (index + 1, 0 = none) */\n"
+                   "static int wheel[WHEEL_SLOTS];\n\n"
+                   "/* Number of ticks since startup */\n"
+                   "static unsigned long long now = 0;\n\n",
+                   timer_res,
+                   slots,
+                   count);
+
+    fprintf (code, "static void timer_unlink(int t)\n"
+                   "{\n"
+                   "    if (0 != timers[t].prev)\n"
+                   "        timers[timers[t].prev - 1].next = timers[t].next;\n"
+                   "    else\n"
+                   "        wheel[timers[t].expiry %% WHEEL_SLOTS] = timers[t].next;\n"
+                   "    if (0 != timers[t].next)\n"
+                   "        timers[timers[t].next - 1].prev = timers[t].prev;\n"
+                   "    timers[t].state = inactive;\n"
+                   "}\n\n"
+                   "static void timer_set(int t, unsigned long long ms)\n"
+                   "{\n"
+                   "    long long remaining = (long long) ms - timers[t].carry;\n"
+                   "    long long ticks = remaining <= 0 ? 1 :\n"
+                   "        (remaining + TIMER_RESOLUTION - 1) / TIMER_RESOLUTION;\n"
+                   "    int slot;\n\n"
+                   "    if (active == timers[t].state) timer_unlink(t);\n"
+                   "    timers[t].late  = ticks * TIMER_RESOLUTION - remaining;\n"
+                   "    timers[t].carry = 0;\n"
+                   "    timers[t].expiry = now + (unsigned long long) ticks;\n"
+                   "    slot = (int) (timers[t].expiry %% WHEEL_SLOTS);\n"
+                   "    timers[t].prev = 0;\n"
+                   "    timers[t].next = wheel[slot];\n"
+                   "    if (0 != wheel[slot]) timers[wheel[slot] - 1].prev = t + 1;\n"
+                   "    wheel[slot] = t + 1;\n"
+                   "    timers[t].state = active;\n"
+                   "}\n\n"
+                   "static void timer_reset(int t)\n"
+                   "{\n"
+                   "    if (active == timers[t].state) timer_unlink(t);\n"
+                   "}\n\n");
+
+    /* Table of the RIs called when the timers expire */
+    FOREACH (timer, String, all_timers, {
+        fprintf (code, "void %s_RI_%s(void);\n", fv->name, timer);
+    });
+    fprintf (code, "\nstatic void (*const expire[%d])(void) = {\n", count);
+    FOREACH (timer, String, all_timers, {
+        fprintf (code, "    %s_RI_%s,\n", fv->name, timer);
+    });
+    fprintf (code, "};\n\n");
+
+    fprintf (code, "void %s_startup()\n"
+                   "{\n"
+                   "    /* Timer start up (nothing to do) */\n"
+                   "}\n\n", fv->name);
+
+    /* The timers that expire at the same tick are called in the order of
+     * the enum, as with the linear timer manager */
+    fprintf (code, "void %s_PI_tick_%dms()\n"
+                   "{\n"
+                   "    int fired[%d];\n"
+                   "    int count = 0, i, t, next;\n\n"
+                   "    now++;\n"
+                   "    for (t = wheel[now %% WHEEL_SLOTS]; 0 != t; t = next) {\n"
+                   "        next = timers[t - 1].next;\n"
+                   "        if (timers[t - 1].expiry == now) {\n"
+                   "            timer_unlink(t - 1);\n"
+                   "            timers[t - 1].carry = timers[t - 1].late;\n"
+                   "            for (i = count++; i > 0 && fired[i - 1] > t - 1; i--)\n"
+                   "                fired[i] = fired[i - 1];\n"
+                   "            fired[i] = t - 1;\n"
+                   "        }\n"
+                   "    }\n\n"
+                   "    for (i = 0; i < count; i++) {\n"
+                   "        expire[fired[i]]();\n"
+                   "    }\n"
+                   "}\n\n",
+                   fv->name,
+                   timer_res,
+                   count);
+}
+
+/*
+ * Unit test of the timing wheel, generated in the "test" directory of the
+ * timer manager: random SET, RESET and ticks are applied both to the timer
+ * manager and to the linear implementation, which must expire the same
+ * timers at the same ticks and in the same order.
+ */
+static void Timer_Wheel_Test(char *path, FV *fv, FV_list *fv_with_timer,
+                             String_list *all_timers, int count)
+{
+    FILE *test = NULL;
+    char *test_path = make_string ("%s/test", path);
+    char *filename = make_string ("%s_test.c", fv->name);
+
+    create_file (test_path, filename, &test);
+
+    fprintf (test, "/* Timer manager test */\n%s", do_not_modify_warning);
+
+    fprintf (test, "/*\n"
+                   " * Compare the expiration of the timers of the timing wheel with the\n"
+                   " * linear timer manager. Build and run it from the directory of the\n"
+                   " * timer manager:\n"
+                   " *   cc -I. -I<path to C_ASN1_Types.h> test/%s -o %s_test\n"
+                   " *   ./%s_test\n"
+                   " */\n\n"
+                   "#include <stdio.h>\n"
+                   "#include <stdlib.h>\n\n"
+                   "#include \"%s.c\"\n\n"
+                   "#define STEPS 1000000\n\n"
+                   "static int wheel_fired[%d], wheel_count = 0;\n\n",
+                   filename,
+                   fv->name,
+                   fv->name,
+                   fv->name,
+                   count);
+
+    /* The RIs of the timer manager record the expired timers */
+    FOREACH (timer, String, all_timers, {
+        fprintf (test, "void %s_RI_%s(void)\n"
+                       "{\n"
+                       "    wheel_fired[wheel_count++] = %s;\n"
+                       "}\n\n",
+                       fv->name,
+                       timer,
+                       timer);
+    });
+
+    fprintf (test, "static void (*const set_timer[%d])(const asn1SccT_UInt32 *) = {\n",
+                   count);
+    FOREACH (function, FV, fv_with_timer, {
+        FOREACH (timer, String, function->timer_list, {
+            fprintf (test, "    %s_PI_%s_SET_%s,\n",
+                           fv->name,
+                           function->name,
+                           timer);
+        });
+    });
+    fprintf (test, "};\n\n"
+                   "static void (*const reset_timer[%d])(void) = {\n",
+                   count);
+    FOREACH (function, FV, fv_with_timer, {
+        FOREACH (timer, String, function->timer_list, {
+            fprintf (test, "    %s_PI_%s_RESET_%s,\n",
+                           fv->name,
+                           function->name,
+                           timer);
+        });
+    });
+    fprintf (test, "};\n\n");
+
+    /* Reference: the linear timer manager, with durations rounded up and
+     * the delays carried over to the next duration */
+    fprintf (test, "static struct {\n"
+                   "    long long value;\n"
+                   "    long long late, carry;\n"
+                   "    int       active;\n"
+                   "} linear[%d];\n\n"
+                   "static int linear_fired[%d], linear_count = 0;\n\n"
+                   "static void linear_tick(void)\n"
+                   "{\n"
+                   "    int t;\n\n"
+                   "    for (t = 0; t < %d; t++) {\n"
+                   "        if (linear[t].active && 0 == --linear[t].value) {\n"
+                   "            linear_fired[linear_count++] = t;\n"
+                   "            linear[t].active = 0;\n"
+                   "            linear[t].carry = linear[t].late;\n"
+                   "        }\n"
+                   "    }\n"
+                   "}\n\n",
+                   count,
+                   count,
+                   count);
 
+    fprintf (test, "int main(void)\n"
+                   "{\n"
+                   "    long step;\n"
+                   "    int  i, expired = 0;\n\n"
+                   "    srand(1);\n"
+                   "    for (step = 0; step < STEPS; step++) {\n"
+                   "        int t = rand() %% %d;\n"
+                   "        int op = rand() %% 4;\n\n"
+                   "        if (0 == op) {\n"
+                   "            /* Up to 4 rounds of the wheel, half multiples of the tick */\n"
+                   "            long long ticks = 1 + rand() %% (4 * WHEEL_SLOTS);\n"
+                   "            asn1SccT_UInt32 ms = (asn1SccT_UInt32) (rand() %% 2 ?\n"
+                   "                ticks * TIMER_RESOLUTION :\n"
+                   "                (ticks - 1) * TIMER_RESOLUTION + 1 + rand() %% TIMER_RESOLUTION);\n\n"
+                   "            long long remaining = (long long) ms - linear[t].carry;\n\n"
+                   "            set_timer[t](&ms);\n"
+                   "            linear[t].active = 1;\n"
+                   "            linear[t].value = remaining <= 0 ? 1 :\n"
+                   "                (remaining + TIMER_RESOLUTION - 1) / TIMER_RESOLUTION;\n"
+                   "            linear[t].late = linear[t].value * TIMER_RESOLUTION - remaining;\n"
+                   "            linear[t].carry = 0;\n"
+                   "        }\n"
+                   "        else if (1 == op) {\n"
+                   "            reset_timer[t]();\n"
+                   "            linear[t].active = 0;\n"
+                   "        }\n"
+                   "        else {\n"
+                   "            wheel_count = linear_count = 0;\n"
+                   "            %s_PI_tick_%dms();\n"
+                   "            linear_tick();\n"
+                   "            expired += linear_count;\n"
+                   "            for (i = 0; i < wheel_count || i < linear_count; i++) {\n"
+                   "                if (wheel_count != linear_count\n"
+                   "                    || wheel_fired[i] != linear_fired[i]) {\n"
+                   "                    printf(\"[ERROR] Step %%ld: timers expired in a \"\n"
+                   "                           \"different order\\n\", step);\n"
+                   "                    return 1;\n"
+                   "                }\n"
+                   "            }\n"
+                   "        }\n"
+                   "    }\n"
+                   "    printf(\"[OK] %%d timers expired as with the linear timer manager\\n\",\n"
+                   "           expired);\n"
+                   "    return 0;\n"
+                   "}\n",
+                   count,
+                   fv->name,
+                   get_context()->timer_resolution);
 
+    close_file (&test);
+    free (filename);
+    free (test_path);
+}
 
 /* Create a new function to manage the timers of a given node */
 FV *Add_timer_manager(Process *node, FV_list *fv_with_timer)
@@ -71,7 +330,7 @@ FV *Add_timer_manager(Process *node, FV_list *fv_with_timer)
     interface->wcet_low = 1;
     interface->wcet_low_unit = make_string ("ms");
     interface->wcet_high_unit = make_string ("ms");
-    APPEND_TO_LIST (Interface, fv->interfaces, interface);
+    Add_Interface_To_FV (fv, interface);
     /* Set flag indicating that this function was created during VT */
     fv->timer = true;
 
@@ -133,6 +392,14 @@ FV *Add_timer_manager(Process *node, FV_list *fv_with_timer)
     });
     fprintf (header, "\n} %s_timers;\n\n", fv->name);
 
+    if (get_context()->timer_wheel) {
+        Timer_Wheel_Manager (fv, all_timers, count);
+        Timer_Wheel_Test (path, fv, fv_with_timer, all_timers, count);
+        close_file (&hook);
+        free (path);
+        return fv;
+    }
+
     /* In the code, declare a static variable holding the timers state */
     fprintf (code, "static struct {\n"
                      "    long long value;\n"
@@ -198,6 +465,32 @@ void Add_timers_to_function (FV *fv, FV *timer_manager)
                          timer_manager->name,
                          fv->name,
                          timer);
+        fprintf (header, "void %s_PI_%s_RESET_%s();\n\n",
+                         timer_manager->name,
+                         fv->name,
+                         timer);
+
+        if (get_context()->timer_wheel) {
+            fprintf (code, "void %s_PI_%s_SET_%s(const asn1SccT_UInt32 *val)\n"
+                           "{\n"
+                           "    timer_set(%s_%s, *val);\n"
+                           "}\n\n"
+                           "void %s_PI_%s_RESET_%s()\n"
+                           "{\n"
+                           "    timer_reset(%s_%s);\n"
+                           "}\n\n",
+                           timer_manager->name,
+                           fv->name,
+                           timer,
+                           fv->name,
+                           timer,
+                           timer_manager->name,
+                           fv->name,
+                           timer,
+                           fv->name,
+                           timer);
+        }
+        else {
         fprintf (code, "void %s_PI_%s_SET_%s(const asn1SccT_UInt32 *val)\n"
                        "{\n"
                        "    /* Timer value must be multiple of %d ms */\n"
@@ -215,10 +508,6 @@ void Add_timers_to_function (FV *fv, FV *timer_manager)
                        fv->name,
                        timer,
                        timer_res);
-        fprintf (header, "void %s_PI_%s_RESET_%s();\n\n",
-                         timer_manager->name,
-                         fv->name,
-                         timer);
         fprintf (code, "void %s_PI_%s_RESET_%s()\n"
                        "{\n"
                        "    timers[%s_%s].state = inactive;\n"
@@ -228,6 +517,7 @@ void Add_timers_to_function (FV *fv, FV *timer_manager)
                        timer,
                        fv->name,
                        timer);
+        }
 
         /* Add sporadic PI - corresponding to the timer expiration */
         expire = NULL;
@@ -244,17 +534,18 @@ void Add_timers_to_function (FV *fv, FV *timer_manager)
         expire->wcet_low       = 10;
         expire->wcet_low_unit  = make_string ("ms");
         expire->wcet_high_unit = make_string ("ms");
-        APPEND_TO_LIST (Interface, fv->interfaces, expire);
+        Add_Interface_To_FV (fv, expire);
 
         /* Add corresponding RI in the timer manager */
         expire = Duplicate_Interface (RI, expire, timer_manager);
+        free (expire->name);
         expire->name            = expire->distant_name;
         expire->distant_name    = make_string (timer);
         free (expire->distant_fv);
         expire->distant_fv      = make_string (fv->name);
         /* Filter: set the list of calling PIs in the timer manager */
         ADD_TO_SET(Interface, expire->calling_pis, cyclic_pi);
-        APPEND_TO_LIST (Interface, timer_manager->interfaces, expire);
+        Add_Interface_To_FV (timer_manager, expire);
 
         /* Add Protected PI "RESET_timer" to timer manager (no param) */
         reset_timer = Duplicate_Interface (PI, expire, timer_manager);
@@ -266,17 +557,19 @@ void Add_timers_to_function (FV *fv, FV *timer_manager)
         reset_timer->distant_name = make_string ("RESET_%s", timer); // irrelevant in PI
         reset_timer->rcm          = protected;
         reset_timer->synchronism  = synch;
-        APPEND_TO_LIST (Interface, timer_manager->interfaces, reset_timer);
+        Add_Interface_To_FV (timer_manager, reset_timer);
 
         /* Add corresponding RI in the user FV */
         reset_timer = Duplicate_Interface (RI, reset_timer, fv);
         free (reset_timer->distant_fv);
         reset_timer->distant_fv   = make_string (timer_manager->name);
+        free (reset_timer->name);
         reset_timer->name         = make_string("RESET_%s", timer);
+        free (reset_timer->distant_name);
         reset_timer->distant_name = make_string("%s_%s",
                                                 fv->name,
                                                 reset_timer->name);
-        APPEND_TO_LIST (Interface, fv->interfaces, reset_timer);
+        Add_Interface_To_FV (fv, reset_timer);
 
         /* Add Protected PI "SET_timer(value)" in timer manager */
         /* Note: it must be protected to avoid race condition with the tick function */
@@ -299,17 +592,19 @@ void Add_timers_to_function (FV *fv, FV *timer_manager)
         param->interface       = set_timer;
         param->param_direction = param_in;
         APPEND_TO_LIST (Parameter, set_timer->in, param);
-        APPEND_TO_LIST (Interface, timer_manager->interfaces, set_timer);
+        Add_Interface_To_FV (timer_manager, set_timer);
 
         /* Add corresponding RI in the user FV */
         set_timer = Duplicate_Interface (RI, set_timer, fv);
         free (set_timer->distant_fv);
+        free (set_timer->name);
         set_timer->name         = make_string("SET_%s", timer);
+        free (set_timer->distant_name);
         set_timer->distant_name = make_string("%s_%s",
                                                 fv->name,
                                                 set_timer->name);
         set_timer->distant_fv = make_string (timer_manager->name);
-        APPEND_TO_LIST (Interface, fv->interfaces, set_timer);
+        Add_Interface_To_FV (fv, set_timer);
     });
 }
 
@@ -370,8 +665,8 @@ void Add_Artificial_Function (Interface *duplicate_pi,
    build_string(&(duplicate_ri->name), ri_name, strlen(ri_name));
    duplicate_ri->synchronism = synch;
 
-   APPEND_TO_LIST (Interface, new_fv->interfaces, duplicate_pi);
-   APPEND_TO_LIST (Interface, new_fv->interfaces, duplicate_ri);
+   Add_Interface_To_FV (new_fv, duplicate_pi);
+   Add_Interface_To_FV (new_fv, duplicate_ri);
 
    End_FV();
 
@@ -390,7 +685,7 @@ void Add_Artificial_Function (Interface *duplicate_pi,
     *    to the orchestrator work */
     path = make_string ("%s/%s", OUTPUT_PATH, new_fv->name);
     new_fv->artificial    = true;
-    new_fv->original_name = original_name;
+    new_fv->original_name = make_string ("%s", original_name);
 
     create_file (path, "_hook", &hook);
     close_file (&hook);
@@ -479,6 +774,8 @@ void ProcessArtificial_FV_Creation (Interface *i, RCM rcm)
                              "artificial_", strlen("artificial_"));
                 build_string(&(distant_RI->distant_name),
                              i->name, strlen(i->name));
+                Reindex_RI(caller, distant_RI);
+                Invalidate_Set_Indexes();
             }
         });
 
@@ -546,108 +843,179 @@ void Add_RI_To_Thread (Interface *i, FV *fv)
                          i->name, strlen(i->name));
         }
 
-        APPEND_TO_LIST (Interface, fv->interfaces, new_interface);
+        Add_Interface_To_FV (fv, new_interface);
     }
     free(new_name);
 }
 
 
-/* Add a thread to the calling list */
-void Add_Thread_To_Calling_List (FV_list **calling_threads_list, FV *fv) 
+/*
+ * Calling threads are kept in lists, since their order is visible in the
+ * generated code, and in bitsets indexed by thread id for the lookups.
+ * The bitsets are sized when the propagation starts (all threads known).
+ */
+static size_t thread_set_words = 0;
+
+static bool Is_Calling_Thread(uint64_t *bits, FV_list *list, FV *thread)
 {
-        assert(NULL != calling_threads_list);
-        assert(NULL != fv);
+    size_t id = (size_t) thread->thread_id;
 
-        FOREACH(t, FV, *calling_threads_list, {
-            if (t == fv) fv = NULL;
-        });
+    if (0 < thread->thread_id && id / 64 < thread_set_words) {
+        return NULL != bits && 0 != (bits[id / 64] & (1ULL << (id % 64)));
+    }
 
-        if (NULL != fv) {
-            APPEND_TO_LIST(FV, *calling_threads_list, fv);
-            return;
-        }
+    FOREACH(t, FV, list, {
+        if (t == thread) return true;
+    });
+    return false;
 }
 
-/* Pre-Processing: propagate Calling thread to distant FV
- *                 (used to allow sync function to make call to RI). */
-void Propagate_Calling_Thread(Interface *i, FV **fv)
+/* Add a thread to a calling list (if it is not already in) */
+static void Add_Thread_To_Calling_List (FV_list **calling_threads_list,
+                                        uint64_t **bits,
+                                        FV *thread)
 {
-    FV           *distant_fv       = NULL;
-    Interface    *corresponding_pi = NULL;
+    size_t id = (size_t) thread->thread_id;
 
-    /* Find the function to which the RI is connected */
-    distant_fv = FindFV(i->distant_fv);
+    if (Is_Calling_Thread(*bits, *calling_threads_list, thread)) return;
 
-    if(NULL == distant_fv) {
-        /* This RI is not connected */
-        return;
+    if (0 < thread->thread_id && id / 64 < thread_set_words) {
+        if (NULL == *bits) {
+            *bits = AST_Alloc(thread_set_words * sizeof(uint64_t));
+        }
+        (*bits)[id / 64] |= 1ULL << (id % 64);
     }
+    APPEND_TO_LIST(FV, *calling_threads_list, thread);
+}
 
-    /* Find the PI corresponding to the RI passed as first argument */
+/* PI reached by an RI, NULL if the RI is not connected */
+static Interface *Called_PI(Interface *ri)
+{
+    FV        *distant_fv = NULL;
+    Interface *pi = ri->connected_pi;
+
+    if (NULL != pi || NULL == ri->distant_fv) return pi;
+
+    distant_fv = FindFV(ri->distant_fv);
+    if (NULL == distant_fv) return NULL;
+
+    /* Not in the connection graph: RI without distant name */
     FOREACH(dist_i, Interface, distant_fv->interfaces, {
-        // Long-term temporary fix to support the new version of tasteIV
-        char *res = NULL;
-        if (NULL != i->distant_name) {
-            res = strchr(i->distant_name, '.');
-            if (NULL != res) {
-                printf("[preprocessing_backend.c] FIXME\n");
-                *res = '\0';
-            }
-        }
         if(PI == dist_i->direction &&
            !strcmp(dist_i->name,
-                   NULL != i->distant_name ? i->distant_name : i->name)) {
-            corresponding_pi = dist_i;
+                   NULL != ri->distant_name ? ri->distant_name : ri->name)) {
+            pi = dist_i;
         }
     });
 
-    assert(NULL != corresponding_pi);
+    assert(NULL != pi);
+    return pi;
+}
+
+/* Set that a thread calls a PI (and its function). Return true if the
+ * propagation must continue through the RIs of the function */
+static bool Reach_PI(Interface *pi, FV *thread)
+{
+    FV *distant_fv = pi->parent_fv;
 
     /*
     * Check that the calling thread is not already in the list of
-    * the distant fv/pi. This is essential to avoid infinite recursion
+    * the distant fv/pi. This is essential to stop the propagation
     * in case of circular dependencies
     */
-    FOREACH(ct, FV, corresponding_pi->calling_threads, {
-        if(ct == *fv) return;
-    });
-
-    FOREACH(ct, FV, distant_fv->calling_threads, {
-        if(ct == *fv) return;
-    });
+    if (Is_Calling_Thread(pi->calling_thread_set,
+                          pi->calling_threads, thread)
+        || Is_Calling_Thread(distant_fv->calling_thread_set,
+                             distant_fv->calling_threads, thread)) {
+        return false;
+    }
 
     /* Add the thread to the list of calling FV of the interface */
-    Add_Thread_To_Calling_List (&(corresponding_pi->calling_threads), *fv);
+    Add_Thread_To_Calling_List (&(pi->calling_threads),
+                                &(pi->calling_thread_set), thread);
 
     /* Also add the thread to the calling list of the FV itself */
-    Add_Thread_To_Calling_List (&(distant_fv->calling_threads), *fv);
+    Add_Thread_To_Calling_List (&(distant_fv->calling_threads),
+                                &(distant_fv->calling_thread_set), thread);
 
     /* And change the "distant fv" field of the corresponding PI */
-    if(NULL != corresponding_pi->distant_fv) {
-        free(corresponding_pi->distant_fv);
-        corresponding_pi->distant_fv = NULL;
+    if(NULL != pi->distant_fv) {
+        free(pi->distant_fv);
+        pi->distant_fv = NULL;
     }
-    build_string(&(corresponding_pi->distant_fv),
-                 (*fv)->name, strlen((*fv)->name));
-
-    if(passive_runtime == distant_fv->runtime_nature) {
-        /* Do the same recursively until we reach another thread */
-        FOREACH(sub_i, Interface, distant_fv->interfaces, {
-            if (RI == sub_i->direction) {
-            /* filter: some RIs are not called by the code of a given PI
-             * for example the timer expiration signal is only called by the
-             * cyclic PI of the timer manager. Don't propagate in that case
-             * to avoid explosion of the number of AADL ports in the CV */
-                if (NULL == sub_i->calling_pis
-                   || IN_SET(Interface, sub_i->calling_pis, corresponding_pi)) {
-                    Propagate_Calling_Thread(sub_i, fv);
-                }
+    build_string(&(pi->distant_fv), thread->name, strlen(thread->name));
+
+    return passive_runtime == distant_fv->runtime_nature;
+}
+
+/* Propagation step: passive function entered through one of its PIs */
+typedef struct {
+    Interface       *pi;
+    Interface_list  *next_ri;
+} Propagation_Step;
+
+/* Pre-Processing: propagate Calling thread to distant FV
+ *                 (used to allow sync function to make call to RI).
+ * Depth-first walk of the connection graph with an explicit stack, until
+ * another thread (or a function already reached by the thread) is found.
+ * This is still one walk per thread, i.e. O(threads x edges) overall: the
+ * bitsets of calling threads only make the membership tests constant time,
+ * the sets are not propagated word by word (the order of the lists and the
+ * distant_fv of the reached PIs depend on the visit order).
+ * misc/propagation-bench.c measures it on a long passive chain */
+void Propagate_Calling_Thread(Interface *i, FV **fv)
+{
+    Propagation_Step *stack = NULL;
+    size_t           depth = 0, capacity = 16;
+    Interface        *pi = Called_PI(i);
+
+    if (NULL == pi || !Reach_PI(pi, *fv)) return;
+
+    stack = malloc(capacity * sizeof(Propagation_Step));
+    assert(NULL != stack);
+    stack[depth].pi      = pi;
+    stack[depth].next_ri = pi->parent_fv->interfaces;
+    depth ++;
+
+    while (depth > 0) {
+        Propagation_Step *top = &stack[depth - 1];
+        Interface        *sub_i = NULL;
+
+        /* filter: some RIs are not called by the code of a given PI
+         * for example the timer expiration signal is only called by the
+         * cyclic PI of the timer manager. Don't propagate in that case
+         * to avoid explosion of the number of AADL ports in the CV */
+        while (NULL != top->next_ri && NULL == sub_i) {
+            Interface *candidate = top->next_ri->value;
+            top->next_ri = top->next_ri->next;
+            if (RI == candidate->direction
+                && (NULL == candidate->calling_pis
+                    || IN_SET(Interface, candidate->calling_pis, top->pi))) {
+                sub_i = candidate;
             }
-        });
+        }
+
+        if (NULL == sub_i) {
+            depth --;
+            continue;
+        }
+
+        /* Do the same with the passive function reached by the RI */
+        pi = Called_PI(sub_i);
+        if (NULL != pi && Reach_PI(pi, *fv)) {
+            if (depth == capacity) {
+                capacity *= 2;
+                stack = realloc(stack, capacity * sizeof(Propagation_Step));
+                assert(NULL != stack);
+            }
+            stack[depth].pi      = pi;
+            stack[depth].next_ri = pi->parent_fv->interfaces;
+            depth ++;
+        }
     }
+    free(stack);
 }
 
-
 /*
   Set of preprocessing done for each FV independently
 */
@@ -678,15 +1046,18 @@ void Preprocess_FV (FV *fv)
             interface->distant_fv = NULL;
             interface->direction=PI;
             interface->synchronism=asynch;
-            interface->rcm=cyclic;
-            /* Poll GUI queue every 40 ms */
-            interface->period = 40;
+            /* Poll GUI queue every 40 ms (by default, see --gui-period).
+             * With --gui-events, the PI is sporadic: it is called by the
+             * receiver of the GUI when messages arrive, and the period is
+             * the minimum inter-arrival time (see Add_gui_receiver) */
+            interface->rcm = get_context()->gui_events ? sporadic : cyclic;
+            interface->period = get_context()->gui_period;
             interface->parent_fv = fv;
             interface->wcet_high = 1;
             interface->wcet_low = 1;
             build_string(&(interface->wcet_low_unit), "ms", 2);
             build_string(&(interface->wcet_high_unit), "ms", 2);
-            APPEND_TO_LIST (Interface, fv->interfaces, interface);
+            Add_Interface_To_FV (fv, interface);
          }
       }
    }
@@ -721,7 +1092,7 @@ void Preprocess_FV (FV *fv)
             interface->wcet_low = 1;
             build_string(&(interface->wcet_low_unit), "ms", 2);
             build_string(&(interface->wcet_high_unit), "ms", 2);
-            APPEND_TO_LIST (Interface, fv->interfaces, interface);
+            Add_Interface_To_FV (fv, interface);
          } else {
             printf("Could not create interface!!!\n");
          }
@@ -900,15 +1271,17 @@ void Add_api(Process *node, FV_list *all_fv)
         param->interface       = pi;
         param->param_direction = param_out;
         APPEND_TO_LIST(Parameter, pi->out, param);
-        APPEND_TO_LIST(Interface, fv->interfaces, pi);
+        Add_Interface_To_FV (fv, pi);
 
         /* Add the corresponding RI in the user FV */
         ri = Duplicate_Interface(RI, pi, function);
+        free(ri->name);
         ri->name              = make_string("check_queue");
+        free(ri->distant_name);
         ri->distant_name      = make_string("%s", pi->name);
         free(ri->distant_fv);
         ri->distant_fv = make_string("%s", fv->name);
-        APPEND_TO_LIST(Interface, function->interfaces, ri);
+        Add_Interface_To_FV (function, ri);
         }
     });
 
@@ -1091,7 +1464,7 @@ void Preprocess_coverage (Process *node)
     interface->wcet_low = 10;
     interface->wcet_low_unit = make_string ("ms");
     interface->wcet_high_unit = make_string ("ms");
-    APPEND_TO_LIST (Interface, fv->interfaces, interface);
+    Add_Interface_To_FV (fv, interface);
     /* Set flag indicating that this function was created during VT */
     fv->timer = true;
 
@@ -1160,6 +1533,158 @@ void Preprocess_coverage (Process *node)
     close_file(&code);
 }
 
+/* Option --gui-events: create a function named <gui>_gui_receiver with a
+ * cyclic PI "receive" and an RI "gui_event" connected to the (sporadic)
+ * PI gui_polling_<gui> of the GUI. The receiver waits for the messages of
+ * the GUI (<gui>_gui_wait, in the GUI glue) and sends one event for each
+ * batch: the RIs of the GUI are then called by the thread of the sporadic
+ * PI, as they were by the cyclic poller. The PI "receive" returns after
+ * --gui-period ms at most, so that the receiver remains a periodic thread */
+static void Add_gui_receiver (Process *node, FV *gui_fv)
+{
+    FV        *fv = NULL;
+    Interface *receive = NULL, *event = NULL;
+    char      *name = NULL;
+    char      *path = NULL;
+    FILE      *hook = NULL;
+    int       period = get_context()->gui_period;
+
+    name = make_string ("%s_gui_receiver", gui_fv->name);
+
+    fv = (FV *) New_FV (name, strlen(name), name);
+
+    Set_Language_To_C();
+
+    Create_Interface (&receive);
+    Create_Interface (&event);
+
+    assert (NULL != fv && NULL != receive && NULL != event);
+
+    receive->name = make_string ("receive");
+    receive->distant_fv = NULL;
+    receive->direction = PI;
+    receive->synchronism = asynch;
+    receive->rcm = cyclic;
+    receive->period = period;
+    receive->parent_fv = fv;
+    receive->wcet_high = 1;
+    receive->wcet_low = 1;
+    receive->wcet_low_unit = make_string ("ms");
+    receive->wcet_high_unit = make_string ("ms");
+    Add_Interface_To_FV (fv, receive);
+
+    event->name = make_string ("gui_event");
+    event->distant_fv = make_string ("%s", gui_fv->name);
+    event->distant_name = make_string ("gui_polling_%s", gui_fv->name);
+    event->direction = RI;
+    event->synchronism = asynch;
+    event->rcm = sporadic;
+    event->parent_fv = fv;
+    ADD_TO_SET(Interface, event->calling_pis, receive);
+    Add_Interface_To_FV (fv, event);
+
+    /* Set flag indicating that this function was created during VT */
+    fv->timer = true;
+
+    End_FV();
+
+    /* Add the new FV to the binding list of the Process */
+    Set_Current_Process (node);
+    Add_Binding(name, strlen(name));
+
+   /* Create a file called "_hook" to add this function
+    * to the orchestrator work */
+    path = make_string ("%s/%s", OUTPUT_PATH, fv->name);
+
+    create_file (path, "_hook", &hook);
+    create_file (path, make_string ("%s.h", fv->name), &header);
+    create_file (path, make_string ("%s.c", fv->name), &code);
+
+    fprintf (header, "/* GUI receiver */\n%s", do_not_modify_warning);
+    fprintf (code, "/* GUI receiver */\n%s", do_not_modify_warning);
+
+    fprintf (header, "#ifndef __AUTO_CODE_H_%s__\n"
+                     "#define __AUTO_CODE_H_%s__\n\n"
+                     "#ifdef __cplusplus\n"
+                     "extern \"C\" {\n"
+                     "#endif\n\n",
+                     fv->name,
+                     fv->name);
+
+    fprintf (header, "void %s_startup();\n\n"
+                     "void %s_PI_receive();\n\n"
+                     "void %s_RI_gui_event();\n\n"
+                     "/* Defined in the glue of the GUI */\n"
+                     "int %s_gui_wait(int timeout_ms);\n\n",
+                     fv->name,
+                     fv->name,
+                     fv->name,
+                     gui_fv->name);
+
+    fprintf (header, "#ifdef __cplusplus\n"
+                     "}\n"
+                     "#endif\n\n"
+                     "#endif");
+
+    fprintf (code, "#include <time.h>\n\n"
+                   "#include \"%s.h\"\n\n", fv->name);
+
+    fprintf (code, "void %s_startup()\n"
+                   "{\n"
+                   "    /* GUI receiver start up (nothing to do) */\n"
+                   "}\n\n", fv->name);
+
+    /* Send an event for each batch of messages until the end of the
+     * period (the GUI function handles one event at a time) */
+    fprintf (code, "void %s_PI_receive()\n"
+                   "{\n"
+                   "    struct timespec start, now;\n"
+                   "    int remaining = %d;\n\n"
+                   "    clock_gettime(CLOCK_MONOTONIC, &start);\n"
+                   "    while (remaining > 0 && %s_gui_wait(remaining)) {\n"
+                   "        %s_RI_gui_event();\n"
+                   "        clock_gettime(CLOCK_MONOTONIC, &now);\n"
+                   "        remaining = %d - (int) ((now.tv_sec - start.tv_sec) * 1000\n"
+                   "                         + (now.tv_nsec - start.tv_nsec) / 1000000);\n"
+                   "    }\n"
+                   "}\n\n",
+                   fv->name,
+                   period,
+                   gui_fv->name,
+                   fv->name,
+                   period);
+
+    close_file (&hook);
+    close_file (&header);
+    close_file (&code);
+    free (path);
+}
+
+/* Option --gui-events: add a receiver to each GUI function of the node
+ * that has RIs (see Add_gui_receiver) */
+void Preprocess_gui_events (Process *node)
+{
+    FV_list *gui_fv = NULL;
+
+    /* The receivers are added to the bindings of the node: list the GUI
+     * functions first */
+    FOREACH (binding, Aplc_binding, node->bindings, {
+        if (gui == binding->fv->language) {
+            bool has_ri = false;
+            FOREACH (i, Interface, binding->fv->interfaces, {
+                if (RI == i->direction) has_ri = true;
+            });
+            if (has_ri) {
+                APPEND_TO_LIST(FV, gui_fv, binding->fv);
+            }
+        }
+    });
+
+    FOREACH (fv, FV, gui_fv, {
+        Add_gui_receiver (node, fv);
+    });
+}
+
 
 
 /* Look at all provided interfaces of a function and if some do
@@ -1192,6 +1717,10 @@ void Preprocessing_Backend (System *s)
     FOREACH (node, Process, s->processes, {
         /* Manage timers that may be declared as context parameters */
         Preprocess_timers(node);
+        /* Receivers of the GUI messages (option --gui-events) */
+        if (get_context()->gui_events) {
+            Preprocess_gui_events(node);
+        }
         /* Create a TASTE API function with a set of unprotected PIs */
         if(get_context()->polyorb_hi_c) {
             /* Functionality requires POHIC API */
@@ -1214,6 +1743,7 @@ void Preprocessing_Backend (System *s)
      * i.e look for all threads (functions have already been preprocessed)
      * then go through all their RIs recursively until reaching another thread,
      * and set that the function is a calling thread of the reached one */
+    thread_set_words = (size_t) thread_id / 64 + 1;
     FOREACH(fv, FV, s->functions, {
         if ((thread_runtime == fv->runtime_nature) && (true != fv->is_component_type)) {
             FOREACH(i, Interface, fv->interfaces, {
@@ -1277,10 +1807,8 @@ void Preprocessing_Backend (System *s)
         Interface   *ri     = NULL;
 
         /* Find the FV of the caller */
-        FOREACH (fv, FV, get_system_ast()->functions, {
-            if (!strcmp (fv->name, cnt->dst_system) && (true != fv->is_component_type)) caller = fv;
-         });
-        assert (NULL != caller);
+        caller = FindFV (cnt->dst_system);
+        assert (NULL != caller && true != caller->is_component_type);
 
         /* Find the corresponding RI in the caller */
         FOREACH (i, Interface, caller->interfaces, {
@@ -1289,9 +1817,10 @@ void Preprocessing_Backend (System *s)
         assert (NULL != ri);
 
         /* Find the FV of the callee */
-        FOREACH (fv, FV, get_system_ast()->functions, {
-            if (!strcmp (fv->name, ri->distant_fv) && (true != fv->is_component_type)) callee = fv;
-        });
+        callee = FindFV (ri->distant_fv);
+        if (NULL != callee && true == callee->is_component_type) {
+            callee = NULL;
+        }
 
         /* If the caller is passive we must create one connection
          * per calling thread */
@@ -0,0 +1,376 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Profiling of the phases of a run (option --profile).
+ *
+ * Each phase records its wall time, its CPU time (including the CPU time
+ * of the child processes it waited for), the peak RSS of the process at
+ * the end of the phase, and the number and size of the files generated
+ * during the phase. At the end of C_End the phases are printed as a table
+ * and written in two files of the output directory:
+ *   - profile.json:       the same table, for scripts
+ *   - profile_trace.json: Chrome trace events (chrome://tracing, Perfetto)
+ * The phases of the glue code processes (option --jobs) are sent back to
+ * the parent process through the pipe of the worker.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+#include "profile.h"
+
+#define MAX_DEPTH 16
+
+typedef struct {
+    const char  *phase;
+    const char  *fv_name;
+    pid_t       pid;
+    int         depth;
+    double      start_us;
+    double      wall_us;
+    double      cpu_us;
+    long        max_rss_kb;
+    int         files;
+    int         written;
+    size_t      bytes;
+} Phase;
+
+/* Counters when a phase was opened */
+typedef struct {
+    size_t      index;
+    double      cpu_us;
+    int         files;
+    int         written;
+    size_t      bytes;
+} Open_Phase;
+
+static struct timespec  origin;
+static pid_t            main_pid = 0;
+static Phase            *phases = NULL;
+static size_t           phase_count = 0;
+static size_t           phase_size = 0;
+static Open_Phase       stack[MAX_DEPTH];
+static int              depth = 0;
+
+double Profile_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - origin.tv_sec) * 1e6
+           + (double) (now.tv_nsec - origin.tv_nsec) / 1e3;
+}
+
+static double timeval_us(struct timeval tv)
+{
+    return (double) tv.tv_sec * 1e6 + (double) tv.tv_usec;
+}
+
+/* CPU time of the process and of the children it waited for */
+static double cpu_us(void)
+{
+    struct rusage self, children;
+
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    return timeval_us(self.ru_utime) + timeval_us(self.ru_stime)
+           + timeval_us(children.ru_utime) + timeval_us(children.ru_stime);
+}
+
+static long max_rss_kb(void)
+{
+    struct rusage self;
+
+    getrusage(RUSAGE_SELF, &self);
+    return self.ru_maxrss;
+}
+
+static Phase *new_phase(const char *phase, const char *fv_name)
+{
+    Phase *p = NULL;
+
+    if (phase_count == phase_size) {
+        phase_size = 0 == phase_size ? 64 : 2 * phase_size;
+        phases = realloc(phases, phase_size * sizeof(Phase));
+        assert(NULL != phases);
+    }
+    p = &phases[phase_count++];
+    memset(p, 0, sizeof(*p));
+    p->phase    = phase;
+    p->fv_name  = fv_name;
+    p->pid      = getpid();
+    p->depth    = depth;
+    p->start_us = Profile_Now();
+    return p;
+}
+
+static void open_phase(const char *phase, const char *fv_name)
+{
+    Open_Phase *open = NULL;
+
+    assert(depth < MAX_DEPTH);
+    new_phase(phase, fv_name);
+
+    open = &stack[depth++];
+    open->index  = phase_count - 1;
+    open->cpu_us = cpu_us();
+    Get_Output_Files_Count(&open->written, &open->files);
+    open->files += open->written;
+    open->bytes  = Get_Output_Bytes_Count();
+}
+
+void Profile_Init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+    main_pid = getpid();
+    phase_count = 0;
+    depth = 0;
+
+    /* The option is known only after parsing: record it in any case */
+    open_phase("parsing", NULL);
+}
+
+static bool profiling(void)
+{
+    return NULL != get_system_ast() && get_context()->profile;
+}
+
+void Profile_Begin(const char *phase, const char *fv_name)
+{
+    if (profiling()) {
+        open_phase(phase, fv_name);
+    }
+}
+
+void Profile_End(void)
+{
+    Open_Phase  *open = NULL;
+    Phase       *p = NULL;
+    int         written = 0, unchanged = 0;
+
+    if (!profiling() || 0 == depth) return;
+
+    open = &stack[--depth];
+    p = &phases[open->index];
+
+    Get_Output_Files_Count(&written, &unchanged);
+    p->wall_us    = Profile_Now() - p->start_us;
+    p->cpu_us     = cpu_us() - open->cpu_us;
+    p->max_rss_kb = max_rss_kb();
+    p->written    = written - open->written;
+    p->files      = written + unchanged - open->files;
+    p->bytes      = Get_Output_Bytes_Count() - open->bytes;
+}
+
+void Profile_Child(const char *phase, const char *fv_name, pid_t pid,
+                   double start_us, const struct rusage *usage)
+{
+    Phase *p = NULL;
+
+    if (!profiling()) return;
+
+    p = new_phase(phase, fv_name);
+    p->pid        = pid;
+    p->start_us   = start_us;
+    p->wall_us    = Profile_Now() - start_us;
+    p->cpu_us     = timeval_us(usage->ru_utime) + timeval_us(usage->ru_stime);
+    p->max_rss_kb = usage->ru_maxrss;
+}
+
+size_t Profile_Count(void)
+{
+    return phase_count;
+}
+
+/*
+ * The names of the phases are string literals or names from the AST,
+ * which have the same address in the parent and in the forked worker:
+ * the phases can be sent as they are. A worker records a dozen phases,
+ * which fit in the buffer of the pipe.
+ */
+void Profile_Send(int fd, size_t first)
+{
+    size_t count = phase_count - first;
+
+    if (!profiling()) return;
+
+    if (sizeof count != write(fd, &count, sizeof count)
+        || (ssize_t) (count * sizeof(Phase))
+           != write(fd, &phases[first], count * sizeof(Phase))) {
+        ERROR("[ERROR] Could not report the profile of the worker\n");
+    }
+}
+
+void Profile_Receive(int fd)
+{
+    size_t count = 0, i;
+
+    if (!profiling()
+        || sizeof count != read(fd, &count, sizeof count)) return;
+
+    for (i = 0; i < count; i++) {
+        Phase *p = new_phase(NULL, NULL);
+        if (sizeof(Phase) != read(fd, p, sizeof(Phase))) {
+            phase_count--;
+            break;
+        }
+    }
+}
+
+static void put_json_string(FILE *f, const char *str)
+{
+    if (NULL == str) {
+        fprintf(f, "null");
+        return;
+    }
+    fputc('"', f);
+    for (; '\0' != *str; str++) {
+        if ('"' == *str || '\\' == *str)
+            fprintf(f, "\\%c", *str);
+        else if ((unsigned char) *str < 0x20)
+            fprintf(f, "\\u%04x", (unsigned) *str);
+        else
+            fputc(*str, f);
+    }
+    fputc('"', f);
+}
+
+static void put_json_phase(FILE *f, const Phase *p)
+{
+    fprintf(f, "{\"phase\": ");
+    put_json_string(f, p->phase);
+    fprintf(f, ", \"function\": ");
+    put_json_string(f, p->fv_name);
+    fprintf(f, ", \"pid\": %ld, \"depth\": %d, \"start_us\": %.0f, "
+               "\"wall_us\": %.0f, \"cpu_us\": %.0f, \"max_rss_kb\": %ld, "
+               "\"files\": %d, \"written\": %d, \"bytes\": %zu}",
+            (long) p->pid, p->depth, p->start_us, p->wall_us, p->cpu_us,
+            p->max_rss_kb, p->files, p->written, p->bytes);
+}
+
+static FILE *open_report(const char *name)
+{
+    char *filename = make_string("%s/%s", OUTPUT_PATH, name);
+    FILE *f = fopen(filename, "w");
+
+    if (NULL == f) {
+        ERROR("[ERROR] Could not write file %s\n", filename);
+    }
+    free(filename);
+    return f;
+}
+
+static void write_json(const Phase *total)
+{
+    FILE    *f = open_report("profile.json");
+    size_t  i;
+
+    if (NULL == f) return;
+
+    fprintf(f, "{\n  \"total\": ");
+    put_json_phase(f, total);
+    fprintf(f, ",\n  \"phases\": [");
+    for (i = 0; i < phase_count; i++) {
+        fprintf(f, "%s\n    ", 0 == i ? "" : ",");
+        put_json_phase(f, &phases[i]);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+}
+
+static void write_trace(void)
+{
+    FILE    *f = open_report("profile_trace.json");
+    size_t  i;
+
+    if (NULL == f) return;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %ld, "
+               "\"args\": {\"name\": \"buildsupport\"}}",
+            (long) main_pid);
+    for (i = 0; i < phase_count; i++) {
+        const Phase *p = &phases[i];
+
+        fprintf(f, ",\n{\"name\": ");
+        put_json_string(f, p->phase);
+        fprintf(f, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.0f, "
+                   "\"dur\": %.0f, \"pid\": %ld, \"tid\": %ld, \"args\": "
+                   "{\"function\": ",
+                NULL == p->fv_name ? "phase" : "function",
+                p->start_us, p->wall_us, (long) main_pid, (long) p->pid);
+        put_json_string(f, p->fv_name);
+        fprintf(f, ", \"cpu_us\": %.0f, \"max_rss_kb\": %ld, \"files\": %d, "
+                   "\"written\": %d, \"bytes\": %zu}}",
+                p->cpu_us, p->max_rss_kb, p->files, p->written, p->bytes);
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+}
+
+static void print_phase(const Phase *p, const char *name)
+{
+    printf("  %*s%-*s %-32s %10.1f %10.1f %9.1f %6d %6d %10zu\n",
+           2 * p->depth, "", 30 - 2 * p->depth, name,
+           NULL == p->fv_name ? "" : p->fv_name,
+           p->wall_us / 1e3, p->cpu_us / 1e3,
+           (double) p->max_rss_kb / 1024.0,
+           p->files, p->written, p->bytes);
+}
+
+void Profile_Report(void)
+{
+    Phase   total;
+    int     written = 0, unchanged = 0;
+    size_t  i, glue_bytes = 0;
+    double  glue_cpu_us = 0.0;
+
+    if (!profiling()) return;
+
+    Get_Output_Files_Count(&written, &unchanged);
+    memset(&total, 0, sizeof total);
+    total.phase      = "total";
+    total.pid        = main_pid;
+    total.wall_us    = Profile_Now();
+    total.cpu_us     = cpu_us();
+    total.max_rss_kb = max_rss_kb();
+    total.files      = written + unchanged;
+    total.written    = written;
+    total.bytes      = Get_Output_Bytes_Count();
+
+    printf("[INFO] Profile (times in ms, peak RSS in MB):\n");
+    printf("  %-30s %-32s %10s %10s %9s %6s %6s %10s\n", "phase", "function",
+           "wall", "cpu", "peak RSS", "files", "writes", "bytes");
+    for (i = 0; i < phase_count; i++) {
+        print_phase(&phases[i], phases[i].phase);
+    }
+    print_phase(&total, total.phase);
+
+    /* Emission throughput of the glue backends (CPU time: with --jobs, the
+     * functions are processed at the same time) */
+    for (i = 0; i < phase_count; i++) {
+        if (0 == strcmp(phases[i].phase, "glue code")) {
+            glue_bytes  += phases[i].bytes;
+            glue_cpu_us += phases[i].cpu_us;
+        }
+    }
+    if (glue_cpu_us > 0.0) {
+        printf("[INFO] Glue code: %.2f MB in %.1f ms of CPU (%.1f MB/s)\n",
+               (double) glue_bytes / 1e6, glue_cpu_us / 1e3,
+               (double) glue_bytes / glue_cpu_us);
+    }
+
+    write_json(&total);
+    write_trace();
+}
@@ -0,0 +1,328 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Priorities of the threads and response-time analysis of the partitions.
+ *
+ * The threads of each partition get rate-monotonic priorities: the shorter
+ * the period (or the minimum inter-arrival time of a sporadic thread), the
+ * higher the priority. Threads with the same period share a priority.
+ * When a partition has more distinct periods than the platform has
+ * priorities, adjacent levels are merged (the order is kept) and the
+ * analysis below uses the merged levels.
+ * The interface view has no deadline property: the deadline of a thread is
+ * its period, hence deadline-monotonic and rate-monotonic orders are equal.
+ *
+ * The response time of each thread is the smallest fixed point of
+ *     R = C + B + sum over the higher or equal priority threads j of
+ *                 ceil(R / Tj) * Cj
+ * C is the highest WCET (Compute_Execution_Time) of the PIs of the thread.
+ * B is the longest protected PI that a lower priority thread may execute
+ * while holding the lock of a function that the thread calls (immediate
+ * ceiling: a thread is blocked at most once, before it starts).
+ *
+ * The results are written in schedulability.txt in the output directory.
+ * An unschedulable partition is a warning, or an error with the option
+ * --fail-unschedulable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+
+typedef struct {
+    FV          *fv;
+    uint64_t    period;     /* us, 0 if the thread has no MIAT */
+    uint64_t    wcet;       /* us */
+    uint64_t    blocking;   /* us */
+    uint64_t    response;   /* us */
+    int         level;      /* 0 is the highest priority */
+    bool        schedulable;
+} Sched_Thread;
+
+/* Convert a time of the interface view (AADL Time_Units) to microseconds */
+static uint64_t To_Microseconds(uint64_t value, const char *unit)
+{
+    if (NULL == unit || !strcasecmp(unit, "ms")) return value * 1000;
+    if (!strcasecmp(unit, "us")) return value;
+    if (!strcasecmp(unit, "ns")) return (value + 999) / 1000;
+    if (!strcasecmp(unit, "ps")) return (value + 999999) / 1000000;
+    if (!strcasecmp(unit, "sec")) return value * 1000000;
+    if (!strcasecmp(unit, "min")) return value * 60000000;
+    if (!strcasecmp(unit, "hr")) return value * 3600000000ULL;
+    return value * 1000;
+}
+
+static uint64_t PI_WCET(Interface *i)
+{
+    if (NULL == i->wcet_high_unit) return 0;
+    return To_Microseconds(i->wcet_high, i->wcet_high_unit);
+}
+
+/* Fill period and WCET from the cyclic or sporadic PIs of the thread */
+static void Thread_Timing(Sched_Thread *t)
+{
+    FOREACH(i, Interface, t->fv->interfaces, {
+        if (PI == i->direction
+            && (cyclic == i->rcm || sporadic == i->rcm || variator == i->rcm)) {
+            if (i->period > 0) {
+                t->period = To_Microseconds((uint64_t) i->period, "ms");
+            }
+            if (PI_WCET(i) > t->wcet) {
+                t->wcet = PI_WCET(i);
+            }
+        }
+    })
+}
+
+/* Shortest period first, threads without MIAT last */
+static int Compare_Threads(const void *a, const void *b)
+{
+    const Sched_Thread *x = a, *y = b;
+
+    if ((0 == x->period) != (0 == y->period)) {
+        return 0 == x->period ? 1 : -1;
+    }
+    if (x->period != y->period) {
+        return x->period < y->period ? -1 : 1;
+    }
+    return x->fv->thread_id - y->fv->thread_id;
+}
+
+/* Priority level of a thread of the partition, -1 if it is not in it */
+static int Level_Of(Sched_Thread *threads, size_t count, FV *fv)
+{
+    for (size_t k = 0; k < count; k++) {
+        if (threads[k].fv == fv) return threads[k].level;
+    }
+    return -1;
+}
+
+/* Longest protected PI run by a lower priority thread in a function
+ * whose ceiling is at least the priority of the thread */
+static uint64_t Blocking(Sched_Thread *threads, size_t count,
+                         Sched_Thread *t, FV_list *functions)
+{
+    uint64_t blocking = 0;
+
+    /* Note: FOREACH does not support "continue" */
+    FOREACH(fv, FV, functions, {
+        int ceiling = -1;
+
+        if (passive_runtime == fv->runtime_nature) {
+            FOREACH(caller, FV, fv->calling_threads, {
+                int level = Level_Of(threads, count, caller);
+                if (level >= 0 && (ceiling < 0 || level < ceiling)) {
+                    ceiling = level;
+                }
+            })
+        }
+        if (ceiling >= 0 && ceiling <= t->level) {
+            FOREACH(i, Interface, fv->interfaces, {
+                if (PI == i->direction && protected == i->rcm) {
+                    FOREACH(caller, FV, i->calling_threads, {
+                        if (Level_Of(threads, count, caller) > t->level
+                            && PI_WCET(i) > blocking) {
+                            blocking = PI_WCET(i);
+                        }
+                    })
+                }
+            })
+        }
+    })
+    return blocking;
+}
+
+/*
+ * Number of priorities available to the threads of a partition:
+ * SCHED_FIFO priorities 1..99 with PolyORB-HI-C on Linux, and 1..30 with
+ * Ada, the smallest range of System.Priority allowed by the RM (D.1(12))
+ */
+#define POHIC_PRIORITIES 99
+#define ADA_PRIORITIES   30
+
+/* Response time of a thread, or MISSED if it exceeds its deadline */
+#define MISSED UINT64_MAX
+
+static uint64_t Response_Time(Sched_Thread *threads, size_t count,
+                              Sched_Thread *t)
+{
+    uint64_t response = t->wcet + t->blocking;
+    uint64_t previous = MISSED;
+
+    /* Without MIAT the thread has no deadline */
+    if (0 == t->period) return MISSED;
+
+    while (response != previous) {
+        previous = response;
+        response = t->wcet + t->blocking;
+        for (size_t k = 0; k < count; k++) {
+            Sched_Thread *hp = &threads[k];
+            if (hp == t || hp->level > t->level || 0 == hp->period) {
+                continue;
+            }
+            response += ((previous + hp->period - 1) / hp->period)
+                        * hp->wcet;
+        }
+        if (response > t->period) return MISSED;
+    }
+    return response;
+}
+
+/* Assign the priorities of the threads of one partition and check them */
+static void Analyse_Partition(FILE *report, System *s, Process *process)
+{
+    size_t       count = 0, k = 0;
+    int          levels = 0;
+    int          available = 0;
+    double       utilization = 0.0;
+    bool         schedulable = true;
+    bool         pohic = get_context()->polyorb_hi_c;
+    const char   *name = NULL != process ? process->name : "(no partition)";
+    Sched_Thread *threads = NULL;
+
+    FOREACH(fv, FV, s->functions, {
+        if (thread_runtime == fv->runtime_nature && !fv->is_component_type
+            && process == fv->process) count++;
+    })
+    if (0 == count) return;
+
+    threads = calloc(count, sizeof(Sched_Thread));
+    assert(NULL != threads);
+
+    FOREACH(fv, FV, s->functions, {
+        if (thread_runtime == fv->runtime_nature && !fv->is_component_type
+            && process == fv->process) {
+            threads[k].fv = fv;
+            Thread_Timing(&threads[k]);
+            k++;
+        }
+    })
+
+    qsort(threads, count, sizeof(Sched_Thread), Compare_Threads);
+
+    for (k = 0; k < count; k++) {
+        if (k > 0 && threads[k].period != threads[k-1].period) {
+            levels++;
+        }
+        threads[k].level = levels;
+    }
+    levels++;
+
+    available = pohic ? POHIC_PRIORITIES : ADA_PRIORITIES;
+    if (levels > available) {
+        WARNING("[WARNING] Partition %s: %d distinct periods, "
+                "merged into %d priority levels\n",
+                name, levels, available);
+        for (k = 0; k < count; k++) {
+            threads[k].level = (int) ((long long) threads[k].level
+                                      * available / levels);
+        }
+        levels = available;
+    }
+
+    /*
+     * Priority low > priority high (POHIC/Linux)
+     * With Ada, a big number indicates a higher priority
+     */
+    for (k = 0; k < count; k++) {
+        threads[k].fv->priority = pohic ? 1 + threads[k].level
+                                        : levels - threads[k].level;
+    }
+
+    for (k = 0; k < count; k++) {
+        Sched_Thread *t = &threads[k];
+
+        t->blocking = Blocking(threads, count, t, s->functions);
+        t->response = Response_Time(threads, count, t);
+        t->schedulable = MISSED != t->response;
+        if (0 != t->period) {
+            utilization += (double) t->wcet / (double) t->period;
+        }
+        schedulable = schedulable && t->schedulable;
+    }
+
+    fprintf(report,
+            "Partition %s: %zu threads, %d priorities, utilization %.1f%%\n"
+            "%-40s %10s %10s %10s %10s %8s\n",
+            name, count, levels, 100.0 * utilization,
+            "thread", "period", "wcet", "blocking", "response", "priority");
+
+    for (k = 0; k < count; k++) {
+        Sched_Thread *t = &threads[k];
+        char         response[24];
+
+        if (0 == t->period) {
+            strcpy(response, "no MIAT");
+        }
+        else if (MISSED == t->response) {
+            strcpy(response, "MISSED");
+        }
+        else {
+            snprintf(response, sizeof response, "%llu",
+                     (unsigned long long) t->response);
+        }
+        fprintf(report, "%-40s %10llu %10llu %10llu %10s %8d\n",
+                t->fv->name,
+                (unsigned long long) t->period,
+                (unsigned long long) t->wcet,
+                (unsigned long long) t->blocking,
+                response,
+                t->fv->priority);
+
+        if (!t->schedulable) {
+            ERROR("[%s] Partition %s: thread %s %s\n",
+                  get_context()->fail_unschedulable ? "ERROR" : "WARNING",
+                  name,
+                  t->fv->name,
+                  0 == t->period ? "has no minimum inter-arrival time"
+                                 : "misses its deadline");
+        }
+    }
+    fprintf(report, "Partition %s is %sschedulable\n\n",
+            name, schedulable ? "" : "NOT ");
+
+    if (!schedulable && get_context()->fail_unschedulable) {
+        add_error();
+    }
+    free(threads);
+}
+
+/* External interface: set the priorities of the threads of all partitions
+ * and write the schedulability report (called after the preprocessing) */
+void Schedulability_Analysis(System *s)
+{
+    FILE *report = NULL;
+    bool unbound = false;
+
+    create_file(OUTPUT_PATH, "schedulability.txt", &report);
+    assert(NULL != report);
+
+    fprintf(report,
+            "Response-time analysis (rate-monotonic priorities, times in us)"
+            "\n\n");
+
+    FOREACH(process, Process, s->processes, {
+        Analyse_Partition(report, s, process);
+    })
+
+    /* Threads that are not bound to a partition */
+    FOREACH(fv, FV, s->functions, {
+        if (thread_runtime == fv->runtime_nature && NULL == fv->process) {
+            unbound = true;
+        }
+    })
+    if (unbound) {
+        Analyse_Partition(report, s, NULL);
+    }
+
+    close_file(&report);
+}
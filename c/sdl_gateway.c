@@ -14,6 +14,7 @@ Update August 2012 : support for OpenGEODE 1.0
 #include "my_types.h"
 #include "practical_functions.h"
 #include "backends.h"
+#include "tool_jobs.h"
 
 static FILE *f;
 static char *pi_string = NULL;  // List of PI (SDL INPUT SIGNALs) used to connect ROUTEs and CHANNELs
@@ -39,15 +40,12 @@ void Create_New_SDL_Structure(FV * fv)
             dataview_uniq = make_string ("dataview-uniq.asn");
     }
 
-    char *command = make_string("mono $(which asn1.exe) -customStg $(taste-config --prefix)/share/asn1scc/python.stg:%s/DataView.py -customStgAstVerion 4 %s/%s", path, dataview_path, dataview_uniq);
-    if (system(command)) {
-        ERROR ("[ERROR] Command \"%s\" failed in generation of SDL skeleton\n", command);
-    }
+    /* Same commands for all SDL functions: run once, output copied */
+    char *command = make_string("mono $(which asn1.exe) -customStg $(taste-config --prefix)/share/asn1scc/python.stg:\"$%s\"/DataView.py -customStgAstVerion 4 %s/%s", TOOL_JOB_OUTPUT, dataview_path, dataview_uniq);
+    Schedule_Tool_Job("asn1.exe", command, path, NULL, false);
     free(command);
-    command = make_string("cp \"%s/%s\" %s/", dataview_path, dataview_uniq, path);
-    if (system(command)) {
-        ERROR ("[ERROR] Command \"%s\" failed in generation of SDL skeleton\n", command);
-    }
+    command = make_string("cp \"%s/%s\" \"$%s\"/", dataview_path, dataview_uniq, TOOL_JOB_OUTPUT);
+    Schedule_Tool_Job("cp", command, path, NULL, false);
     free(command);
 
     /* Initialize variables used to build the list of SDL signals */ 
@@ -11,10 +11,71 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <assert.h>
 #include <sys/stat.h>
 
 #include "my_types.h"
 #include "practical_functions.h"
+#include "c_ast_construction.h"
+#include "symbol_table.h"
+
+/*
+ * The checks are done in one pass over the functions. The connections are
+ * resolved with the index of the functions by name (FindFV), and the
+ * diagnostics are collected in a list, with their location in the model.
+ * They are printed at the end of the pass, in the order of the model.
+ */
+typedef struct t_diagnostic {
+    FV          *fv;
+    Interface   *interface;     /* NULL if the error is on the function */
+    char        *message;       /* may continue on several lines */
+} Diagnostic;
+
+DECLARE_LIST(Diagnostic)
+
+static Diagnostic_list *diagnostics = NULL;
+
+/* Number of VHDL functions bound to each partition, by partition name */
+static Symbol_Table *vhdl_per_partition = NULL;
+
+/* Record an error on a function, or on one of its interfaces */
+static void Report(FV *fv, Interface *i, const char *fmt, ...)
+{
+    Diagnostic *d = AST_Alloc(sizeof(Diagnostic));
+    va_list    ap, aq;
+    int        len = 0;
+
+    va_start(ap, fmt);
+    va_copy(aq, ap);
+    len = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    d->fv        = fv;
+    d->interface = i;
+    d->message   = malloc((size_t) len + 1);
+    assert(NULL != d->message);
+    vsnprintf(d->message, (size_t) len + 1, fmt, aq);
+    va_end(aq);
+
+    APPEND_TO_LIST(Diagnostic, diagnostics, d);
+}
+
+/* Location of a diagnostic: file:line:column of the interface or of the
+ * function in the interface view (unknown if the model comes from the
+ * cache of an older version) */
+static const char *Location(Diagnostic *d)
+{
+    if (NULL != d->interface && NULL != d->interface->location) {
+        return d->interface->location;
+    }
+    if (NULL != d->fv && NULL != d->fv->location) {
+        return d->fv->location;
+    }
+    return NULL != get_context()->ifview ? get_context()->ifview
+                                         : "interfaceview";
+}
 
 /* Various semantic checks on an interface */
 void Interface_Semantic_Check(Interface * i)
@@ -24,10 +85,9 @@ void Interface_Semantic_Check(Interface * i)
     /* Check that Cyclic PIs are not connected. */
     if (PI == i->direction && cyclic == i->rcm && NULL != i->distant_fv) {
 
-        ERROR
-            ("[ERROR] In Function \"%s\", interface \"%s\" is cyclic and should not be connected. \n",
-             i->parent_fv->name, i->name);
-        add_error();
+        Report(i->parent_fv, i,
+               "In Function \"%s\", interface \"%s\" is cyclic and should not be connected. \n",
+               i->parent_fv->name, i->name);
 
     }
 
@@ -35,10 +95,9 @@ void Interface_Semantic_Check(Interface * i)
     if (PI == i->direction && cyclic == i->rcm
         && (NULL != i->in || NULL != i->out)) {
 
-        ERROR
-            ("[ERROR] In Function \"%s\", interface \"%s\" is cyclic and should not have parameters. \n",
-             i->parent_fv->name, i->name);
-        add_error();
+        Report(i->parent_fv, i,
+               "In Function \"%s\", interface \"%s\" is cyclic and should not have parameters. \n",
+               i->parent_fv->name, i->name);
 
     }
 
@@ -52,18 +111,16 @@ void Interface_Semantic_Check(Interface * i)
                 });
 
         if (count_param > 1) {
-            ERROR
-                ("[ERROR] In Function \"%s\", sporadic interface \"%s\" cannot have more than 1 IN param.\n",
-                 i->parent_fv->name, i->name);
-            add_error();
+            Report(i->parent_fv, i,
+                   "In Function \"%s\", sporadic interface \"%s\" cannot have more than 1 IN param.\n",
+                   i->parent_fv->name, i->name);
         }
 
         /* Check that SPO interfaces don't have any OUT parameters */
         if (NULL != i->out) {
-            ERROR
-                ("[ERROR]  In Function \"%s\", sporadic interface \"%s\" cannot have OUT parameters.\n",
-                 i->parent_fv->name, i->name);
-            add_error();
+            Report(i->parent_fv, i,
+                   " In Function \"%s\", sporadic interface \"%s\" cannot have OUT parameters.\n",
+                   i->parent_fv->name, i->name);
         }
 
     }
@@ -145,15 +202,22 @@ bool MultiInstance_SDL_Interface_Check(Interface * i, Interface * j)
     return result;
 }
 
-/* External interface (the one and unique) */
+/* Checks of one function and of its interfaces */
 void Function_Semantic_Check(FV * fv)
 {
     if (fv->system_ast->context->glue && NULL == fv->process
                                       && false == fv->is_component_type) {
-        ERROR
-            ("[ERROR] Function \"%s\" is not bound to any partition.\n",
-             fv->name);
-        add_error();
+        Report(fv, NULL,
+               "Function \"%s\" is not bound to any partition.\n",
+               fv->name);
+    }
+
+    /* Count the VHDL functions of each partition (only one is allowed) */
+    if (vhdl == fv->language && NULL != fv->process) {
+        uintptr_t count = (uintptr_t) Symbol_Table_Find(vhdl_per_partition,
+                                                        fv->process->name);
+        Symbol_Table_Set(vhdl_per_partition, fv->process->name,
+                         (void *) (count + 1));
     }
 
     if (fv->system_ast->context->onlycv) {
@@ -171,10 +235,9 @@ void Function_Semantic_Check(FV * fv)
                 if (PI == i->direction) count_pi++;}
         );
         if (0 == count_pi) {
-            ERROR
-                ("[ERROR] Function \"%s\" shall contain at least one provided interface.\n",
-                 fv->name);
-            add_error();
+            Report(fv, NULL,
+                   "Function \"%s\" shall contain at least one provided interface.\n",
+                   fv->name);
         }
     }
 
@@ -193,21 +256,17 @@ void Function_Semantic_Check(FV * fv)
         );
 
         if (1 != count_pi) {
-            ERROR
-                ("[ERROR] %s function \"%s\" must contain ONE provided interface\n",
-                 scade == fv->language ? "SCADE" : "Simulink", fv->name);
-            ERROR
-                ("** (but possibly several input and output parameters).\n");
-            add_error();
+            Report(fv, NULL,
+                   "%s function \"%s\" must contain ONE provided interface\n"
+                   "** (but possibly several input and output parameters).\n",
+                   scade == fv->language ? "SCADE" : "Simulink", fv->name);
         }
 
         if (0 != count_ri) {
-            ERROR
-                ("[ERROR] %s function \"%s\" must NOT contain any required interface\n",
-                 scade == fv->language ? "SCADE" : "Simulink", fv->name);
-            ERROR
-                ("** (use OUT parameters in the interface specification).\n");
-            add_error();
+            Report(fv, NULL,
+                   "%s function \"%s\" must NOT contain any required interface\n"
+                   "** (use OUT parameters in the interface specification).\n",
+                   scade == fv->language ? "SCADE" : "Simulink", fv->name);
         }
     }
 
@@ -222,25 +281,20 @@ void Function_Semantic_Check(FV * fv)
                 count_ri++;}
             else {
                 if (asynch == i->synchronism) {
-                    ERROR
-                    ("[ERROR] Required interface %s of function %s should be PROTECTED or UNPROTECTED\n",
-                     i->name, fv->name);
-                    ERROR
-                    ("   because it is connected to a function that is using QGen as a source language\n");
-                    ERROR
-                    ("   (remote calls cannot be made to QGen functions).\n");
-                    add_error();
+                    Report(fv, i,
+                           "Required interface %s of function %s should be PROTECTED or UNPROTECTED\n"
+                           "   because it is connected to a function that is using QGen as a source language\n"
+                           "   (remote calls cannot be made to QGen functions).\n",
+                           i->name, fv->name);
                 }
             }
         });
 
         if (0 != count_ri) {
-            ERROR
-                ("[ERROR] %s function \"%s\" must NOT contain any required interface\n",
-                 qgenc == fv->language ? "QGenC" : "QGenAda", fv->name);
-            ERROR
-                ("** (use OUT parameters in the interface specification).\n");
-            add_error();
+            Report(fv, NULL,
+                   "%s function \"%s\" must NOT contain any required interface\n"
+                   "** (use OUT parameters in the interface specification).\n",
+                   qgenc == fv->language ? "QGenC" : "QGenAda", fv->name);
         }
     }
 
@@ -255,10 +309,9 @@ void Function_Semantic_Check(FV * fv)
         }
 
         if (strcmp(i->name, fv->name)) {
-            ERROR
-            ("[ERROR] PI \"%s\" should have the same name as SCADE function \"%s\"\n",
-             i->name, fv->name);
-            add_error();
+            Report(fv, i,
+                   "PI \"%s\" should have the same name as SCADE function \"%s\"\n",
+                   i->name, fv->name);
         }
     }
 
@@ -271,19 +324,19 @@ void Function_Semantic_Check(FV * fv)
         FOREACH(i, Interface, fv->interfaces, {
             if (RI == i->direction) {
                 if (NULL == i->in) {
-                    ERROR("[ERROR] in GUI function \"%s\",\n"
+                    Report(fv, i,
+                           "in GUI function \"%s\",\n"
                            "**    interface \"%s\" must contain a parameter.\n",
                            fv->name,
-                           i->name); 
-                    add_error();}
+                           i->name);}
                 }
                 /* Undefined RCM corresponds to "any type" (=inherited from PI) */ 
                 if (undefined != i->rcm && sporadic != i->rcm && variator != i->rcm) {
-                    ERROR("[ERROR] All interfaces of GUI \"%s\"\n"
+                    Report(fv, i,
+                           "All interfaces of GUI \"%s\"\n"
                            "**       must be SPORADIC (e.g. %s is not).\n",
                            fv->name,
                            i->name);
-                    add_error();
                 }
             }
         );
@@ -294,28 +347,20 @@ void Function_Semantic_Check(FV * fv)
      * as all their calling threads (to handle possible static data).
      */
     FOREACH(i, Interface, fv->interfaces, {
-            if (RI == i->direction && synch == i->synchronism
-                && NULL != i->distant_fv) {
-            FOREACH(function, FV, get_system_ast()->functions, {
-                    if (!strcmp(function->name, i->distant_fv)
-                        && function->process != fv->process) {
-                    ERROR
-                    ("[ERROR] Required interface %s of function %s should be SPORADIC\n",
-                     i->name, fv->name);
-                    ERROR
-                    ("   because it is connected to a function that is bound to a different\n");
-                    ERROR
-                    ("   partition in your deployment view (remote calls cannot be synchronous)\n");
-                    add_error();}
-                    }
-            );}
+        if (RI == i->direction && synch == i->synchronism
+            && NULL != i->distant_fv) {
+            FV *callee = FindFV(i->distant_fv);
+
+            if (NULL != callee && callee->process != fv->process) {
+                Report(fv, i,
+                       "Required interface %s of function %s should be SPORADIC\n"
+                       "   because it is connected to a function that is bound to a different\n"
+                       "   partition in your deployment view (remote calls cannot be synchronous)\n",
+                       i->name, fv->name);
             }
-    );
-
-    FOREACH(i, Interface, fv->interfaces, {
-            Interface_Semantic_Check(i);
-            }
-    );
+        }
+        Interface_Semantic_Check(i);
+    });
 
     /*
      * SDL specific checks: is_component_type can only be true for SDL functions.
@@ -323,47 +368,43 @@ void Function_Semantic_Check(FV * fv)
      */
     if (fv->is_component_type) {
         if (sdl != fv->language) {
-            ERROR
-            ("[ERROR] Is_Component_Type is True for \"%s\". This is allowed only for SDL functions.\n",
-             fv->name);
-            add_error();
+            Report(fv, NULL,
+                   "Is_Component_Type is True for \"%s\". This is allowed only for SDL functions.\n",
+                   fv->name);
         }
     }
 
     if (NULL != fv->instance_of) {
-        FV *definition = FindFV (string_to_lower(fv->instance_of));
+        char *instance_of = string_to_lower(fv->instance_of);
+        FV   *definition  = FindFV (instance_of);
+
+        free(instance_of);
         if (definition == NULL) {
-            ERROR
-            ("[ERROR] Component type \"%s\" (for instance \"%s\") not found.\n",
-             fv->instance_of, fv->name);
-            add_error();
+            Report(fv, NULL,
+                   "Component type \"%s\" (for instance \"%s\") not found.\n",
+                   fv->instance_of, fv->name);
             return;
         }
         else {
             if (false == definition->is_component_type) {
-                ERROR
-                ("[ERROR] Is_Component_Type is False for \"%s\". It should be True,\n",
-                 definition->name);
-                 ERROR
-                ("   because function \"%s\" claims that it is an instance of \"%s\".\n",
-                 fv->name, definition->name);
-                add_error();
+                Report(fv, NULL,
+                       "Is_Component_Type is False for \"%s\". It should be True,\n"
+                       "   because function \"%s\" claims that it is an instance of \"%s\".\n",
+                       definition->name, fv->name, definition->name);
             }
             int fv_intf_cnt = 0;
             int definition_intf_cnt = 0;
             FOREACH(i, Interface, fv->interfaces, {
                 Interface *def_i = FindInterface (definition, i->name);
                     if (def_i == NULL) {
-                        ERROR
-                        ("[ERROR] Interface \"%s\" of instance \"%s\" not found from definition \"%s\".\n",
-                        i->name, fv->name, definition->name);
-                        add_error();
+                        Report(fv, i,
+                               "Interface \"%s\" of instance \"%s\" not found from definition \"%s\".\n",
+                               i->name, fv->name, definition->name);
                     } else {
                         if (!MultiInstance_SDL_Interface_Check (i, def_i)) {
-                            ERROR
-                            ("[ERROR] Interface \"%s\" of instance \"%s\" not matching with definition \"%s\".\n",
-                            i->name, fv->name, definition->name);
-                            add_error();
+                            Report(fv, i,
+                                   "Interface \"%s\" of instance \"%s\" not matching with definition \"%s\".\n",
+                                   i->name, fv->name, definition->name);
                         }
                     }
 
@@ -374,18 +415,45 @@ void Function_Semantic_Check(FV * fv)
                 definition_intf_cnt++;
             });
             if (fv_intf_cnt != definition_intf_cnt) {
-                ERROR
-                ("[ERROR] Interface count mismatch between definition \"%s\" and instance \"%s\".\n",
-                 definition->name, fv->name);
-                add_error();
+                Report(fv, NULL,
+                       "Interface count mismatch between definition \"%s\" and instance \"%s\".\n",
+                       definition->name, fv->name);
             }
         }
     }
 }
 
-/* External interface */
+/* Join the lines of a message on one line, for --check-only: the newlines,
+ * the indentation and the "**" of the continuation lines become one space,
+ * and the final newline is removed */
+static void Join_Lines(char *message)
+{
+    char *src = message, *dst = message;
+
+    while ('\0' != *src) {
+        if ('\n' == *src) {
+            while ('\n' == *src || ' ' == *src || '\t' == *src
+                   || '*' == *src) {
+                src++;
+            }
+            if ('\0' != *src) *dst++ = ' ';
+        }
+        else {
+            *dst++ = *src++;
+        }
+    }
+    while (dst > message && (' ' == dst[-1] || '\t' == dst[-1])) dst--;
+    *dst = '\0';
+}
+
+/* External interface: check the model and print the errors */
 void Semantic_Checks()
 {
+    bool check_only = get_context()->check_only;
+
+    diagnostics        = NULL;
+    vhdl_per_partition = Create_Symbol_Table();
+
     FOREACH(fv, FV, get_system_ast()->functions, {
             Function_Semantic_Check(fv);
     });
@@ -394,14 +462,31 @@ void Semantic_Checks()
      * VHDL-specific check: there can be only ONE VHDL subsystem per node
      */
     FOREACH(process, Process, get_system_ast()->processes, {
-            int count = 0;
-            FOREACH(binding, Aplc_binding, process->bindings, {
-                    if (vhdl == binding->fv->language) count++;}
-            ); if (count > 1) {
-            ERROR
-            ("[ERROR] in a distributed system, a partition can contain only ONE\n");
-            ERROR("   VHDL component. Partition \"%s\" has %d.\n",
-                   process->name, count); add_error();}
-
+        uintptr_t count = (uintptr_t) Symbol_Table_Find(vhdl_per_partition,
+                                                        process->name);
+        if (count > 1) {
+            Report(NULL, NULL,
+                   "in a distributed system, a partition can contain only ONE\n"
+                   "   VHDL component. Partition \"%s\" has %d.\n",
+                   process->name, (int) count);
+        }
+    });
+    Clear_Symbol_Table(vhdl_per_partition);
+    vhdl_per_partition = NULL;
+
+    /* Option --check-only: one "file:line:column: error:" line per error,
+     * that editors can parse */
+    FOREACH(d, Diagnostic, diagnostics, {
+        if (check_only) {
+            Join_Lines(d->message);
+            ERROR("%s: error: %s\n", Location(d), d->message);
+        }
+        else {
+            ERROR("[ERROR] %s", d->message);
+        }
+        add_error();
+        free(d->message);
+        d->message = NULL;
     });
+    diagnostics = NULL;
 }
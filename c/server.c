@@ -0,0 +1,276 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Server mode (buildsupport --server <socket>)
+ *
+ * The IDE and the build scripts call buildsupport many times, and each run
+ * starts by loading the Ada runtime and initializing Ocarina. In server
+ * mode this is done once: buildsupport then waits for the requests of
+ * buildsupport-client (misc/buildsupport-client.c) on a Unix socket, and
+ * forks a child for each of them. The child continues as a normal run,
+ * with the command line, environment, current directory and standard
+ * input/outputs of the client: the result is the same as a direct call of
+ * buildsupport (PATH and OCARINA_PATH, and the tools it runs, are the ones
+ * of the client). The socket can only be used by the user of the server.
+ * With --cache, a request with unchanged input files does not call Ocarina
+ * at all: the child loads the C AST from the cache and runs the backends.
+ *
+ * Request: the standard input, output and error of the client (SCM_RIGHTS)
+ * with a 4-byte length, followed by the number of arguments (4 bytes) and
+ * null-terminated strings: the current directory, the arguments and the
+ * environment variables (NAME=value).
+ * Reply: the exit status of the run as a 4-byte integer (128 + signal
+ * number if the child was killed).
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "server.h"
+
+/* Command line of the Ada main (GNAT runtime, read by Ada.Command_Line) */
+extern int  gnat_argc;
+extern char **gnat_argv;
+
+#define MAX_REQUEST (1024 * 1024)
+
+/* Read exactly len bytes */
+static bool Read_All(int fd, void *buffer, size_t len)
+{
+    char *p = buffer;
+
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && EINTR == errno) continue;
+        if (n <= 0) return false;
+        p   += n;
+        len -= (size_t) n;
+    }
+    return true;
+}
+
+/* Receive the length of the request and the 3 file descriptors */
+static bool Receive_Header(int conn, uint32_t *len, int fds[3])
+{
+    char           control[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec   iov = { len, sizeof *len };
+    struct msghdr  msg;
+    struct cmsghdr *cmsg = NULL;
+    ssize_t        n = 0;
+
+    memset(&msg, 0, sizeof msg);
+    memset(control, 0, sizeof control);
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof control;
+
+    do {
+        n = recvmsg(conn, &msg, MSG_WAITALL);
+    } while (n < 0 && EINTR == errno);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (sizeof *len != (size_t) n || NULL == cmsg
+        || SOL_SOCKET != cmsg->cmsg_level || SCM_RIGHTS != cmsg->cmsg_type
+        || CMSG_LEN(3 * sizeof(int)) != cmsg->cmsg_len) {
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), 3 * sizeof(int));
+    return 0 < *len && *len <= MAX_REQUEST;
+}
+
+/* Replace the environment of the server with the one of the client (the
+ * strings after the arguments, kept in the request until the exit) */
+static bool Set_Environment(char *p, char *end)
+{
+    if (0 != clearenv()) return false;
+    while (p < end) {
+        if (NULL != strchr(p, '=') && 0 != putenv(p)) return false;
+        p += strlen(p) + 1;
+    }
+    return true;
+}
+
+/* Split the request in directory, arguments and environment, set the
+ * environment and set the command line of the Ada main */
+static bool Set_Command_Line(char *request, uint32_t len)
+{
+    uint32_t count = 0;
+    int      argc = 0;
+    char     **argv = NULL;
+    char     *p = request + sizeof count, *end = request + len;
+
+    if (len <= sizeof count || '\0' != end[-1]) return false;
+    memcpy(&count, request, sizeof count);
+    if (count > len) return false;
+
+    argv = calloc((size_t) count + 2, sizeof(char *));
+    if (NULL == argv) return false;
+
+    argv[argc++] = gnat_argv[0];
+    p += strlen(p) + 1;
+    while (p < end && (uint32_t) argc <= count) {
+        argv[argc++] = p;
+        p += strlen(p) + 1;
+    }
+    argv[argc] = NULL;
+
+    if ((uint32_t) argc != count + 1 || !Set_Environment(p, end)
+        || 0 != chdir(request + sizeof count)) {
+        free(argv);
+        return false;
+    }
+
+    gnat_argc = argc;
+    gnat_argv = argv;
+    return true;
+}
+
+/* Only the user of the server can send requests: the files are written
+ * with the uid of the server */
+static bool Allowed_Peer(int conn)
+{
+    struct ucred cred;
+    socklen_t    size = sizeof cred;
+
+    return 0 == getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &size)
+           && cred.uid == getuid();
+}
+
+/*
+ * Process one request (in a child of the server). Return in the child
+ * that runs it; this process waits for the end of the run, sends the exit
+ * status to the client and exits.
+ */
+static void Handle_Request(int conn)
+{
+    int      fds[3] = { -1, -1, -1 }, status = 0;
+    int32_t  reply = 2;
+    uint32_t len = 0;
+    char     *request = NULL;
+    pid_t    run;
+
+    if (!Receive_Header(conn, &len, fds)) {
+        ERROR("[ERROR] Invalid request from buildsupport-client\n");
+        exit(1);
+    }
+    request = malloc(len);
+    if (NULL == request || !Read_All(conn, request, len)) {
+        exit(1);
+    }
+
+    fflush(NULL);
+    run = fork();
+    if (0 == run) {
+        close(conn);
+        for (int k = 0; k < 3; k++) {
+            dup2(fds[k], k);
+            close(fds[k]);
+        }
+        if (!Set_Command_Line(request, len)) {
+            ERROR("[ERROR] Invalid directory or command line in the request\n");
+            exit(2);
+        }
+        return;
+    }
+
+    for (int k = 0; k < 3; k++) {
+        close(fds[k]);
+    }
+    free(request);
+
+    if (run > 0) {
+        while (waitpid(run, &status, 0) < 0 && EINTR == errno) {}
+        reply = WIFEXITED(status)   ? WEXITSTATUS(status)
+              : WIFSIGNALED(status) ? 128 + WTERMSIG(status) : 2;
+    }
+    if (sizeof reply != (size_t) write(conn, &reply, sizeof reply)) {
+        ERROR("[WARNING] buildsupport-client left before the end of the run\n");
+    }
+    exit(0);
+}
+
+/* External interface, called by the Ada main (option --server) */
+int Server(char *socket_path, size_t len)
+{
+    struct sockaddr_un addr;
+    int                listener = -1;
+    mode_t             mask;
+
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (len >= sizeof addr.sun_path) {
+        ERROR("[ERROR] Socket path is too long\n");
+        return -1;
+    }
+    memcpy(addr.sun_path, socket_path, len);
+
+    /* The socket is created with mode 0600 */
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(addr.sun_path);
+    mask = umask(0077);
+    if (listener < 0
+        || 0 != bind(listener, (struct sockaddr *) &addr, sizeof addr)) {
+        umask(mask);
+        perror(addr.sun_path);
+        return -1;
+    }
+    umask(mask);
+    if (0 != chmod(addr.sun_path, S_IRUSR | S_IWUSR)
+        || 0 != listen(listener, 16)) {
+        perror(addr.sun_path);
+        return -1;
+    }
+
+    /* The processes that handle the requests are reaped by the system */
+    signal(SIGCHLD, SIG_IGN);
+
+    printf("[INFO] Waiting for requests on %s\n", addr.sun_path);
+    fflush(stdout);
+
+    while (true) {
+        int   conn = accept(listener, NULL, NULL);
+        pid_t handler;
+
+        if (conn < 0) {
+            if (EINTR == errno) continue;
+            perror("accept");
+            return -1;
+        }
+        if (!Allowed_Peer(conn)) {
+            ERROR("[WARNING] Request from another user rejected\n");
+            close(conn);
+            continue;
+        }
+
+        fflush(NULL);
+        handler = fork();
+        if (0 == handler) {
+            /* This process waits for its own child */
+            signal(SIGCHLD, SIG_DFL);
+            close(listener);
+            Handle_Request(conn);
+            return 0;
+        }
+        if (handler < 0) {
+            perror("fork");
+        }
+        close(conn);
+    }
+}
@@ -92,7 +92,7 @@ bool Tunable_Parameters (FV *fv)
     });
 
     if (has_tunable) {
-        fclose (mTunable);
+        close_file (&mTunable);
     }
         
     return has_tunable;
@@ -0,0 +1,531 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Stack size of the threads of the concurrency view.
+ *
+ * The stack of a thread holds the frames of the runtime, of the functions
+ * that the thread executes (its own function and the passive functions it
+ * calls) and the parameters of the interfaces along these calls, in native
+ * and in encoded form (asn1Scc<T> variables and encoding buffers).
+ * The budget of a thread is:
+ *     runtime overhead (PolyORB-HI/C or Ada)
+ *   + overhead of the language of each function the thread executes
+ *   + 2 x Source_Data_Size of the parameters of each interface it executes
+ *   + margin (percent)
+ * Source_Data_Size is read from the data view (AADL). The budget is an upper
+ * bound: it assumes that all the interfaces are on the call stack at once.
+ *
+ * The default values can be changed in a file (option --stack-config):
+ *     runtime   <bytes>              runtime overhead of a thread
+ *     language  <language> <bytes>   overhead of a function
+ *     parameter <bytes>              size of a type absent from the data view
+ *     margin    <percent>
+ *     thread    <function> <kbytes>  fixed stack of a thread
+ * The option -s/--stack sets the stack of all the threads that have no
+ * "thread" line.
+ * The budget leaves out the call depth of the user code, libc and the ASN.1
+ * encoders: without --stack-config, a thread gets at least the historical
+ * stack (50 KByte with PolyORB-HI/C, 5 KByte with Ada).
+ *
+ * The budgets are written in stack_usage.txt in the output directory.
+ * If the output directory contains the .su files of gcc -fstack-usage
+ * (from a previous build), the frames of the functions of each thread are
+ * added, reported and compared with the stack: they only raise warnings,
+ * as they do not count the frames of the callees outside the glue.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+#include "symbol_table.h"
+
+#define KBYTE 1024
+
+static const struct {
+    Language    language;
+    const char  *name;
+    size_t      overhead;
+} language_overheads[] = {
+    {sdl,             "sdl",             4 * KBYTE},
+    {opengeode,       "opengeode",       4 * KBYTE},
+    {simulink,        "simulink",        2 * KBYTE},
+    {qgenc,           "qgenc",           2 * KBYTE},
+    {qgenada,         "qgenada",         2 * KBYTE},
+    {c,               "c",               2 * KBYTE},
+    {cpp,             "cpp",             2 * KBYTE},
+    {ada,             "ada",             2 * KBYTE},
+    {rhapsody,        "rhapsody",        2 * KBYTE},
+    {gui,             "gui",             2 * KBYTE},
+    {scade,           "scade",           2 * KBYTE},
+    {rtds,            "rtds",            4 * KBYTE},
+    {vhdl,            "vhdl",            2 * KBYTE},
+    {system_c,        "system_c",        2 * KBYTE},
+    {blackbox_device, "blackbox_device", 2 * KBYTE},
+    {vdm,             "vdm",             2 * KBYTE},
+    {micropython,     "micropython",     16 * KBYTE},
+    {ros_bridge,      "ros_bridge",      2 * KBYTE},
+    {other,           "other",           2 * KBYTE}
+};
+
+#define LANGUAGES (sizeof language_overheads / sizeof language_overheads[0])
+
+typedef struct {
+    size_t          runtime;
+    size_t          overhead[LANGUAGES];
+    size_t          parameter;
+    size_t          margin;         /* percent */
+    size_t          floor;          /* minimum stack without calibration */
+    Symbol_Table    *threads;       /* fixed stacks in KByte, + 1 */
+    Symbol_Table    *types;         /* Source_Data_Size in bytes, + 1 */
+} Stack_Config;
+
+/* Frame of a function in the .su files of gcc -fstack-usage */
+typedef struct {
+    char    *name;
+    size_t  bytes;
+    bool    dynamic;
+} Stack_Frame;
+
+static Stack_Frame  *frames = NULL;
+static size_t       frame_count = 0;
+static Symbol_Table *frame_index = NULL;  /* rank of the largest frame */
+
+/* Symbol tables index pointers: sizes are stored as value + 1 */
+static void Set_Size(Symbol_Table *table, const char *key, size_t value)
+{
+    Symbol_Table_Set(table, key, (void *) (uintptr_t) (value + 1));
+}
+
+static bool Get_Size(Symbol_Table *table, const char *key, size_t *value)
+{
+    uintptr_t stored = (uintptr_t) Symbol_Table_Find(table, key);
+
+    if (0 == stored) return false;
+    *value = (size_t) (stored - 1);
+    return true;
+}
+
+/* AADL identifiers are case-insensitive and ASN.1 ones use dashes */
+static char *Type_Key(const char *name)
+{
+    char *key = make_string("%s", name);
+
+    for (char *p = key; '\0' != *p; p++) {
+        *p = '-' == *p ? '_' : (char) tolower((unsigned char) *p);
+    }
+    return key;
+}
+
+/* Read the Source_Data_Size of the types of the data view */
+static void Read_Data_View(Stack_Config *config)
+{
+    FILE *dataview = NULL;
+    char line[1024], name[256] = "", unit[16];
+    unsigned long long size = 0;
+
+    if (NULL == get_context()->dataview) return;
+
+    dataview = fopen(get_context()->dataview, "r");
+    if (NULL == dataview) return;
+
+    while (NULL != fgets(line, sizeof line, dataview)) {
+        char *text = line;
+
+        while (isspace((unsigned char) *text)) text++;
+
+        if (!strncasecmp(text, "DATA ", 5)
+            && strncasecmp(text, "DATA IMPLEMENTATION", 19)) {
+            if (1 != sscanf(text + 5, "%255s", name)) {
+                name[0] = '\0';
+            }
+        }
+        else if ('\0' != name[0]
+                 && !strncasecmp(text, "Source_Data_Size", 16)
+                 && 2 == sscanf(text, "Source_Data_Size => %llu %15[A-Za-z]",
+                                &size, unit)) {
+            char *key = Type_Key(name);
+            if (!strcasecmp(unit, "KByte")) size *= KBYTE;
+            else if (!strcasecmp(unit, "bits")) size = (size + 7) / 8;
+            Set_Size(config->types, key, (size_t) size);
+            free(key);
+        }
+    }
+    fclose(dataview);
+}
+
+/* Read the file of option --stack-config */
+static void Read_Stack_Config(Stack_Config *config, const char *filename)
+{
+    FILE               *file = fopen(filename, "r");
+    char               line[512], keyword[32], name[256];
+    unsigned long long value = 0;
+    int                line_number = 0;
+
+    if (NULL == file) {
+        ERROR("[ERROR] Could not open the stack configuration %s\n",
+              filename);
+        add_error();
+        return;
+    }
+
+    while (NULL != fgets(line, sizeof line, file)) {
+        bool valid = false;
+        char *comment = strchr(line, '#');
+
+        line_number++;
+        if (NULL != comment) *comment = '\0';
+        if (1 != sscanf(line, "%31s", keyword)) continue;
+
+        if (!strcmp(keyword, "runtime")
+            && 1 == sscanf(line, "%*s %llu", &value)) {
+            config->runtime = (size_t) value;
+            valid = true;
+        }
+        else if (!strcmp(keyword, "parameter")
+                 && 1 == sscanf(line, "%*s %llu", &value)) {
+            config->parameter = (size_t) value;
+            valid = true;
+        }
+        else if (!strcmp(keyword, "margin")
+                 && 1 == sscanf(line, "%*s %llu", &value)) {
+            config->margin = (size_t) value;
+            valid = true;
+        }
+        else if (!strcmp(keyword, "language")
+                 && 2 == sscanf(line, "%*s %255s %llu", name, &value)) {
+            for (size_t k = 0; k < LANGUAGES; k++) {
+                if (!strcasecmp(name, language_overheads[k].name)) {
+                    config->overhead[k] = (size_t) value;
+                    valid = true;
+                }
+            }
+        }
+        else if (!strcmp(keyword, "thread")
+                 && 2 == sscanf(line, "%*s %255s %llu", name, &value)) {
+            Set_Size(config->threads, name, (size_t) value);
+            valid = true;
+        }
+
+        if (!valid) {
+            ERROR("[ERROR] %s:%d: invalid stack configuration line\n",
+                  filename, line_number);
+            add_error();
+        }
+    }
+    fclose(file);
+}
+
+/* Read one .su file: "file:line:column:function<TAB>bytes<TAB>kind" */
+static void Read_Stack_Usage_File(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    char line[1024];
+
+    if (NULL == file) return;
+
+    while (NULL != fgets(line, sizeof line, file)) {
+        char   *name = line, *tab = strchr(line, '\t');
+        size_t bytes = 0;
+        size_t rank  = 0;
+
+        if (NULL == tab) continue;
+        *tab = '\0';
+        for (int field = 0; field < 3 && NULL != strchr(name, ':'); field++) {
+            name = strchr(name, ':') + 1;
+        }
+        bytes = (size_t) strtoull(tab + 1, NULL, 10);
+
+        /* Static functions of several files may have the same name */
+        if (Get_Size(frame_index, name, &rank)) {
+            if (bytes > frames[rank].bytes) {
+                frames[rank].bytes = bytes;
+            }
+            frames[rank].dynamic = frames[rank].dynamic
+                                   || (NULL != strstr(tab + 1, "dynamic")
+                                       && NULL == strstr(tab + 1, "bounded"));
+            continue;
+        }
+        Set_Size(frame_index, name, frame_count);
+        frames = realloc(frames, (frame_count + 1) * sizeof(Stack_Frame));
+        assert(NULL != frames);
+        frames[frame_count].name    = make_string("%s", name);
+        frames[frame_count].bytes   = bytes;
+        frames[frame_count].dynamic = NULL != strstr(tab + 1, "dynamic")
+                                      && NULL == strstr(tab + 1, "bounded");
+        frame_count++;
+    }
+    fclose(file);
+}
+
+static void Read_Stack_Usage(const char *path)
+{
+    DIR           *dir = opendir(path);
+    struct dirent *entry = NULL;
+
+    if (NULL == dir) return;
+
+    while (NULL != (entry = readdir(dir))) {
+        char        *full = NULL;
+        size_t      len = strlen(entry->d_name);
+        struct stat st;
+
+        if ('.' == entry->d_name[0]) continue;
+        full = make_string("%s/%s", path, entry->d_name);
+        if (0 == stat(full, &st)) {
+            if (S_ISDIR(st.st_mode)) {
+                Read_Stack_Usage(full);
+            }
+            else if (len > 3 && !strcmp(entry->d_name + len - 3, ".su")) {
+                Read_Stack_Usage_File(full);
+            }
+        }
+        free(full);
+    }
+    closedir(dir);
+}
+
+/* Names of the functions generated for an interface (function, interface) */
+static const char *const interface_frames[] = {
+    "%s_%s", "%s_PI_%s", "%s_RI_%s", "vm_%s_%s", "vm_async_%s_%s",
+    "po_hi_c_%s_%s"
+};
+
+#define INTERFACE_FRAMES \
+    (sizeof interface_frames / sizeof interface_frames[0])
+
+/* Add the frame of a function of the .su files, if it is there */
+static void Add_Frame(const char *name, size_t *largest, bool *dynamic)
+{
+    size_t rank = 0;
+
+    if (Get_Size(frame_index, name, &rank)) {
+        if (frames[rank].bytes > *largest) *largest = frames[rank].bytes;
+        *dynamic = *dynamic || frames[rank].dynamic;
+    }
+}
+
+/* Largest frame of the functions generated for, or written in, a function:
+ * the names are matched exactly, as a prefix would also match the functions
+ * of another function whose name starts with the same word */
+static size_t Largest_Frame(FV *fv, bool *dynamic)
+{
+    size_t largest = 0;
+    char   *name   = NULL;
+
+    name = make_string("%s_startup", fv->name);
+    Add_Frame(name, &largest, dynamic);
+    free(name);
+    name = make_string("init_%s", fv->name);
+    Add_Frame(name, &largest, dynamic);
+    free(name);
+
+    FOREACH(i, Interface, fv->interfaces, {
+        for (size_t k = 0; k < INTERFACE_FRAMES; k++) {
+            name = make_string(interface_frames[k], fv->name, i->name);
+            Add_Frame(name, &largest, dynamic);
+            free(name);
+        }
+    })
+    return largest;
+}
+
+static bool Calls(FV_list *calling_threads, FV *thread)
+{
+    FOREACH(caller, FV, calling_threads, {
+        if (caller == thread) return true;
+    })
+    return false;
+}
+
+static size_t Parameters_Size(Stack_Config *config, Interface *i)
+{
+    size_t total = 0;
+    size_t size  = 0;
+
+    FOREACH(p, Parameter, i->in, {
+        char *key = Type_Key(p->type);
+        total += 2 * (Get_Size(config->types, key, &size) ? size
+                                                         : config->parameter);
+        free(key);
+    })
+    FOREACH(p, Parameter, i->out, {
+        char *key = Type_Key(p->type);
+        total += 2 * (Get_Size(config->types, key, &size) ? size
+                                                         : config->parameter);
+        free(key);
+    })
+    return total;
+}
+
+static size_t Language_Overhead(Stack_Config *config, Language language)
+{
+    for (size_t k = 0; k < LANGUAGES; k++) {
+        if (language == language_overheads[k].language) {
+            return config->overhead[k];
+        }
+    }
+    return 2 * KBYTE;
+}
+
+/* Compute the stack of a thread and add it to the report */
+static void Thread_Stack(FILE *report, Stack_Config *config, System *s,
+                         FV *thread)
+{
+    size_t functions  = 0;
+    size_t parameters = 0;
+    size_t budget     = 0;
+    size_t fixed      = 0;
+    size_t measured   = 0;
+    bool   dynamic    = false;
+    char   origin[16] = "computed";
+    char   usage[24]  = "-";
+
+    /* The function of the thread and its interfaces */
+    functions += Language_Overhead(config, thread->language);
+    measured  += Largest_Frame(thread, &dynamic);
+    FOREACH(i, Interface, thread->interfaces, {
+        parameters += Parameters_Size(config, i);
+    })
+
+    /* The passive functions it calls, the PIs it executes and their RIs */
+    FOREACH(fv, FV, s->functions, {
+        if (fv != thread && Calls(fv->calling_threads, thread)) {
+            functions += Language_Overhead(config, fv->language);
+            measured  += Largest_Frame(fv, &dynamic);
+            FOREACH(i, Interface, fv->interfaces, {
+                if (RI == i->direction || Calls(i->calling_threads, thread)) {
+                    parameters += Parameters_Size(config, i);
+                }
+            })
+        }
+    })
+
+    budget = config->runtime + functions + parameters;
+    budget += budget * config->margin / 100;
+
+    if (Get_Size(config->threads, thread->name, &fixed)) {
+        thread->stack_size = fixed * KBYTE;
+        strcpy(origin, "thread");
+    }
+    else if (NULL != get_context()->stacksize
+             && 0 < atoi(get_context()->stacksize)) {
+        thread->stack_size = (size_t) atoi(get_context()->stacksize) * KBYTE;
+        strcpy(origin, "--stack");
+    }
+    else {
+        size_t stack = budget;
+
+        /* The budget does not count the call depth of the user code, libc
+         * or the ASN.1 encoders: unless it is calibrated (--stack-config),
+         * it cannot go below the historical stack. The frames measured by
+         * gcc miss these callees too: they are only reported below */
+        if (NULL == get_context()->stack_config && stack < config->floor) {
+            stack = config->floor;
+            strcpy(origin, "default");
+        }
+        thread->stack_size = (stack + KBYTE - 1) / KBYTE * KBYTE;
+    }
+    if (thread->stack_size < budget) {
+        WARNING("[WARNING] Stack of thread %s (%zu KByte, set by %s) is "
+                "below its budget (%zu bytes)\n",
+                thread->name, thread->stack_size / KBYTE, origin, budget);
+    }
+
+    if (frame_count > 0) {
+        if (dynamic) {
+            snprintf(usage, sizeof usage, "%zu+dynamic", measured);
+        }
+        else {
+            snprintf(usage, sizeof usage, "%zu", measured);
+        }
+        if (measured > thread->stack_size || dynamic) {
+            WARNING("[WARNING] Stack of thread %s (%zu KByte): the frames of "
+                    "its functions use %s bytes\n",
+                    thread->name, thread->stack_size / KBYTE, usage);
+        }
+    }
+
+    fprintf(report, "%-40s %8zu %10zu %10zu %8zu %8zu %-8s %12s\n",
+            thread->name,
+            config->runtime,
+            functions,
+            parameters,
+            budget,
+            thread->stack_size / KBYTE,
+            origin,
+            usage);
+}
+
+/* External interface: set the stack size of all the threads
+ * and write the stack usage report (called after the preprocessing) */
+void Stack_Analysis(System *s)
+{
+    FILE         *report = NULL;
+    Stack_Config config;
+
+    config.runtime   = get_context()->polyorb_hi_c ? 8 * KBYTE : 2 * KBYTE;
+    config.parameter = 256;
+    config.margin    = 25;
+    config.floor     = get_context()->polyorb_hi_c ? 50 * KBYTE : 5 * KBYTE;
+    config.threads   = Create_Symbol_Table();
+    config.types     = Create_Symbol_Table();
+    for (size_t k = 0; k < LANGUAGES; k++) {
+        config.overhead[k] = language_overheads[k].overhead;
+    }
+
+    Read_Data_View(&config);
+    if (NULL != get_context()->stack_config) {
+        Read_Stack_Config(&config, get_context()->stack_config);
+    }
+    frame_index = Create_Symbol_Table();
+    Read_Stack_Usage(OUTPUT_PATH);
+
+    create_file(OUTPUT_PATH, "stack_usage.txt", &report);
+    assert(NULL != report);
+
+    fprintf(report,
+            "Stack of the threads (bytes, margin %zu%%, stack in KByte)\n"
+            "%-40s %8s %10s %10s %8s %8s %-8s %12s\n",
+            config.margin,
+            "thread", "runtime", "functions", "parameters", "budget",
+            "stack", "origin", "measured");
+
+    FOREACH(fv, FV, s->functions, {
+        if (thread_runtime == fv->runtime_nature && !fv->is_component_type) {
+            Thread_Stack(report, &config, s, fv);
+        }
+    })
+
+    if (frame_count > 0) {
+        fprintf(report, "\nmeasured: sum of the largest frame of each "
+                        "function (gcc -fstack-usage, %zu frames)\n",
+                frame_count);
+    }
+
+    close_file(&report);
+
+    for (size_t k = 0; k < frame_count; k++) {
+        free(frames[k].name);
+    }
+    free(frames);
+    frames = NULL;
+    frame_count = 0;
+    Clear_Symbol_Table(frame_index);
+    frame_index = NULL;
+    Clear_Symbol_Table(config.threads);
+    Clear_Symbol_Table(config.types);
+}
@@ -0,0 +1,170 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Symbol tables: open-addressing hash tables mapping a string to a pointer.
+ * Keys are copied when they are inserted, since the names stored in the
+ * AST may be freed or rebuilt by the preprocessing backend.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "symbol_table.h"
+
+#define INITIAL_SIZE 16
+
+typedef struct {
+    char     *key;
+    void     *value;
+    uint64_t hash;
+} Symbol;
+
+struct t_symbol_table {
+    Symbol   *slots;
+    size_t   size;      /* always a power of two */
+    size_t   count;
+};
+
+/* FNV-1a */
+static uint64_t hash_key(const char *key)
+{
+    uint64_t h = 14695981039346656037ULL;
+    while ('\0' != *key) {
+        h ^= (unsigned char) *key++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Return the slot holding the key, or the empty slot where it should go */
+static Symbol *lookup(Symbol_Table *table, const char *key, uint64_t h)
+{
+    size_t mask = table->size - 1;
+    size_t idx = (size_t) h & mask;
+
+    while (NULL != table->slots[idx].key) {
+        if (table->slots[idx].hash == h && !strcmp(table->slots[idx].key, key))
+            break;
+        idx = (idx + 1) & mask;
+    }
+    return &table->slots[idx];
+}
+
+static void grow(Symbol_Table *table)
+{
+    Symbol *old_slots = table->slots;
+    size_t old_size = table->size;
+    size_t i;
+
+    table->size *= 2;
+    table->slots = calloc(table->size, sizeof(Symbol));
+    assert(NULL != table->slots);
+
+    for (i = 0; i < old_size; i++) {
+        if (NULL != old_slots[i].key) {
+            *lookup(table, old_slots[i].key, old_slots[i].hash) = old_slots[i];
+        }
+    }
+    free(old_slots);
+}
+
+Symbol_Table *Create_Symbol_Table(void)
+{
+    Symbol_Table *table = malloc(sizeof(*table));
+    assert(NULL != table);
+
+    table->size  = INITIAL_SIZE;
+    table->count = 0;
+    table->slots = calloc(table->size, sizeof(Symbol));
+    assert(NULL != table->slots);
+
+    return table;
+}
+
+void Clear_Symbol_Table(Symbol_Table *table)
+{
+    size_t i;
+
+    if (NULL == table)
+        return;
+
+    for (i = 0; i < table->size; i++) {
+        free(table->slots[i].key);
+    }
+    free(table->slots);
+    free(table);
+}
+
+void Empty_Symbol_Table(Symbol_Table *table)
+{
+    size_t i;
+
+    if (NULL == table)
+        return;
+
+    for (i = 0; i < table->size; i++) {
+        free(table->slots[i].key);
+        table->slots[i].key   = NULL;
+        table->slots[i].value = NULL;
+    }
+    table->count = 0;
+}
+
+void *Symbol_Table_Find(Symbol_Table *table, const char *key)
+{
+    if (NULL == table || NULL == key)
+        return NULL;
+
+    return lookup(table, key, hash_key(key))->value;
+}
+
+/* Insert or update - return true if a new key was inserted */
+static bool insert(Symbol_Table *table, const char *key, void *value,
+                   bool replace)
+{
+    uint64_t h;
+    Symbol *slot;
+
+    assert(NULL != table && NULL != key);
+
+    /* Keep the load factor below 1/2 */
+    if (2 * (table->count + 1) > table->size)
+        grow(table);
+
+    h = hash_key(key);
+    slot = lookup(table, key, h);
+
+    if (NULL != slot->key) {
+        if (replace)
+            slot->value = value;
+        return false;
+    }
+
+    slot->key = malloc(strlen(key) + 1);
+    assert(NULL != slot->key);
+    strcpy(slot->key, key);
+    slot->hash  = h;
+    slot->value = value;
+    table->count++;
+
+    return true;
+}
+
+bool Symbol_Table_Add(Symbol_Table *table, const char *key, void *value)
+{
+    return insert(table, key, value, false);
+}
+
+void Symbol_Table_Set(Symbol_Table *table, const char *key, void *value)
+{
+    insert(table, key, value, true);
+}
+
+size_t Symbol_Table_Count(Symbol_Table *table)
+{
+    return NULL == table ? 0 : table->count;
+}
@@ -20,6 +20,7 @@
 #include "my_types.h"
 #include "practical_functions.h"
 #include "c_ast_construction.h"
+#include "tool_jobs.h"
 
 void Process_Directives(FV *fv)
 {
@@ -123,23 +124,6 @@ void Process_Directives(FV *fv)
         mkdir (directive_path, 0700);
         free (directive_path);
 
-        command = make_string ("mono $(which asn1.exe) -c -XER -o %s/%s/directives %s %s",
-                OUTPUT_PATH,
-                fv->name,
-                filename,
-                directives_file);
-
-        ERROR ("[INFO] Executing %s\n", command);
-
-        if (system (command)) {
-            ERROR ("The command failed. Try it yourself"
-                   " (correct paths, access to files, etc.)\n");
-            exit (-1);
-        }
-        else if (!get_context()->test) {
-            unlink (filename);  
-        }
-
         /* Create a C application that will encode the directives using XER */
         char *cpath = make_string ("%s/%s/directives", OUTPUT_PATH, fv->name);
         create_file(cpath, "main.c" , &main_c);
@@ -174,14 +158,21 @@ void Process_Directives(FV *fv)
 
         close_file (&main_c);
 
-        /* Compile and execute the main.c file */
-        free (command);
-        command = NULL;
+        /*
+         * Call asn1.exe with the newly-created ASN.1 file, then compile
+         * and execute the main.c file (run later by Run_Tool_Jobs)
+         */
+        command = make_string ("mono $(which asn1.exe) -c -XER -o %s/%s/directives %s %s"
+                 " && cd %s/%s/directives"
+                 " && gcc *.c -o generate_xml -g && ./generate_xml",
+                OUTPUT_PATH,
+                fv->name,
+                filename,
+                directives_file,
+                OUTPUT_PATH,
+                fv->name);
 
-        command = make_string ("curr=$(pwd) && cd %s/%s/directives \
-                 && gcc *.c -o generate_xml -g && ./generate_xml && cd $(pwd)",
-                 OUTPUT_PATH, fv->name);
-        assert (0 == system (command));
+        Schedule_Tool_Job ("asn1.exe", command, NULL, filename, true);
 
         free (filename);
         free (command);
@@ -0,0 +1,237 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Text builder (see text_builder.h)
+ *
+ * The backends emit code in many small pieces. The builder formats them
+ * directly at the end of a growable buffer (the capacity doubles, so that
+ * the cost of appending is linear in the size of the file), and the file
+ * receives the whole content in one write when it is closed. Most formats
+ * are made of text and %s only: they are copied without vsnprintf. Prototypes
+ * and other strings that are used more than once are built in a builder
+ * that is not attached to a file, instead of being rebuilt with make_string
+ * at each step.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "text_builder.h"
+
+struct t_text_builder {
+    char    *data;          /* always null-terminated */
+    size_t  length;
+    size_t  capacity;
+    int     indent;
+    bool    line_start;     /* next character starts a line */
+    FILE    *file;          /* NULL if not attached to a file */
+};
+
+/* Make room for "more" bytes and the final null character */
+static void Reserve(Text_Builder *text, size_t more)
+{
+    size_t needed = text->length + more + 1;
+
+    if (needed <= text->capacity) return;
+
+    while (text->capacity < needed) {
+        text->capacity *= 2;
+    }
+    text->data = realloc(text->data, text->capacity);
+    assert(NULL != text->data);
+}
+
+Text_Builder *New_Text_Builder(void)
+{
+    Text_Builder *text = calloc(1, sizeof *text);
+
+    assert(NULL != text);
+    text->capacity   = 4096;
+    text->data       = malloc(text->capacity);
+    text->line_start = true;
+    assert(NULL != text->data);
+    text->data[0] = '\0';
+    return text;
+}
+
+Text_Builder *Create_Text_File(char *path, char *filename)
+{
+    FILE         *file = NULL;
+    Text_Builder *text = NULL;
+
+    if (-1 == create_file(path, filename, &file) || NULL == file) {
+        return NULL;
+    }
+    text = New_Text_Builder();
+    text->file = file;
+    return text;
+}
+
+void Free_Text_Builder(Text_Builder **text)
+{
+    if (NULL == *text) return;
+    free((*text)->data);
+    free(*text);
+    *text = NULL;
+}
+
+void Close_Text_File(Text_Builder **text)
+{
+    if (NULL == *text) return;
+    if (NULL != (*text)->file) {
+        fwrite((*text)->data, 1, (*text)->length, (*text)->file);
+        close_file(&(*text)->file);
+    }
+    Free_Text_Builder(text);
+}
+
+/* Copy the formatted text that was just written after the content,
+ * with the indentation at the beginning of the lines */
+static void Indent_Lines(Text_Builder *text, size_t len)
+{
+    char   *copy = malloc(len);
+    size_t lines = 1, k;
+
+    assert(NULL != copy);
+    memcpy(copy, text->data + text->length, len);
+    for (k = 0; k < len; k++) {
+        if ('\n' == copy[k]) lines++;
+    }
+    Reserve(text, len + lines * (size_t) text->indent);
+
+    for (k = 0; k < len; k++) {
+        if (text->line_start && '\n' != copy[k]) {
+            memset(text->data + text->length, ' ', (size_t) text->indent);
+            text->length += (size_t) text->indent;
+        }
+        text->data[text->length++] = copy[k];
+        text->line_start = ('\n' == copy[k]);
+    }
+    text->data[text->length] = '\0';
+    free(copy);
+}
+
+/* True if the only conversions of the format are %s (and %%) */
+static bool Only_Strings(const char *fmt)
+{
+    const char *conv = fmt;
+
+    while (NULL != (conv = strchr(conv, '%'))) {
+        if ('s' != conv[1] && '%' != conv[1]) return false;
+        conv += 2;
+    }
+    return true;
+}
+
+/* Copy "len" bytes after the content (not counted in the length yet) */
+static void Put(Text_Builder *text, size_t *len, const char *s, size_t n)
+{
+    Reserve(text, *len + n);
+    memcpy(text->data + text->length + *len, s, n);
+    *len += n;
+}
+
+/* Format after the content, return the length of the formatted text */
+static size_t Format(Text_Builder *text, const char *fmt, va_list ap)
+{
+    va_list again;
+    size_t  len = 0;
+    int     n;
+
+    if (Only_Strings(fmt)) {
+        while ('\0' != *fmt) {
+            const char *conv = strchr(fmt, '%');
+            const char *arg = NULL;
+
+            if (NULL == conv) {
+                Put(text, &len, fmt, strlen(fmt));
+                break;
+            }
+            Put(text, &len, fmt, (size_t) (conv - fmt));
+            if ('%' == conv[1]) {
+                Put(text, &len, "%", 1);
+            }
+            else {
+                arg = va_arg(ap, const char *);
+                if (NULL == arg) arg = "(null)";
+                Put(text, &len, arg, strlen(arg));
+            }
+            fmt = conv + 2;
+        }
+        text->data[text->length + len] = '\0';
+        return len;
+    }
+
+    va_copy(again, ap);
+    n = vsnprintf(text->data + text->length,
+                  text->capacity - text->length, fmt, ap);
+    assert(n >= 0);
+    len = (size_t) n;
+
+    /* Not enough room: format again in the extended buffer */
+    if (text->length + len >= text->capacity) {
+        Reserve(text, len);
+        vsnprintf(text->data + text->length,
+                  text->capacity - text->length, fmt, again);
+    }
+    va_end(again);
+    return len;
+}
+
+void Text_Printf(Text_Builder *text, const char *fmt, ...)
+{
+    va_list ap;
+    size_t  len;
+
+    va_start(ap, fmt);
+    len = Format(text, fmt, ap);
+    va_end(ap);
+    if (0 == len) return;
+
+    if (text->indent > 0) {
+        Indent_Lines(text, len);
+    }
+    else {
+        text->length += len;
+        text->line_start = ('\n' == text->data[text->length - 1]);
+    }
+}
+
+void Text_Indent(Text_Builder *text, int delta)
+{
+    text->indent += delta;
+    if (text->indent < 0) {
+        text->indent = 0;
+    }
+}
+
+void Text_Separator(Text_Builder *text, bool *started, const char *sep)
+{
+    if (*started) {
+        Text_Printf(text, "%s", sep);
+    }
+    *started = true;
+}
+
+const char *Text_Content(Text_Builder *text)
+{
+    return text->data;
+}
+
+size_t Text_Length(Text_Builder *text)
+{
+    return text->length;
+}
+
+void Text_Clear(Text_Builder *text)
+{
+    text->length     = 0;
+    text->line_start = true;
+    text->data[0]    = '\0';
+}
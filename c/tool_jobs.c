@@ -0,0 +1,378 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Scheduler for the calls to external tools.
+ *
+ * The backends used to call system() on asn2dataModel and asn1.exe once
+ * per function, one after the other, although most of these calls are
+ * identical (same tool, same language, same dataview). Instead they now
+ * schedule jobs, which are run at the end of C_End:
+ *   - identical commands are run only once, in a staging directory, and
+ *     their output is copied in the directory of each requester
+ *   - independent jobs are run in parallel (see option --jobs)
+ *   - failures are reported at the end, with the exit code of each job
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE     /* wait4 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+#include "symbol_table.h"
+#include "tool_jobs.h"
+#include "profile.h"
+
+typedef struct t_tool_job {
+    char                *tool;
+    char                *command;
+    char                *staging;     /* NULL if the job is run in place */
+    String_list         *out_dirs;
+    String_list         *tmp_inputs;
+    bool                fatal;
+    int                 exit_code;
+    pid_t               pid;
+    double              started;      /* for the profile (--profile) */
+    struct t_tool_job   *next;
+} Tool_Job;
+
+static Tool_Job     *jobs = NULL;
+static Tool_Job     *last_job = NULL;
+static Symbol_Table *jobs_by_command = NULL;
+static int          job_count = 0;
+static int          request_count = 0;
+
+void Schedule_Tool_Job(const char *tool,
+                       const char *command,
+                       const char *out_dir,
+                       const char *tmp_input,
+                       bool       fatal)
+{
+    Tool_Job *job = NULL;
+
+    assert (NULL != tool && NULL != command);
+
+    request_count ++;
+
+    if (NULL == jobs_by_command) {
+        jobs_by_command = Create_Symbol_Table();
+    }
+
+    /* Same command, with output in $TASTE_JOB_OUTPUT: reuse the job */
+    if (NULL != out_dir) {
+        job = Symbol_Table_Find (jobs_by_command, command);
+    }
+
+    if (NULL == job) {
+        job = malloc (sizeof (Tool_Job));
+        assert (NULL != job);
+
+        job->tool       = make_string ("%s", tool);
+        job->command    = make_string ("%s", command);
+        job->staging    = NULL;
+        job->out_dirs   = NULL;
+        job->tmp_inputs = NULL;
+        job->fatal      = false;
+        job->exit_code  = 0;
+        job->pid        = 0;
+        job->next       = NULL;
+
+        if (NULL != out_dir) {
+            job->staging = make_string ("%s/.tool_jobs/%d",
+                                        OUTPUT_PATH, job_count);
+            Symbol_Table_Add (jobs_by_command, command, job);
+        }
+
+        if (NULL == jobs) jobs = job;
+        else last_job->next = job;
+        last_job = job;
+        job_count ++;
+    }
+
+    job->fatal = job->fatal || fatal;
+
+    if (NULL != out_dir) {
+        String *dir = make_string ("%s", out_dir);
+        APPEND_TO_LIST (String, job->out_dirs, dir);
+    }
+
+    if (NULL != tmp_input) {
+        String *input = make_string ("%s", tmp_input);
+        APPEND_TO_LIST (String, job->tmp_inputs, input);
+    }
+}
+
+/* The strings are on the heap, the list cells in the AST arena */
+static void free_strings (String_list *list)
+{
+    FOREACH (str, String, list, {
+        free (str);
+    });
+}
+
+/* Copy a file (generated files are small: no need for sendfile) */
+static bool copy_file (const char *src, const char *dst)
+{
+    FILE    *in = NULL, *out = NULL;
+    char    buffer[8192];
+    size_t  len = 0;
+    bool    ok = true;
+
+    in = fopen (src, "rb");
+    if (NULL == in) return false;
+
+    out = fopen (dst, "wb");
+    if (NULL == out) {
+        fclose (in);
+        return false;
+    }
+
+    while (0 < (len = fread (buffer, 1, sizeof buffer, in))) {
+        if (len != fwrite (buffer, 1, len, out)) {
+            ok = false;
+            break;
+        }
+    }
+
+    fclose (in);
+    if (0 != fclose (out)) ok = false;
+
+    return ok;
+}
+
+/* Copy the content of a directory (recursively) into another one */
+static bool copy_tree (const char *src, const char *dst)
+{
+    DIR             *d = NULL;
+    struct dirent   *entry = NULL;
+    struct stat     st;
+    bool            ok = true;
+
+    if (-1 == mkdir (dst, 0700) && EEXIST != errno) return false;
+
+    d = opendir (src);
+    if (NULL == d) return false;
+
+    while (ok && NULL != (entry = readdir (d))) {
+        char *from = NULL, *to = NULL;
+
+        if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, ".."))
+            continue;
+
+        from = make_string ("%s/%s", src, entry->d_name);
+        to   = make_string ("%s/%s", dst, entry->d_name);
+
+        if (0 != stat (from, &st)) ok = false;
+        else if (S_ISDIR (st.st_mode)) ok = copy_tree (from, to);
+        else ok = copy_file (from, to);
+
+        free (from);
+        free (to);
+    }
+    closedir (d);
+
+    return ok;
+}
+
+/* Remove a directory and its content */
+static void remove_tree (const char *path)
+{
+    DIR             *d = NULL;
+    struct dirent   *entry = NULL;
+    struct stat     st;
+
+    d = opendir (path);
+    if (NULL != d) {
+        while (NULL != (entry = readdir (d))) {
+            char *sub = NULL;
+
+            if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, ".."))
+                continue;
+
+            sub = make_string ("%s/%s", path, entry->d_name);
+            if (0 == stat (sub, &st) && S_ISDIR (st.st_mode))
+                remove_tree (sub);
+            else
+                unlink (sub);
+            free (sub);
+        }
+        closedir (d);
+    }
+    rmdir (path);
+}
+
+static void start_job (Tool_Job *job)
+{
+    if (NULL != job->staging) {
+        char *root = make_string ("%s/.tool_jobs", OUTPUT_PATH);
+        mkdir (root, 0700);
+        free (root);
+        remove_tree (job->staging);
+        if (-1 == mkdir (job->staging, 0700)) {
+            ERROR ("[ERROR] Impossible to create directory %s\n",
+                   job->staging);
+            job->exit_code = -1;
+            return;
+        }
+    }
+
+    INFO ("[INFO] Executing %s\n", job->command);
+
+    /* Flush the output buffers, otherwise the child would print them too */
+    fflush (NULL);
+
+    job->started = Profile_Now ();
+    job->pid = fork ();
+
+    if (0 == job->pid) {
+        if (NULL != job->staging) {
+            setenv (TOOL_JOB_OUTPUT, job->staging, 1);
+        }
+        execl ("/bin/sh", "sh", "-c", job->command, (char *) NULL);
+        _exit (127);
+    }
+    else if (-1 == job->pid) {
+        ERROR ("[ERROR] Could not start %s (%s)\n",
+               job->tool, strerror (errno));
+        job->exit_code = -1;
+    }
+}
+
+/* Job completed: dispatch its output to the requesters and clean up */
+static void complete_job (Tool_Job *job, int status)
+{
+    if (WIFEXITED (status))
+        job->exit_code = WEXITSTATUS (status);
+    else if (WIFSIGNALED (status))
+        job->exit_code = 128 + WTERMSIG (status);
+    else
+        job->exit_code = -1;
+
+    if (0 == job->exit_code && NULL != job->staging) {
+        FOREACH (dir, String, job->out_dirs, {
+            if (!copy_tree (job->staging, dir)) {
+                ERROR ("[ERROR] Could not copy the output of %s to %s\n",
+                       job->tool, dir);
+                job->exit_code = -1;
+            }
+        });
+    }
+
+    if (NULL != job->staging) {
+        remove_tree (job->staging);
+    }
+
+    if (0 == job->exit_code && !get_context()->test) {
+        FOREACH (input, String, job->tmp_inputs, {
+            remove (input);
+        });
+    }
+}
+
+void Run_Tool_Jobs(void)
+{
+    int         max_jobs = get_context()->jobs;
+    int         running = 0;
+    int         failures = 0;
+    bool        fatal = false;
+    Tool_Job    *pending = jobs;
+    Tool_Job    *job = NULL;
+
+    if (NULL == jobs) return;
+
+    if (max_jobs < 1) max_jobs = 1;
+
+    while (NULL != pending || running > 0) {
+        /* Start as many jobs as allowed */
+        while (NULL != pending && running < max_jobs) {
+            start_job (pending);
+            if (0 < pending->pid) running ++;
+            pending = pending->next;
+        }
+
+        if (0 == running) continue;
+
+        /* Wait for any job to complete */
+        int           status = 0;
+        struct rusage usage;
+        pid_t         pid = wait4 (-1, &status, 0, &usage);
+
+        if (-1 == pid) {
+            if (EINTR == errno) continue;
+            break;
+        }
+
+        for (job = jobs; NULL != job; job = job->next) {
+            if (job->pid == pid) {
+                Profile_Child (job->tool, NULL, pid, job->started, &usage);
+                complete_job (job, status);
+                job->pid = 0;
+                running --;
+                break;
+            }
+        }
+    }
+
+    if (NULL != jobs_by_command && 0 < Symbol_Table_Count (jobs_by_command)) {
+        char *root = make_string ("%s/.tool_jobs", OUTPUT_PATH);
+        rmdir (root);
+        free (root);
+    }
+
+    if (request_count > job_count) {
+        INFO ("[INFO] %d external tool calls requested, %d executed\n",
+              request_count, job_count);
+    }
+
+    /* Report failures */
+    for (job = jobs; NULL != job; job = job->next) {
+        if (0 != job->exit_code) {
+            if (0 == failures) {
+                ERROR ("[ERROR] The following command(s) failed. Try them "
+                       "yourself (correct paths, access to files, etc.)\n");
+            }
+            failures ++;
+            ERROR ("  - %s (exit code %d%s):\n      %s\n",
+                   job->tool,
+                   job->exit_code,
+                   job->fatal ? "": ", ignored",
+                   job->command);
+            fatal = fatal || job->fatal;
+        }
+    }
+
+    /* Free the jobs - they can't be run twice */
+    while (NULL != jobs) {
+        job = jobs->next;
+        free (jobs->tool);
+        free (jobs->command);
+        free (jobs->staging);
+        free_strings (jobs->out_dirs);
+        free_strings (jobs->tmp_inputs);
+        free (jobs);
+        jobs = job;
+    }
+    last_job = NULL;
+    Clear_Symbol_Table (jobs_by_command);
+    jobs_by_command = NULL;
+    job_count = 0;
+    request_count = 0;
+
+    if (true == fatal) {
+        exit (-1);
+    }
+}
@@ -7,8 +7,6 @@
  * to generate the Ada code of the real-time architecture.
  *
  * 1st version written by Maxime Perrotin/ESA 15/07/2008
- *
- * XXX The computation of priorities must be refactored
  */
 
 
@@ -64,21 +62,9 @@ void write_thread_postamble(FV *fv)
 }
 
 
-/*
-   Find_Highest_Period among all interfaces of a FV
-*/
-void Find_Highest_Period (Interface *i, long long *result)
-{
-   if (i->period > *result) *result = i->period;
-}
-
-
-
 /* Thread implementation contains some properties set in the IF view */
 void write_thread_implementation(FV *fv)
 {
-   long long               highest_period       = 0;
-   long long               priority             = 0;
    uint64_t                wcet_low;
    uint64_t                wcet_high;
    Interface*              tmp_if;
@@ -213,37 +199,11 @@ void write_thread_implementation(FV *fv)
         (unsigned long long) wcet_high);
    }
 
-   bool pohic = (get_context()->polyorb_hi_c);
-   /* Default source stack size per thread */
-   // XXX the -s from the command line is ignored?
-   /* POHI-Ada targets low-resource platforms (eg. STM32) - limit stack */
-   /* This is temporary - this should be an AADL property of the platform */
-   fprintf(thread,"\tStack_Size => %d KByte;\n", pohic ? 50 : 5);
-
-   /* Calculate the priority : temporary solution using the period */
-   FOREACH(i, Interface, fv->interfaces, {
-       Find_Highest_Period(i, &highest_period);
-   })
+   /* Stack size computed from the parameters, see stack_budget.c */
+   fprintf(thread,"\tStack_Size => %zu KByte;\n", fv->stack_size / 1024);
 
-   /*
-    * Higher period => higher priority.
-    * Priority low > priority high (POHIC/Linux)
-    * With Ada, a big number indicates a higher priority
-    */
-   if (highest_period < 100) priority = pohic ? 1 : 10;
-   else if (highest_period >= 100 && highest_period < 250) priority = pohic ? 5 : 6;
-   else if (highest_period >= 250 && highest_period < 500) priority = pohic ? 6 : 5;
-   else if (highest_period >= 500 && highest_period < 750) priority = pohic ? 7 : 4;
-   else if (highest_period >= 750 && highest_period < 1000) priority = pohic ? 8 : 3;
-   else if (highest_period == 1000) priority = pohic ? 9 : 2;
-   else if (highest_period > 1000) priority = pohic ? 10 : 1;
-
-   fprintf(thread,"\tPriority => %lld;\n", priority);
-   /* 
-    MP: To be investigated
-    JH: To be computed from a schedulability analysis of the system,
-        e.g. GRMA using Cheddar
-   */
+   /* Rate-monotonic priority, see schedulability.c */
+   fprintf(thread,"\tPriority => %d;\n", fv->priority);
    fprintf(thread,"END %s_%s.others;\n\n", fv->name, fv->name);
 }
 
@@ -1142,7 +1102,7 @@ void Generate_Full_ConcurrencyView(Process_list *processes, char *root_node)
         */
         fprintf(process, "\n-- %s.final\n", root_node);
 
-        fclose (process);
+        close_file (&process);
     }
     close_file (&nodes);
 }
@@ -0,0 +1,34 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Arena (bump-pointer) allocator used for the nodes and lists of the AST.
+ * Memory is never freed individually: the whole arena is released at once.
+ */
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+typedef struct t_arena Arena;
+
+/* Allocate an empty arena */
+Arena *Create_Arena(void);
+
+/* Release all the memory of an arena (and the arena itself) */
+void Free_Arena(Arena *arena);
+
+/* Allocate size bytes (suitably aligned for any type) */
+void *Arena_Alloc(Arena *arena, size_t size);
+
+/* Call free_fn (data) when the arena is released (for objects that are
+ * allocated outside of the arena but live as long as the AST) */
+void Arena_Defer_Free(Arena *arena, void (*free_fn)(void *), void *data);
+
+/* Start a new phase: statistics are reported per phase */
+void Arena_Phase(Arena *arena, const char *name);
+
+/* Print the number of bytes and allocations of each phase */
+void Arena_Report(Arena *arena);
+
+#endif
@@ -0,0 +1,29 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Cache of the parsed model (option --cache): the C AST built from the
+ * AADL models is saved in a binary file, and loaded by the next run with
+ * the same inputs instead of calling Ocarina
+ */
+#ifndef __AST_CACHE_H__
+#define __AST_CACHE_H__
+
+#include <stddef.h>
+
+/* Set the name of the cache file */
+void Set_Cache_File(char *name, size_t len);
+
+/* Add a command line argument to the key of the cache. If the argument is
+ * the name of a file, its content is part of the key as well */
+void Add_Cache_Input(char *arg, size_t len);
+
+/* Load the model from the cache file if it matches the inputs.
+ * Return 1 if the AST was loaded (the AADL files need not be parsed) */
+int Load_AST_Cache(void);
+
+/* Save the model in the cache file (called by C_End, before the
+ * preprocessing), unless it was loaded from it */
+void Save_AST_Cache(void);
+
+#endif
@@ -48,3 +48,6 @@ extern void  Generate_Full_ConcurrencyView(Process_list *, char *);
 extern void  Process_Driver_Configuration(Process *);
 extern void  Generate_Python_AST(System *, char *);
 extern void  System_Config(System *);
+extern void  Generate_MSC_Trace_Ids(System *);
+extern void  Schedulability_Analysis(System *);
+extern void  Stack_Analysis(System *);
@@ -9,6 +9,11 @@ Parameter *FindInParameter(Interface *i, char *param_name);
 Parameter *FindOutParameter(Interface *i, char *param_name);
 Interface *FindInterface(FV *fv,char *interface_name);
 Interface *FindCorrespondingRI(FV *remote, Interface *pi);
+void Add_Interface_To_FV(FV *function, Interface *i);
+void Index_RI(FV *function, Interface *i);
+void Reindex_RI(FV *function, Interface *i);
+void Connect_RI(Interface *ri);
+void Connect_Pending_RIs(Interface *pi);
 void CompareIFname(Interface *i,Interface **result);
 void CompareFVname(FV *fv_local,FV **result);
 void SetSearchName(char *name);
@@ -29,6 +34,7 @@ void LookForRI(Interface *i, Interface **check);
 FV_list *Find_All_Calling_FV(Interface *i);
 void Add_Binding(char *b, size_t length);
 void Set_Current_Process(Process *p);
+void Set_Current_FV(FV *f);
 void End_Process();
 void New_Drivers_Section();
 void End_Drivers_Section();
@@ -44,6 +50,21 @@ void Set_Interfaceview (char *name, size_t len);
 void Set_Dataview (char *name, size_t len);
 void Set_Test();
 void Set_Timer_Resolution(char *val, size_t len);
+void Set_Timer_Wheel();
+void Set_Jobs(char *val, size_t len);
+void Set_GUI_Period(char *val, size_t len);
+void Set_Stack_Config(char *val, size_t len);
+void Set_Profile();
+void Set_Binary_MSC();
+void Set_Direct_Calls();
+void Set_Thread_Local_Buffers();
+void Set_GUI_Events();
+void Set_GUI_Shm();
+void Set_Fail_Unschedulable();
+void Set_Task_Attributes();
+void Set_Direct_Encode();
+void Set_Check_Only();
+void Set_Incremental();
 void Set_Future();
 void Set_OnlyCV();
 void Set_AADLV2();
@@ -101,6 +122,8 @@ void Set_Zipfile (char *file, size_t len);
 void Set_Root_Node(char *name,size_t len);
 void Set_PolyorbHI_C();
 void Set_Instance_Of(char *component, size_t len);
+void Set_FV_Location(char *location, size_t len);
+void Set_IF_Location(char *location, size_t len);
 void Set_Is_Component_Type();
 System *get_system_ast();
 void Delete_System_AST();
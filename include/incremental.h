@@ -0,0 +1,30 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Incremental generation (option --incremental): the glue code of a
+ * function is only generated if its inputs changed since the last run
+ */
+#ifndef __INCREMENTAL_H__
+#define __INCREMENTAL_H__
+
+#include <stdbool.h>
+
+#include "my_types.h"
+
+/* Compute the fingerprints of the functions and of the system (after the
+ * preprocessing) and read the manifest of the last run */
+void Load_Manifest(System *s);
+
+/* True if the glue code of the function is up to date */
+bool Unchanged_Function(FV *fv);
+
+/* True if the files generated from the whole system (concurrency view,
+ * system_config.h) are up to date */
+bool Unchanged_System(void);
+
+/* Write the manifest once all files are generated. Without the option, an
+ * old manifest is removed (the files no longer match it) */
+void Save_Manifest(void);
+
+#endif
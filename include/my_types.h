@@ -7,6 +7,7 @@
 #ifndef _MY_TYPES_H_
 #define _MY_TYPES_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -15,11 +16,28 @@
 static const char do_not_modify_warning[] =
          "/* This file was generated automatically: DO NOT MODIFY IT ! */\n\n";
 
-/* Macro available to declare chained list in a standard format */
+/*
+ * Bookkeeping of a chained list, allocated once per list and pointed to by
+ * its first element: the last element and the length, so that appending is
+ * done in constant time, and the index of the values when the list is used
+ * as a large set (ADD_TO_SET). The other elements have no header (NULL).
+ */
+typedef struct t_list_header {
+        void *tail;                     /* last element */
+        size_t count;
+        struct t_symbol_table *index;   /* values of a large set */
+        void *indexed;                  /* last element in the index */
+        size_t generation;              /* see Invalidate_Set_Indexes */
+} List_Header;
+
+/*
+ * Macro available to declare chained list in a standard format
+ */
 #define DECLARE_LIST(type) \
 typedef struct t_##type##_list {\
         type *value;\
         struct t_##type##_list *next;\
+        List_Header *hdr;\
 } type##_list;
 
 /* Generic type for a string and a list of strings */
@@ -196,10 +214,14 @@ typedef struct t_interface {
   char                    *distant_fv;
   struct t_qgen           *distant_qgen;
   struct t_FV_list        *calling_threads;
+  uint64_t                *calling_thread_set; // calling_threads by id
   char                    *distant_name;
   unsigned long long      queue_size;
   bool                    ignore_params;
   struct t_Interface_list *calling_pis; // only set in RIs of passive functions
+  struct t_interface      *connected_pi; // RI: PI it is connected to
+  struct t_Interface_list *calling_ris;  // PI: RIs connected to it
+  char                    *location;     // file:line:column in the model
 } Interface;
 
 DECLARE_LIST (Interface)
@@ -222,9 +244,24 @@ typedef struct t_context {
   int   test;
   bool  future;
   char  *stacksize;
+  char  *stack_config;
   int   polyorb_hi_c;
   bool  needs_basictypes;
   int   timer_resolution;
+  bool  timer_wheel;
+  int   jobs;
+  bool  profile;
+  bool  binary_msc;
+  bool  direct_calls;
+  bool  thread_local_buffers;
+  bool  gui_events;
+  int   gui_period;
+  bool  gui_shm;
+  bool  fail_unschedulable;
+  bool  task_attributes;
+  bool  direct_encode;
+  bool  check_only;
+  bool  incremental;
 } Context;
 
 /*
@@ -240,7 +277,10 @@ typedef struct t_fv {
   Interface_list         *interfaces;
   struct t_process       *process;
   struct t_FV_list       *calling_threads;
+  uint64_t               *calling_thread_set; // calling_threads by id
   int                    thread_id;
+  int                    priority;        // set by Schedulability_Analysis
+  size_t                 stack_size;      // bytes, set by Stack_Analysis
   Context_Parameter_list *context_parameters;
   bool                   artificial;
   char                   *original_name;
@@ -248,6 +288,10 @@ typedef struct t_fv {
   struct t_String_list   *timer_list;
   bool                   is_component_type;
   char                   *instance_of;
+  struct t_symbol_table  *interface_index; // interfaces by name
+  struct t_symbol_table  *ri_index;        // RIs by distant fv/name
+  size_t                 position;        // rank in the system functions
+  char                   *location;       // file:line:column in the model
 } FV;
 
 DECLARE_LIST(FV)
@@ -346,6 +390,9 @@ typedef struct t_system
     Bus_list          *buses;
     Package_list      *packages;
     Connection_list   *connections;
+    struct t_symbol_table *fv_index;  // functions by name
+    struct t_symbol_table *pending_ris; // RIs whose PI is not known yet
+    struct t_arena    *arena;         // memory of the AST nodes
 } System;
 
 /*
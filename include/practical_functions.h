@@ -6,6 +6,8 @@
 
 #include "my_types.h"
 #include "c_ast_construction.h"
+#include "symbol_table.h"
+#include "text_builder.h"
 
 #define UNUSED(x) (void)(x)
 
@@ -78,6 +80,36 @@ int file_exists(char *, char *);
 /* Close a file and reset the FILE handler */
 void close_file (FILE **);
 
+/* Close all files created with create_file that are still open */
+void Close_All_Files();
+
+/* Number of files created with create_file that are still open, and close
+ * the ones created after this number was read (in a forked process, only
+ * its own files are written: the files of the parent are its own) */
+size_t Open_Files_Count();
+void Close_Files_Opened_After(size_t count);
+
+/* Number of generated files written or left unchanged so far */
+void Get_Output_Files_Count(int *written, int *unchanged);
+void Add_Output_Files_Count(int written, int unchanged);
+
+/* Number of bytes of the generated files so far */
+size_t Get_Output_Bytes_Count();
+void Add_Output_Bytes_Count(size_t bytes);
+
+/* Print how many generated files were written or left unchanged */
+void Output_Files_Summary();
+
+/* Allocate memory for a node of the AST (freed with the whole AST) */
+void *AST_Alloc(size_t size);
+
+/* Allocate memory for a node of the AST that owns strings: release is
+ * called on the node to free them when the AST is freed */
+void *AST_Alloc_Node(size_t size, void (*release)(void *));
+
+/* Allocate a symbol table that is freed with the whole AST */
+Symbol_Table *AST_Symbol_Table(void);
+
 /* Free memory used by a Parameter type */
 void Clear_Parameter(Parameter *);
 
@@ -105,8 +137,19 @@ void Create_FV (FV **);
 /* Free the memory of an FV structure */
 void Clear_FV(FV *);
 
+/* Allocate memory for a Device, a Connection, a Processor, a Bus or a
+ * Context_Parameter, and free their strings */
+void Create_Device (Device **dev);
 void Clear_Device (Device *dev);
 void Clear_Devices_List(Device_list * p);
+void Create_Connection (Connection **conn);
+void Clear_Connection (Connection *conn);
+void Create_Processor (Processor **cpu);
+void Clear_Processor (Processor *cpu);
+void Create_Bus (Bus **bus);
+void Clear_Bus (Bus *bus);
+void Create_Context_Parameter (Context_Parameter **cp);
+void Clear_Context_Parameter (Context_Parameter *cp);
 
 void Create_APLC_binding(Aplc_binding **a);
 
@@ -153,6 +196,12 @@ String_list *timers(FV *fv);
 /* Return the number of Cyclic and Sporadic interfaces from a list */
 int CountActivePI(Interface_list *interfaces);
 
+/* Return the PI that a sync RI can call directly (option --direct-calls) */
+Interface *Direct_Call_Target(Interface *ri);
+
+/* True if an async RI is encoded in the request (option --direct-encode) */
+bool Direct_Encode(Interface *ri);
+
 /*
   ForEachWithParam function : Write to file the list of parameters in Ada 
  (form IN/OUT_paramName: interface.c.char_array, IN/OUT_paramNamesize: [access] Integer) 
@@ -173,7 +222,7 @@ void List_QGen_Param_Types_And_Names(Parameter *p, FILE **file);
 /*
    ForEachWithParam function : Write to file the list of parameters, separated by commas for QGen
 */
-void List_QGen_Param_Names(Parameter *p, FILE **file, Language lang);
+void List_QGen_Param_Names(Parameter *p, Text_Builder *text, Language lang);
 
 /* Create a string in the form "name.all",
  * as expected by QGencAda for arguments of the comp function*/
@@ -196,14 +245,14 @@ Parameter *Duplicate_Parameter (Parameter *p);
 
 /* Write to file the list of parameters with their type, separated with commas
  * (form "const asn1SccTYPE1 IN_param1, ...") */
-void List_C_Types_And_Params_With_Pointers(Parameter *p, FILE **file);
+void List_C_Types_And_Params_With_Pointers(Parameter *p, Text_Builder *text);
 
 /* ForEachWithParam function : Write to file the list of parameters separated with commas (form "IN_param1, IN_param2, &OUT_param1....") */
 void List_C_Params(Parameter *p, FILE **file);
 
 
 /* ForEachWithParam function : Write to file the list of parameters + size separated with commas (form "IN_param1, size_IN_param1,.., OUT_parami, &size_OUT_parami....") */
-void List_C_Params_And_Size (Parameter *p, FILE **file);
+void List_C_Params_And_Size (Parameter *p, Text_Builder *text);
 
 /* Allocate memory for the system (AST root) */
 void Create_System (System **s);
@@ -238,6 +287,19 @@ int Compare_ASN1_Filename(ASN1_Filename *one, ASN1_Filename *two);
 int Compare_ASN1_Module (ASN1_Module *one, ASN1_Module *two);
 int Compare_ASN1_Type (ASN1_Type *one, ASN1_Type *two);
 int Compare_Port (Port *one, Port *two);
+
+/* Keys used to index large sets (two values have the same key if and
+ * only if the corresponding Compare function returns true) */
+const char *Key_Package (Package *p);
+const char *Key_Protected_Object_Name (Protected_Object_Name *p);
+const char *Key_Interface (Interface *i);
+const char *Key_FV (FV *fv);
+const char *Key_String (String *s);
+const char *Key_ASN1_Filename (ASN1_Filename *f);
+const char *Key_ASN1_Module (ASN1_Module *m);
+const char *Key_ASN1_Type (ASN1_Type *t);
+const char *Key_Port (Port *p);
+
 void Clear_Port (Port ** p);
 void Print_FV (FV *fv);
 
@@ -259,10 +321,16 @@ Example of use:
 #define CREATE_NEW_LIST(type, list) \
 {\
 assert(NULL == list);\
-list=(type##_list *) malloc(sizeof(type##_list));\
+list=(type##_list *) AST_Alloc(sizeof(type##_list));\
 }
 
 
+/*
+ * Append in constant time, using the tail stored in the header of the list.
+ * If the list was extended through another pointer (e.g. a sub-list), the
+ * tail is not the last element anymore: the end is searched from there.
+ * A sub-list that is appended to gets a header of its own.
+ */
 #define APPEND_TO_LIST(type, list, val) \
 {\
 type##_list *newlist=NULL;\
@@ -271,56 +339,113 @@ CREATE_NEW_LIST(type, newlist);\
 assert(NULL!=newlist);\
 newlist->value=val;\
 newlist->next=NULL;\
-if(NULL==list) list = newlist;\
+if(NULL==(list)) {\
+list = newlist;\
+(list)->hdr = (List_Header *) AST_Alloc(sizeof(List_Header));\
+(list)->hdr->tail = newlist;\
+(list)->hdr->count = 1;}\
 else {\
-type##_list *nav=list;\
-while (NULL != nav->next) nav=nav->next;\
-nav->next=newlist; }\
+type##_list *nav = (list);\
+size_t sub_count = 1;\
+if (NULL != (list)->hdr && NULL != (list)->hdr->tail)\
+nav = (type##_list *) (list)->hdr->tail;\
+while (NULL != nav->next) { nav=nav->next; sub_count++; }\
+nav->next=newlist;\
+if (NULL == (list)->hdr) {\
+(list)->hdr = (List_Header *) AST_Alloc(sizeof(List_Header));\
+(list)->hdr->count = sub_count;}\
+(list)->hdr->tail=newlist;\
+(list)->hdr->count++; }\
 }
 
+/* Number of elements of a list (0 for a sub-list that has no header) */
+#define LIST_COUNT(list) \
+((NULL == (list) || NULL == (list)->hdr) ? (size_t) 0 : (list)->hdr->count)
+
+/* Sets with at least this number of elements are indexed by key */
+#define SET_INDEX_THRESHOLD 32
+
+/* The keys of some values (e.g. the distant_name of an interface) can be
+ * rewritten after they were indexed: the code that rewrites them calls
+ * Invalidate_Set_Indexes, and the indexes are then rebuilt when used */
+extern size_t set_index_generation;
+void Invalidate_Set_Indexes(void);
+
+/* Add to the index of a set the values appended since the last update */
+#define UPDATE_SET_INDEX(type, list) \
+{\
+List_Header *hdr_index = (list)->hdr;\
+type##_list *nav_index = NULL;\
+if (NULL == hdr_index->index) hdr_index->index = AST_Symbol_Table();\
+else if (hdr_index->generation != set_index_generation) {\
+Empty_Symbol_Table(hdr_index->index);\
+hdr_index->indexed = NULL;}\
+hdr_index->generation = set_index_generation;\
+nav_index = (NULL == hdr_index->indexed) ?\
+            (list) : ((type##_list *) hdr_index->indexed)->next;\
+while (NULL != nav_index) {\
+Symbol_Table_Add(hdr_index->index, Key_##type(nav_index->value), nav_index->value);\
+hdr_index->indexed = nav_index;\
+nav_index = nav_index->next; }\
+}
 
 /* 
  * ADD_TO_SET : make sure the list contains UNIQUE elements 
- * The user has to provide the Compare_type function
+ * The user has to provide the Compare_type function (and the Key_type
+ * function, consistent with Compare_type, used to index large sets)
  */
 #define ADD_TO_SET(type, list, val) \
 {\
-int result = 0; \
-FOREACH(elem, type, list, {\
-if(Compare_##type(val,elem)) result = 1; \
-});\
-if (!result) APPEND_TO_LIST(type, list, val);\
+if (!IN_SET(type, list, val)) APPEND_TO_LIST(type, list, val);\
 }
 
 /* return true if value of type sort is in set */
 #define IN_SET(sort, set, val) \
 __extension__({\
 bool result = false; \
+sort *found_in_set = NULL; \
+if (LIST_COUNT(set) >= SET_INDEX_THRESHOLD) {\
+UPDATE_SET_INDEX(sort, set);\
+found_in_set = Symbol_Table_Find((set)->hdr->index, Key_##sort(val));\
+}\
+if (NULL != found_in_set && Compare_##sort(val, found_in_set)) result = true;\
+else if (LIST_COUNT(set) < SET_INDEX_THRESHOLD || NULL != found_in_set) {\
 FOREACH(elem, sort, set, {\
 if(Compare_##sort(val,elem)) result = true; \
-});\
+});}\
 result;\
 })
 
+/* Free the values of a list (the list itself is in the AST arena) */
 #define FREE_LIST(type, list) \
 {\
-type##_list *next=NULL;\
 while(NULL != list) {\
-Clear_##type(&(list->value));\
-free(list->value);\
-list->value=NULL;\
-next=list->next;\
-free(list);\
-list=next;}\
+Clear_##type(&((list)->value));\
+free((list)->value);\
+(list)->value=NULL;\
+list=(list)->next;}\
 }
 
+/* Remove the first occurrence of a value, keeping the header up to date */
 #define REMOVE_FROM_LIST(type, list, val) \
 {\
-type##_list *tmp=list;\
-if(list->value==val) list=list->next;\
-else while (NULL != tmp) {\
-if(tmp->next->value==val) {tmp->next=tmp->next->next;break;}\
-tmp=tmp->next;}\
+type##_list *prev_rm=NULL, *cur_rm=(list);\
+List_Header *hdr_rm = NULL;\
+while (NULL != cur_rm && cur_rm->value != val) {\
+prev_rm=cur_rm;\
+cur_rm=cur_rm->next;}\
+if (NULL != cur_rm) {\
+hdr_rm = (list)->hdr;\
+if (NULL == prev_rm) {\
+(list)=cur_rm->next;\
+if (NULL != (list)) (list)->hdr = hdr_rm;}\
+else prev_rm->next=cur_rm->next;\
+if (NULL != hdr_rm && NULL != (list)) {\
+if (hdr_rm->tail == cur_rm) hdr_rm->tail = prev_rm;\
+hdr_rm->count--;\
+if (NULL != hdr_rm->index) {\
+Empty_Symbol_Table(hdr_rm->index);\
+hdr_rm->indexed = NULL;}}}\
 }
 
 #define PRINT_LIST(type, list) \
@@ -0,0 +1,54 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Profiling of the phases of a run (option --profile): wall time, CPU time,
+ * peak RSS, number of generated files and bytes of each phase of C_End and
+ * of each backend called on a function
+ */
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/* Start the clocks (called by C_Init, before the models are parsed) */
+void Profile_Init(void);
+
+/* Open a phase, optionally for a given function (fv_name may be NULL).
+ * Phases can be nested. The strings must live until Profile_Report */
+void Profile_Begin(const char *phase, const char *fv_name);
+
+/* Close the last opened phase */
+void Profile_End(void);
+
+/* Record a phase run by a child process (external tool), from the time
+ * it was started (see Profile_Now) and the resources returned by wait4 */
+void Profile_Child(const char *phase, const char *fv_name, pid_t pid,
+                   double start_us, const struct rusage *usage);
+
+/* Microseconds since Profile_Init */
+double Profile_Now(void);
+
+/* Number of phases recorded so far */
+size_t Profile_Count(void);
+
+/* Send the phases recorded since "first" to the parent process through a
+ * pipe, and read them in the parent (glue code generated with --jobs) */
+void Profile_Send(int fd, size_t first);
+void Profile_Receive(int fd);
+
+/* Print the table of the phases, and write profile.json and
+ * profile_trace.json (Chrome trace events) in the output directory */
+void Profile_Report(void);
+
+/* Call a backend on a function, as a phase of its own */
+#define PROFILE_BACKEND(backend, fv)            \
+    do {                                        \
+        Profile_Begin(#backend, (fv)->name);    \
+        backend(fv);                            \
+        Profile_End();                          \
+    } while (0)
+
+#endif
@@ -0,0 +1,19 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Server mode (buildsupport --server <socket>): Ocarina is initialized
+ * once, and each request of buildsupport-client runs in a child process
+ */
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <stddef.h>
+
+/* Listen on a Unix socket and fork a child for each request.
+ * Return 0 in the child, which continues as a normal run with the command
+ * line, directory and standard input/outputs of the client.
+ * Return -1 if the server could not be started (never returns otherwise) */
+int Server(char *socket_path, size_t len);
+
+#endif
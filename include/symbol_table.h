@@ -0,0 +1,38 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Symbol tables: string-keyed hash index used to speed up the lookups
+ * of functions and interfaces by name in the C AST (FindFV, FindInterface)
+ */
+#ifndef __SYMBOL_TABLE_H__
+#define __SYMBOL_TABLE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct t_symbol_table Symbol_Table;
+
+/* Allocate an empty symbol table */
+Symbol_Table *Create_Symbol_Table(void);
+
+/* Free a symbol table (the indexed values are not freed) */
+void Clear_Symbol_Table(Symbol_Table *table);
+
+/* Return the value associated to a key, or NULL if the key is unknown */
+void *Symbol_Table_Find(Symbol_Table *table, const char *key);
+
+/* Remove all the keys of a table */
+void Empty_Symbol_Table(Symbol_Table *table);
+
+/* Add a key if it is not already present (the first value is kept)
+ * Return true if the key was added */
+bool Symbol_Table_Add(Symbol_Table *table, const char *key, void *value);
+
+/* Add a key or replace the value associated to an existing key */
+void Symbol_Table_Set(Symbol_Table *table, const char *key, void *value);
+
+/* Number of keys in the table */
+size_t Symbol_Table_Count(Symbol_Table *table);
+
+#endif
@@ -0,0 +1,53 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Text builder: growable buffer used by the backends to emit code, with
+ * indentation and separator helpers. The content of a file is written in
+ * one call when it is closed.
+ */
+#ifndef __TEXT_BUILDER_H__
+#define __TEXT_BUILDER_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct t_text_builder Text_Builder;
+
+/* Empty builder, not attached to a file (see Text_Content) */
+Text_Builder *New_Text_Builder(void);
+
+/* Create an output file (as create_file) and the builder that fills it.
+ * Return NULL if the file could not be created */
+Text_Builder *Create_Text_File(char *path, char *filename);
+
+/* Write the content in the file, close it (as close_file) and free the
+ * builder. *text is set to NULL; nothing is done if it is already NULL */
+void Close_Text_File(Text_Builder **text);
+
+/* Free a builder that is not attached to a file */
+void Free_Text_Builder(Text_Builder **text);
+
+/* Append formatted text. Each line starts with the current indentation,
+ * except empty lines */
+void Text_Printf(Text_Builder *text, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/* Change the indentation of the next lines (in spaces) */
+void Text_Indent(Text_Builder *text, int delta);
+
+/* Append a separator before each item of a list but the first one:
+ * *started is false before the first item, and set to true */
+void Text_Separator(Text_Builder *text, bool *started, const char *sep);
+
+/* Content of the builder (null-terminated, owned by the builder) */
+const char *Text_Content(Text_Builder *text);
+
+/* Number of bytes in the builder */
+size_t Text_Length(Text_Builder *text);
+
+/* Empty the builder (the memory is kept for the next content) */
+void Text_Clear(Text_Builder *text);
+
+#endif
@@ -0,0 +1,37 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Scheduler for the calls to external tools (asn2dataModel, asn1.exe)
+ */
+#ifndef __TOOL_JOBS_H__
+#define __TOOL_JOBS_H__
+
+#include <stdbool.h>
+
+/* Name of the environment variable holding the output directory of a job */
+#define TOOL_JOB_OUTPUT "TASTE_JOB_OUTPUT"
+
+/*
+ * Schedule a shell command. Nothing is executed before Run_Tool_Jobs.
+ *   tool       : tool name, used in the final report
+ *   command    : shell command line (copied)
+ *   out_dir    : if not NULL, the command must write its output in
+ *                "$TASTE_JOB_OUTPUT". Identical commands are then run only
+ *                once and their output is copied into each out_dir.
+ *                If NULL, the command is run as it is.
+ *   tmp_input  : if not NULL, file removed once the command succeeded
+ *                (unless buildsupport runs in test mode)
+ *   fatal      : if true, buildsupport exits when the command fails
+ */
+void Schedule_Tool_Job(const char *tool,
+                       const char *command,
+                       const char *out_dir,
+                       const char *tmp_input,
+                       bool       fatal);
+
+/* Run all scheduled jobs (at most get_context()->jobs in parallel),
+ * report the failures and exit if any fatal job failed */
+void Run_Tool_Jobs(void);
+
+#endif
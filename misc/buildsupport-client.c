@@ -0,0 +1,128 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Client of the buildsupport server (buildsupport --server <socket>)
+ *
+ * It takes the same arguments as buildsupport, and sends them to the server
+ * with the current directory, the environment and the standard
+ * input/outputs; the server
+ * runs buildsupport with them in a child process. The exit status is the
+ * one of the run. If BUILDSUPPORT_SERVER is not set, or if the server does
+ * not answer, buildsupport is called directly: scripts can use the client
+ * in all cases.
+ *
+ * Build it with: gcc -O2 buildsupport-client.c -o buildsupport-client
+ * Usage: BUILDSUPPORT_SERVER=<socket> buildsupport-client <arguments>
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static void run_directly(char **argv)
+{
+    argv[0] = "buildsupport";
+    execvp(argv[0], argv);
+    perror(argv[0]);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    const char         *path = getenv("BUILDSUPPORT_SERVER");
+    char               cwd[4096], *request = NULL;
+    char               control[CMSG_SPACE(3 * sizeof(int))];
+    int                fds[3] = { 0, 1, 2 }, sock = -1;
+    int32_t            status = 0;
+    uint32_t           len = 0, count = (uint32_t) (argc - 1);
+    size_t             pos = 0;
+    struct sockaddr_un addr;
+    struct iovec       iov;
+    struct msghdr      msg;
+    struct cmsghdr     *cmsg = NULL;
+
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (NULL == path || strlen(path) >= sizeof addr.sun_path
+        || NULL == getcwd(cwd, sizeof cwd)) {
+        run_directly(argv);
+    }
+    strcpy(addr.sun_path, path);
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || 0 != connect(sock, (struct sockaddr *) &addr,
+                                 sizeof addr)) {
+        run_directly(argv);
+    }
+
+    /* Request: length, number of arguments, then the directory, the
+     * arguments and the environment (null-terminated) */
+    pos = sizeof count + strlen(cwd) + 1;
+    for (int k = 1; k < argc; k++) {
+        pos += strlen(argv[k]) + 1;
+    }
+    for (char **env = environ; NULL != *env; env++) {
+        pos += strlen(*env) + 1;
+    }
+    request = malloc(sizeof len + pos);
+    if (NULL == request) return 1;
+    len = (uint32_t) pos;
+    memcpy(request, &len, sizeof len);
+    pos = sizeof len;
+    memcpy(request + pos, &count, sizeof count);
+    pos += sizeof count;
+    memcpy(request + pos, cwd, strlen(cwd) + 1);
+    pos += strlen(cwd) + 1;
+    for (int k = 1; k < argc; k++) {
+        memcpy(request + pos, argv[k], strlen(argv[k]) + 1);
+        pos += strlen(argv[k]) + 1;
+    }
+    for (char **env = environ; NULL != *env; env++) {
+        memcpy(request + pos, *env, strlen(*env) + 1);
+        pos += strlen(*env) + 1;
+    }
+
+    /* The length goes with the standard input/outputs, then the rest */
+    memset(&msg, 0, sizeof msg);
+    memset(control, 0, sizeof control);
+    iov.iov_base       = request;
+    iov.iov_len        = sizeof len;
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof control;
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof fds);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof fds);
+
+    if (sizeof len != (size_t) sendmsg(sock, &msg, 0)
+        || (ssize_t) (pos - sizeof len)
+           != write(sock, request + sizeof len, pos - sizeof len)) {
+        perror("buildsupport-client");
+        return 1;
+    }
+    free(request);
+
+    /* Wait for the end of the run */
+    for (pos = 0; pos < sizeof status; ) {
+        ssize_t n = read(sock, (char *) &status + pos, sizeof status - pos);
+        if (n < 0 && EINTR == errno) continue;
+        if (n <= 0) {
+            fprintf(stderr, "buildsupport-client: no reply from the server\n");
+            return 1;
+        }
+        pos += (size_t) n;
+    }
+    close(sock);
+    return status;
+}
@@ -0,0 +1,185 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Benchmark of the sending of a sporadic message by a thread, with the
+ * glue of the default mode and of the option --direct-encode.
+ * PolyORB-HI-C is replaced by stubs with the same copies: a request with
+ * one buffer per port, __po_hi_copy_array, and __po_hi_gqueue_store_out
+ * that copies the request in the queue of the port. The stubs count the
+ * bytes that they copy. The encoder writes the message as UPER does.
+ *
+ *   default:  encoder -> static IN_buf -> request (copy_array) -> queue
+ *   direct:   encoder -> request -> queue
+ *
+ * Build it with: gcc -O2 direct-encode-bench.c -o direct-encode-bench
+ * Usage: direct-encode-bench [messages [message size]]  (default 10000000 64)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define MAX_SIZE    1024    /* size of the port buffer (Buffer.impl) */
+#define QUEUE_SIZE  16
+
+/* PolyORB-HI-C stubs */
+
+typedef struct {
+    int port;
+    union {
+        struct {
+            struct {
+                uint8_t buffer[MAX_SIZE];
+                size_t  length;
+            } pinger_global_outport_notify;
+        } pinger_global_outport_notify;
+    } vars;
+} __po_hi_request_t;
+
+static __po_hi_request_t queue[QUEUE_SIZE];
+static unsigned          queue_last;
+static size_t            copied;        /* bytes copied by the stubs */
+
+static void __po_hi_copy_array(void *dst, void *src, size_t size)
+{
+    memcpy(dst, src, size);
+    copied += size;
+}
+
+static void __po_hi_gqueue_store_out(int task, int port,
+                                     __po_hi_request_t *request)
+{
+    (void) task;
+    (void) port;
+    queue_last = (queue_last + 1) % QUEUE_SIZE;
+    memcpy(&queue[queue_last], request, sizeof *request);
+    copied += sizeof *request;
+}
+
+static void __po_hi_send_output(int task, int port)
+{
+    (void) task;
+    (void) port;
+}
+
+/* Encoder of a message of "size" bytes (a big-endian counter) */
+static size_t encode(void *buffer, size_t capacity, uint32_t value,
+                     size_t size)
+{
+    uint8_t *out = buffer;
+
+    if (size > capacity) return (size_t) -1;
+    memset(out, 0, size);
+    for (size_t k = 0; k < 4 && k < size; k++) {
+        out[size - 1 - k] = (uint8_t) (value >> (8 * k));
+    }
+    return size;
+}
+
+/* Default glue: invoke_ri.c and vm_async_pinger_notify */
+
+static void vm_async_pinger_notify(void *v, size_t v_len)
+{
+    __po_hi_request_t request;
+
+    __po_hi_copy_array(&(request.vars.pinger_global_outport_notify.
+                         pinger_global_outport_notify.buffer), v, v_len);
+    request.vars.pinger_global_outport_notify
+           .pinger_global_outport_notify.length = v_len;
+    request.port = 1;
+    __po_hi_gqueue_store_out(0, 1, &request);
+    __po_hi_send_output(0, 1);
+}
+
+static void pinger_RI_notify(uint32_t value, size_t size)
+{
+    static char IN_buf_v[MAX_SIZE] = {0};
+    size_t size_IN_buf_v = encode(IN_buf_v, sizeof IN_buf_v, value, size);
+
+    if ((size_t) -1 == size_IN_buf_v) abort();
+    vm_async_pinger_notify(IN_buf_v, size_IN_buf_v);
+}
+
+/* Glue of the option --direct-encode */
+
+static __po_hi_request_t request_notify;
+
+static void *vm_async_pinger_notify_buffer(size_t *size)
+{
+    *size = sizeof(request_notify.vars.pinger_global_outport_notify
+                   .pinger_global_outport_notify.buffer);
+    return &(request_notify.vars.pinger_global_outport_notify
+             .pinger_global_outport_notify.buffer);
+}
+
+static void vm_async_pinger_notify_send(size_t length)
+{
+    request_notify.vars.pinger_global_outport_notify
+                  .pinger_global_outport_notify.length = length;
+    request_notify.port = 1;
+    __po_hi_gqueue_store_out(0, 1, &request_notify);
+    __po_hi_send_output(0, 1);
+}
+
+static void pinger_RI_notify_direct(uint32_t value, size_t size)
+{
+    size_t capacity_IN_buf_v = 0;
+    char *IN_buf_v = vm_async_pinger_notify_buffer(&capacity_IN_buf_v);
+    size_t size_IN_buf_v = encode(IN_buf_v, capacity_IN_buf_v, value, size);
+
+    if ((size_t) -1 == size_IN_buf_v) abort();
+    vm_async_pinger_notify_send(size_IN_buf_v);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void bench(const char *name, void (*send)(uint32_t, size_t),
+                  long count, size_t size)
+{
+    double start;
+
+    copied = 0;
+    start = now_s();
+    for (long i = 0; i < count; i++) {
+        send((uint32_t) i, size);
+    }
+    start = now_s() - start;
+    printf("%-8s %10ld messages in %7.3f s: %7.1f ns/message, "
+           "%6zu bytes copied/message, %zu bytes of static buffers\n",
+           name, count, start, start * 1e9 / (double) count,
+           copied / (size_t) count,
+           send == pinger_RI_notify ? (size_t) MAX_SIZE : (size_t) 0);
+}
+
+int main(int argc, char **argv)
+{
+    long   count = argc > 1 ? atol(argv[1]) : 10000000;
+    size_t size  = argc > 2 ? (size_t) atol(argv[2]) : 64;
+
+    if (count <= 0 || 0 == size || size > MAX_SIZE) {
+        fprintf(stderr, "Usage: %s [messages [message size (max %d)]]\n",
+                argv[0], MAX_SIZE);
+        return 1;
+    }
+    printf("Request: %zu bytes, message: %zu bytes\n",
+           sizeof(__po_hi_request_t), size);
+    bench("default", pinger_RI_notify, count, size);
+    bench("direct", pinger_RI_notify_direct, count, size);
+
+    /* The queue is the only output: check that it holds the last message */
+    if (queue[queue_last].vars.pinger_global_outport_notify
+            .pinger_global_outport_notify.length != size) {
+        fprintf(stderr, "Wrong message in the queue\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Benchmark of the transports of the GUI messages: POSIX message queue
+ * (default glue) against the shared-memory rings of the option --gui-shm.
+ * A child process receives the messages that its parent sends, as the GUI
+ * does with the telemetry of the functions.
+ *
+ * Build it with the header generated in the directory of a GUI function:
+ *   gcc -O2 -I <output>/<gui function> gui-shm-bench.c -o gui-shm-bench -lrt
+ * Usage: gui-shm-bench [messages [message size]]  (default 1000000 64)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <mqueue.h>
+#include <sys/wait.h>
+
+#include "gui_shm_ring.h"
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, long count, double seconds)
+{
+    printf("%-8s %10ld messages in %7.3f s: %12.0f messages/s, "
+           "%7.1f ns/message\n",
+           name, count, seconds, (double) count / seconds,
+           seconds * 1e9 / (double) count);
+}
+
+static void bench_mqueue(long count, size_t size)
+{
+    char           name[64], *msg = calloc(1, size);
+    struct mq_attr attr;
+    mqd_t          queue;
+    double         start;
+    long           i;
+    pid_t          pid;
+
+    snprintf(name, sizeof name, "/%d_gui_shm_bench_mq", (int) getpid());
+    memset(&attr, 0, sizeof attr);
+    attr.mq_maxmsg  = 10;           /* default limit of msg_max */
+    attr.mq_msgsize = (long) size;
+    queue = mq_open(name, O_CREAT | O_RDWR, 0600, &attr);
+    if ((mqd_t) -1 == queue) {
+        perror("mq_open");
+        exit(1);
+    }
+
+    start = now_s();
+    pid = fork();
+    if (0 == pid) {
+        for (i = 0; i < count; i++) {
+            if (-1 == mq_receive(queue, msg, size, NULL)) {
+                perror("mq_receive");
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    for (i = 0; i < count; i++) {
+        memcpy(msg, &i, sizeof i);
+        mq_send(queue, msg, size, 0);
+    }
+    waitpid(pid, NULL, 0);
+    report("mqueue", count, now_s() - start);
+
+    mq_close(queue);
+    mq_unlink(name);
+    free(msg);
+}
+
+static void bench_shm(long count, size_t size)
+{
+    char           name[64], *msg = calloc(1, size);
+    gui_shm_region *region = NULL;
+    double         start;
+    long           i, errors = 0;
+    pid_t          pid;
+    int            id = 0;
+
+    snprintf(name, sizeof name, "/%d_gui_shm_bench", (int) getpid());
+    region = gui_shm_open(name, 1, size, size);
+    if (NULL == region) {
+        perror("gui_shm_open");
+        exit(1);
+    }
+
+    start = now_s();
+    pid = fork();
+    if (0 == pid) {
+        for (i = 0; i < count; i++) {
+            long value;
+            while (0 != gui_shm_pop(region, GUI_SHM_PI, &id, msg, size)) {
+                gui_shm_wait(region, GUI_SHM_PI, 100);
+            }
+            memcpy(&value, msg, sizeof value);
+            if (value != i || id != (int) (i & 0xff)) errors++;
+        }
+        _exit(0 == errors ? 0 : 1);
+    }
+    for (i = 0; i < count; i++) {
+        memcpy(msg, &i, sizeof i);
+        while (0 != gui_shm_push(region, GUI_SHM_PI, (int) (i & 0xff),
+                                 msg, size)) {
+            sched_yield();
+        }
+    }
+    waitpid(pid, &id, 0);
+    report("shm ring", count, now_s() - start);
+    if (!WIFEXITED(id) || 0 != WEXITSTATUS(id)) {
+        printf("[ERROR] The messages were not received in order\n");
+    }
+
+    shm_unlink(name);
+    free(msg);
+}
+
+int main(int argc, char *argv[])
+{
+    long   count = argc > 1 ? atol(argv[1]) : 1000000;
+    size_t size  = argc > 2 ? (size_t) atol(argv[2]) : 64;
+
+    if (count < 1 || size < sizeof(long)) {
+        fprintf(stderr, "Usage: %s [messages [message size]]\n", argv[0]);
+        return 1;
+    }
+    printf("%ld messages of %zu bytes\n", count, size);
+    bench_mqueue(count, size);
+    bench_shm(count, size);
+    return 0;
+}
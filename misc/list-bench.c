@@ -0,0 +1,108 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Benchmark of the lists of the C AST (DECLARE_LIST): appending to a list
+ * (APPEND_TO_LIST, constant time with the tail of the list header) and
+ * building a set (ADD_TO_SET, indexed by key above SET_INDEX_THRESHOLD
+ * elements), then looking the values up (IN_SET). It also prints the size
+ * of an element and of the header of a list.
+ *
+ * Build it from the root of buildsupport with the C sources of the tool:
+ *   gcc -O2 -Iinclude misc/list-bench.c \
+ *       $(ls c/[a-z]*.c | grep -v ros_bridge) -o list-bench -lpthread
+ * Usage: list-bench [elements]  (default 10000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+
+/* Normally set by the Ada binder, used by the server mode of the tool */
+int gnat_argc;
+char **gnat_argv;
+
+/* The ROS bridge is not built with the C sources of the tool */
+void GLUE_ROS_Bridge_Backend(FV *fv)
+{
+    (void) fv;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, long count, double seconds)
+{
+    printf("%-10s %8ld operations in %8.3f ms: %8.1f ns/operation\n",
+           name, count, seconds * 1e3, seconds * 1e9 / (double) count);
+}
+
+int main(int argc, char *argv[])
+{
+    long        count = argc > 1 ? atol(argv[1]) : 10000;
+    String      **values = NULL;
+    String_list *list = NULL, *set = NULL;
+    double      start;
+    long        i, found = 0;
+
+    if (count < 1) {
+        fprintf(stderr, "Usage: %s [elements]\n", argv[0]);
+        return 1;
+    }
+
+    /* The lists are allocated in the arena of the AST */
+    C_Init();
+
+    values = malloc((size_t) count * sizeof(String *));
+    assert(NULL != values);
+    for (i = 0; i < count; i++) {
+        values[i] = make_string("value_%ld", i);
+    }
+
+    printf("%ld elements, %zu bytes per element, %zu bytes per list header\n",
+           count, sizeof(String_list), sizeof(List_Header));
+
+    start = now_s();
+    for (i = 0; i < count; i++) {
+        APPEND_TO_LIST(String, list, values[i]);
+    }
+    report("append", count, now_s() - start);
+
+    /* Each value is added twice: the second time it is found in the set */
+    start = now_s();
+    for (i = 0; i < 2 * count; i++) {
+        ADD_TO_SET(String, set, values[i % count]);
+    }
+    report("add to set", 2 * count, now_s() - start);
+
+    start = now_s();
+    for (i = 0; i < count; i++) {
+        if (IN_SET(String, set, values[count - 1 - i])) found++;
+    }
+    report("in set", count, now_s() - start);
+
+    if (LIST_COUNT(list) != (size_t) count || LIST_COUNT(set) != (size_t) count
+        || found != count) {
+        printf("[ERROR] %zu elements in the list, %zu in the set, "
+               "%ld found\n", LIST_COUNT(list), LIST_COUNT(set), found);
+        return 1;
+    }
+
+    for (i = 0; i < count; i++) {
+        free(values[i]);
+    }
+    free(values);
+    Delete_System_AST();
+    return 0;
+}
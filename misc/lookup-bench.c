@@ -0,0 +1,163 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Benchmark of the lookups in the C AST (FindFV, FindInterface and
+ * FindCorrespondingRI), which the backends call for each interface and
+ * connection of the model.
+ * The model is built through the C AST API: functions with a number of
+ * PIs, each function calling all the PIs of the next one through its RIs.
+ * Every function, interface and corresponding RI is looked up, a number
+ * of times (rounds), and the time per lookup is printed.
+ *
+ * Build it from the root of buildsupport with the C sources of the tool:
+ *   gcc -O2 -Iinclude misc/lookup-bench.c \
+ *       $(ls c/[a-z]*.c | grep -v ros_bridge) -o lookup-bench -lpthread
+ * Usage: lookup-bench [functions] [PIs per function] [rounds]
+ *        (default 600 functions, 8 PIs, 20 rounds)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+
+/* Normally set by the Ada binder, used by the server mode of the tool */
+int gnat_argc;
+char **gnat_argv;
+
+/* The ROS bridge is not built with the C sources of the tool */
+void GLUE_ROS_Bridge_Backend(FV *fv)
+{
+    (void) fv;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, long count, double seconds)
+{
+    printf("%-20s %9ld lookups in %9.3f ms: %8.1f ns/lookup\n",
+           name, count, seconds * 1e3, seconds * 1e9 / (double) count);
+}
+
+int main(int argc, char *argv[])
+{
+    int    functions = argc > 1 ? atoi(argv[1]) : 600;
+    int    pis = argc > 2 ? atoi(argv[2]) : 8;
+    int    rounds = argc > 3 ? atoi(argv[3]) : 20;
+    char   name[64], next[64], if_name[64], pi_name[64];
+    char   **fv_names = NULL, **pi_names = NULL;
+    FV     **fvs = NULL;
+    long   found = 0, expected = 0, lookups = 0;
+    double start;
+    int    f, p, r;
+
+    if (functions < 2 || pis < 1 || rounds < 1) {
+        fprintf(stderr, "Usage: %s [functions] [PIs per function] [rounds]\n",
+                argv[0]);
+        return 1;
+    }
+
+    C_Init();
+
+    for (f = 0; f < functions; f++) {
+        snprintf(name, sizeof(name), "function_%d", f);
+        snprintf(next, sizeof(next), "function_%d", (f + 1) % functions);
+        New_FV(name, strlen(name), name);
+        Set_Language_To_C();
+        for (p = 0; p < pis; p++) {
+            snprintf(if_name, sizeof(if_name), "provided_%d", p);
+            Add_PI(if_name, strlen(if_name));
+            Set_Protected_IF();
+            End_IF();
+        }
+        for (p = 0; p < pis; p++) {
+            snprintf(if_name, sizeof(if_name), "required_%d", p);
+            snprintf(pi_name, sizeof(pi_name), "provided_%d", p);
+            Add_RI(if_name, strlen(if_name), next, strlen(next),
+                   pi_name, strlen(pi_name));
+            Set_Protected_IF();
+            End_IF();
+        }
+        End_FV();
+    }
+
+    printf("%d functions, %d PIs and %d RIs per function, %d rounds\n",
+           functions, pis, pis, rounds);
+
+    /* The names are prepared before, to time only the lookups */
+    fv_names = malloc((size_t) functions * sizeof(char *));
+    fvs = malloc((size_t) functions * sizeof(FV *));
+    pi_names = malloc((size_t) pis * sizeof(char *));
+    if (NULL == fv_names || NULL == fvs || NULL == pi_names) return 1;
+    for (f = 0; f < functions; f++) {
+        fv_names[f] = make_string("function_%d", f);
+        fvs[f] = FindFV(fv_names[f]);
+    }
+    for (p = 0; p < pis; p++) {
+        pi_names[p] = make_string("provided_%d", p);
+    }
+
+    start = now_s();
+    for (r = 0; r < rounds; r++) {
+        for (f = 0; f < functions; f++) {
+            if (NULL != FindFV(fv_names[f])) found++;
+        }
+    }
+    lookups = (long) rounds * functions;
+    report("FindFV", lookups, now_s() - start);
+    expected += lookups;
+
+    start = now_s();
+    for (r = 0; r < rounds; r++) {
+        for (f = 0; f < functions; f++) {
+            for (p = 0; p < pis; p++) {
+                if (NULL != FindInterface(fvs[f], pi_names[p])) found++;
+            }
+        }
+    }
+    lookups = (long) rounds * functions * pis;
+    report("FindInterface", lookups, now_s() - start);
+    expected += lookups;
+
+    start = now_s();
+    for (r = 0; r < rounds; r++) {
+        for (f = 0; f < functions; f++) {
+            FV *callee = fvs[(f + 1) % functions];
+            for (p = 0; p < pis; p++) {
+                Interface *pi = FindInterface(callee, pi_names[p]);
+                if (NULL != FindCorrespondingRI(fvs[f], pi)) found++;
+            }
+        }
+    }
+    report("FindCorrespondingRI", lookups, now_s() - start);
+    expected += lookups;
+
+    if (found != expected) {
+        printf("[ERROR] %ld lookups out of %ld found the element\n",
+               found, expected);
+        return 1;
+    }
+
+    for (f = 0; f < functions; f++) {
+        free(fv_names[f]);
+    }
+    for (p = 0; p < pis; p++) {
+        free(pi_names[p]);
+    }
+    free(fv_names);
+    free(fvs);
+    free(pi_names);
+    Delete_System_AST();
+    return 0;
+}
@@ -0,0 +1,153 @@
+/* Buildsupport is (c) 2008-2016 European Space Agency
+ * contact: maxime.perrotin@esa.int
+ * License is LGPL, check LICENSE file */
+/*
+ * Stress test of the propagation of the calling threads through passive
+ * functions (Propagate_Calling_Thread, in the preprocessing backend).
+ * The model is built through the C AST API: a chain of protected functions
+ * (level_0 calls level_1, which calls level_2, etc.) and cyclic functions
+ * that all call the first level of the chain. Each thread is propagated
+ * down to the last level.
+ *
+ * The program prints the time spent in the preprocessing backend and a
+ * checksum of the calling threads (in order) of each function and PI, to
+ * compare the result of two versions of buildsupport.
+ *
+ * Build it from the root of buildsupport with the C sources of the tool:
+ *   gcc -O2 -Iinclude misc/propagation-bench.c \
+ *       $(ls c/[a-z]*.c | grep -v ros_bridge) -o propagation-bench -lpthread
+ * Usage: propagation-bench [levels] [threads]  (default 50 levels, 200
+ * threads)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "my_types.h"
+#include "practical_functions.h"
+#include "c_ast_construction.h"
+#include "backends.h"
+
+/* Normally set by the Ada binder, used by the server mode of the tool */
+int gnat_argc;
+char **gnat_argv;
+
+/* The ROS bridge is not built with the C sources of the tool */
+void GLUE_ROS_Bridge_Backend(FV *fv)
+{
+    (void) fv;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/* FNV-1a hash of the names of a list of calling threads */
+static unsigned long hash_threads(unsigned long hash, FV_list *threads)
+{
+    FOREACH(thread, FV, threads, {
+        const char *name = thread->name;
+        for (; '\0' != *name; name++) {
+            hash = (hash ^ (unsigned char) *name) * 1099511628211UL;
+        }
+        hash = (hash ^ '/') * 1099511628211UL;
+    });
+    return hash;
+}
+
+int main(int argc, char *argv[])
+{
+    int           levels = argc > 1 ? atoi(argv[1]) : 50;
+    int           threads = argc > 2 ? atoi(argv[2]) : 200;
+    char          name[64], next[64];
+    unsigned long hash = 14695981039346656037UL;
+    size_t        reached = 0;
+    double        start;
+    int           l, t;
+
+    if (levels < 1 || threads < 1) {
+        fprintf(stderr, "Usage: %s [levels] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    C_Init();
+
+    for (l = 0; l < levels; l++) {
+        snprintf(name, sizeof(name), "level_%d", l);
+        New_FV(name, strlen(name), name);
+        Set_Language_To_C();
+        Add_PI("call", strlen("call"));
+        Set_Protected_IF();
+        End_IF();
+        if (l + 1 < levels) {
+            snprintf(next, sizeof(next), "level_%d", l + 1);
+            Add_RI("call", strlen("call"), next, strlen(next),
+                   "call", strlen("call"));
+            Set_Protected_IF();
+            End_IF();
+        }
+        End_FV();
+    }
+
+    for (t = 0; t < threads; t++) {
+        snprintf(name, sizeof(name), "thread_%d", t);
+        New_FV(name, strlen(name), name);
+        Set_Language_To_C();
+        Add_PI("trigger", strlen("trigger"));
+        Set_Cyclic_IF();
+        Set_Period(1000);
+        End_IF();
+        Add_RI("call", strlen("call"), "level_0", strlen("level_0"),
+               "call", strlen("call"));
+        Set_Protected_IF();
+        End_IF();
+        End_FV();
+    }
+
+    /* All the functions are in one partition */
+    New_Processor("x86_linux", strlen("x86_linux"),
+                  "ocarina_processors_x86::x86.linux",
+                  strlen("ocarina_processors_x86::x86.linux"),
+                  "PLATFORM_NATIVE", strlen("PLATFORM_NATIVE"),
+                  "", 0, "", 0, "", 0);
+    New_Process("partition", strlen("partition"),
+                "partition", strlen("partition"), "node", strlen("node"),
+                false);
+    New_Drivers_Section();
+    FOREACH(fv, FV, get_system_ast()->functions, {
+        Add_Binding(fv->name, strlen(fv->name));
+    });
+    End_Drivers_Section();
+
+    start = now_s();
+    Preprocessing_Backend(get_system_ast());
+    printf("%d levels, %d threads: preprocessing in %.3f s\n",
+           levels, threads, now_s() - start);
+
+    FOREACH(fv, FV, get_system_ast()->functions, {
+        hash = hash_threads(hash, fv->calling_threads);
+        FOREACH(i, Interface, fv->interfaces, {
+            if (PI == i->direction) {
+                hash = hash_threads(hash, i->calling_threads);
+            }
+        });
+        if (0 == strncmp(fv->name, "level_", strlen("level_"))) {
+            FOREACH(thread, FV, fv->calling_threads, {
+                (void) thread;
+                reached++;
+            });
+        }
+    });
+    printf("%zu calling threads of the chain (expected %zu), "
+           "checksum %016lx\n",
+           reached, (size_t) levels * (size_t) threads, hash);
+
+    Delete_System_AST();
+    return reached == (size_t) levels * (size_t) threads ? 0 : 1;
+}
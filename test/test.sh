@@ -1,2 +1,8 @@
 ../buildsupport -glue  -i test1/interfaceview.aadl -c test1/deploymentview.aadl -d test1/dataview.aadl ocarina_components.aadl TASTE_DV_Properties.aadl
 ../buildsupport -gw  -i test2/InterfaceView.aadl -d test2/DataView.aadl TASTE_IV_Properties.aadl
+
+# Glue code generated in parallel (--jobs) must be identical to a serial run
+rm -rf serial parallel
+../buildsupport -glue -o serial -i test1/interfaceview.aadl -c test1/deploymentview.aadl -d test1/dataview.aadl ocarina_components.aadl TASTE_DV_Properties.aadl
+../buildsupport -glue --jobs 4 -o parallel -i test1/interfaceview.aadl -c test1/deploymentview.aadl -d test1/dataview.aadl ocarina_components.aadl TASTE_DV_Properties.aadl
+diff -r serial parallel && echo "Parallel and serial glue code are identical"